@@ -0,0 +1,89 @@
+#ifndef APP_CONFIG_H
+#define APP_CONFIG_H
+
+#include "clip_recorder.h"
+#include "detector.h"
+#include "frame_log.h"
+#include "metrics.h"
+#include "pipeline.h"
+#include "thread_layout.h"
+#include <string>
+#include <vector>
+
+// Runtime configuration shared by the GUI and command-line tools
+struct AppConfig {
+    DetectorConfig detector;
+    PipelineOptions pipeline;
+    FrameLogOptions log;
+    ClipOptions clips;
+    MetricsOptions metrics;
+    ThreadingOptions threading;
+    std::vector<int> autostart_cameras;  // started as soon as the model is ready
+    std::vector<std::string> sources;    // listed instead of cameras 0-7 (see openFrameSource)
+};
+
+// Applies environment variables, then command-line options, on top of the
+// defaults already in config. Returns false with a message on bad input.
+//   --backend=opencv|onnxruntime     DETECTOR_BACKEND
+//   --model=PATH                     YOLO_MODEL_PATH
+//   --precision=fp32|fp16|int8       MODEL_PRECISION
+//   --model-cache=DIR|off            MODEL_CACHE_DIR
+//   --warmup=N                       DETECTOR_WARMUP
+//   --confidence=F                   DETECTOR_CONFIDENCE
+//   --no-letterbox
+//   --nms=greedy|soft                NMS
+//   --nms-iou=F                      NMS_IOU
+//   --nms-top-k=N                    NMS_TOP_K
+//   --nms-class-aware=on|off         NMS_CLASS_AWARE
+//   --queue-policy=POLICY            FRAME_QUEUE_POLICY
+//   --queue-capacity=N               FRAME_QUEUE_CAPACITY
+//   --inference-workers=N            INFERENCE_WORKERS
+//   --max-batch=N                    MAX_BATCH
+//   --batch-timeout-ms=T             BATCH_TIMEOUT_MS
+//   --motion-gate=on|off             MOTION_GATE
+//   --motion-threshold=P             MOTION_THRESHOLD
+//   --motion-refresh=N               MOTION_REFRESH
+//   --tracking=on|off                TRACKING
+//   --track-max-interval=N           TRACK_MAX_INTERVAL
+//   --capture-size=WxH               CAPTURE_SIZE
+//   --sources=SPEC[,SPEC...]         SOURCES
+//   --replay=realtime|max            REPLAY_PACING
+//   --replay-loop=on|off             REPLAY_LOOP
+//   --tiling=on|off                  TILING
+//   --tile-overlap=F                 TILE_OVERLAP
+//   --tile-regions=X,Y,W,H[;...]     TILE_REGIONS
+//   --tile-workers=N                 TILE_WORKERS
+//   --log-capacity=N                 LOG_CAPACITY
+//   --log-spill=overwrite|disk       LOG_SPILL
+//   --log-dir=DIR                    LOG_DIR
+//   --log-rotate-mb=N                LOG_ROTATE_MB
+//   --log-keep-files=N               LOG_KEEP_FILES
+//   --log-flush-ms=T                 LOG_FLUSH_MS
+//   --clips=on|off                   CLIPS
+//   --clip-pre-roll=S                CLIP_PRE_ROLL
+//   --clip-post-roll=S               CLIP_POST_ROLL
+//   --clip-memory-mb=N               CLIP_MEMORY_MB
+//   --clip-quality=Q                 CLIP_QUALITY
+//   --clip-dir=DIR                   CLIP_DIR
+//   --metrics-port=N                 METRICS_PORT
+//   --metrics-address=ADDR           METRICS_ADDRESS
+//   --autostart=I[,I...]             AUTOSTART_CAMERAS
+//   --ort-intra-threads=N            ORT_INTRA_THREADS
+//   --ort-inter-threads=N            ORT_INTER_THREADS
+//   --ort-spinning=on|off            ORT_SPINNING
+//   --opencv-threads=N               OPENCV_THREADS
+//   --affinity=auto|off              THREAD_AFFINITY
+//   --numa-node=N|auto               NUMA_NODE
+//   --gui-cpus=LIST                  GUI_CPUS
+//   --capture-cpus=LIST              CAPTURE_CPUS
+//   --inference-cpus=LIST            INFERENCE_CPUS
+bool parseAppConfig(const std::vector<std::string>& args, AppConfig& config, std::string& error);
+
+// Plans config.threading against this machine's CPUs and copies the result
+// into the detector, pipeline and clip options; the GUI pins itself to gui_cpus
+ThreadLayout applyThreadLayout(AppConfig& config);
+
+// Help text for the options above
+std::string appConfigUsage();
+
+#endif // APP_CONFIG_H
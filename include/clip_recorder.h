@@ -0,0 +1,91 @@
+#ifndef CLIP_RECORDER_H
+#define CLIP_RECORDER_H
+
+#include <opencv2/opencv.hpp>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct ClipOptions {
+    bool enabled = false;
+    double pre_roll_s = 5.0;          // kept before the first frame with a person
+    double post_roll_s = 10.0;        // kept after the last one
+    size_t memory_bytes = 64u << 20;  // compressed frames of all cameras together
+    int jpeg_quality = 80;
+    std::string dir = "clips";
+    std::vector<int> cpus;            // encoder and writer threads pinned here, empty = unpinned
+};
+
+// Saves a clip whenever a camera's person count goes from 0 to more than 0,
+// starting pre_roll_s before the event and ending post_roll_s after the last
+// frame with a person in it. Clips are MJPEG AVI files named
+// clip_cam<index>_<date>_<time>_<ms>.avi after the event time.
+//
+// Every frame pushed is JPEG-compressed on the recorder's encoder thread into
+// a fixed byte ring per camera (memory_bytes split evenly), so the pre-roll is
+// already compressed when an event starts and memory does not grow with
+// resolution or clip length. A separate writer thread copies the clip's
+// frames out of the ring and appends them to the file. push() never waits:
+// a frame arriving while the encoder is still busy replaces the one it has
+// not taken yet, and once a ring is full of frames the writer has not saved,
+// new frames are dropped instead of blocking.
+class ClipRecorder {
+public:
+    struct Stats {
+        uint64_t encoded = 0;  // frames compressed into the ring
+        uint64_t skipped = 0;  // replaced before the encoder took them
+        uint64_t dropped = 0;  // no room: the ring held unsaved clip frames
+        uint64_t clips = 0;    // clips finished
+        size_t ring_bytes = 0;  // compressed frames held now
+    };
+
+    explicit ClipRecorder(const ClipOptions& options);
+    ~ClipRecorder();
+
+    // Register streams before start(); stream ids are 0..n-1 in order,
+    // camera_index names the files
+    void addStream(int camera_index);
+    bool start();
+    // Saves the frames of open clips recorded so far and closes them
+    void stop();
+
+    // From the inference workers, at most one thread per stream at a time.
+    // Takes a reference to frame, not a copy.
+    void push(int stream_id, const cv::Mat& frame, int person_count,
+              std::chrono::steady_clock::time_point capture_time);
+
+    Stats stats(int stream_id) const;
+    // Clip files finished since start(), oldest first
+    std::vector<std::string> clips() const;
+
+private:
+    struct ClipFile;
+    struct Stream;
+
+    void encodeLoop();
+    void writeLoop();
+    void append(Stream& stream, const std::vector<uint8_t>& jpeg, const cv::Size& size,
+                std::chrono::steady_clock::time_point time, int person_count);
+    bool hasWork() const;
+
+    ClipOptions options;
+    std::vector<std::unique_ptr<Stream>> streams;
+    std::vector<std::string> finished;
+
+    std::thread encoder;
+    std::thread writer;
+    mutable std::mutex mutex;
+    std::condition_variable frames_ready;
+    std::condition_variable clip_ready;
+    bool running;
+    bool encoder_stopping;
+    bool writer_stopping;
+};
+
+#endif // CLIP_RECORDER_H
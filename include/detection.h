@@ -0,0 +1,13 @@
+#ifndef DETECTION_H
+#define DETECTION_H
+
+// Detection shared by every detector backend
+struct Detection {
+    float x, y;              // top-left corner in frame pixels
+    float width, height;
+    float confidence;
+    int class_id;            // COCO class, 0 = person
+    int track_id = -1;       // persistent person id when tracking, else -1
+};
+
+#endif // DETECTION_H
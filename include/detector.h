@@ -0,0 +1,94 @@
+#ifndef DETECTOR_H
+#define DETECTOR_H
+
+#include <opencv2/opencv.hpp>
+#include "detection.h"
+#include "nms.h"
+#include "tiling.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// ONNX Runtime threads. With intra_threads set, all sessions in the process
+// share one global pool, created with the first detector's settings, so
+// workers never multiply the thread count; 0 = a pool per session.
+struct OrtThreading {
+    int intra_threads = 0;
+    int inter_threads = 0;
+    bool spinning = true;        // ORT's default
+    std::vector<int> intra_cpus; // pool threads pinned round-robin, empty = unpinned
+};
+
+struct DetectorConfig {
+    std::string backend = "opencv";  // "opencv" or "onnxruntime"
+    std::string model_path;          // empty = probe the default locations
+    std::string precision = "fp32";  // default model variant: fp32, fp16 or int8
+    std::string model_cache_dir = "model_cache";  // optimized graphs kept across restarts; empty = off
+    int warmup_runs = 2;             // blank forward passes before the first real frame
+    float confidence_threshold = 0.5f;
+    NmsOptions nms;                  // IoU threshold, top-k, class-aware or Soft-NMS
+    bool person_only = true;
+    bool letterbox = true;
+    int max_batch = 1;               // frames per forward pass, if the model allows
+    TilingOptions tiling;            // detect on overlapping full-resolution tiles
+    OrtThreading threads;            // onnxruntime backend only
+};
+
+// Stage timings of the last detect() call, in microseconds
+struct DetectTimings {
+    uint64_t preprocess_us = 0;
+    uint64_t forward_us = 0;
+    uint64_t decode_us = 0;
+    uint64_t nms_us = 0;
+};
+
+// Common interface of the YOLO backends. An instance is used by one
+// thread at a time; create one per worker thread.
+class Detector {
+public:
+    virtual ~Detector() = default;
+
+    virtual std::vector<Detection> detect(const cv::Mat& frame) = 0;
+    virtual bool isInitialized() const = 0;
+    virtual std::string name() const = 0;
+
+    // Detects in all frames using as few forward passes as the model allows;
+    // results gets one list per frame. timings then cover the whole call.
+    // The default runs detect() per frame.
+    virtual void detectBatch(const std::vector<cv::Mat>& frames,
+                             std::vector<std::vector<Detection>>& results);
+    // Most frames a single forward pass accepts
+    virtual int maxBatchSize() const { return 1; }
+
+    const DetectTimings& lastTimings() const { return timings; }
+
+protected:
+    DetectTimings timings;
+};
+
+// Person count used everywhere a frame is logged (GUI, batch, replay)
+int countPersons(const std::vector<Detection>& detections, float min_confidence = 0.5f);
+
+// Backends compiled into this build, e.g. {"opencv", "onnxruntime"}
+std::vector<std::string> availableBackends();
+
+// "onnxruntime" or its short form "ort"
+bool isOnnxRuntimeBackend(const std::string& backend);
+
+// Returns nullptr for an unknown or unavailable backend. The returned
+// detector may still be uninitialized if the model failed to load. With
+// tiling enabled the backend is wrapped in a TiledDetector. A loaded
+// detector has already run config.warmup_runs warm-up passes.
+std::unique_ptr<Detector> createDetector(const DetectorConfig& config);
+
+// Runs runs full-batch forward passes on blank frames, so the first real
+// frames do not pay for lazy allocations and kernel selection
+void warmUpDetector(Detector& detector, int runs);
+
+// config.model_path if it exists, else the first of yolov8s.onnx and
+// models/yolov8s.onnx in the working directory (yolov8s-fp16.onnx or
+// yolov8s-int8.onnx for the other precisions); empty if none exists
+std::string resolveModelPath(const DetectorConfig& config);
+
+#endif // DETECTOR_H
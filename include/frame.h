@@ -3,25 +3,22 @@
 
 #include <wx/wx.h>
 #include <opencv2/opencv.hpp>
-#include <opencv2/dnn.hpp>
+#include "app_config.h"
+#include "clip_recorder.h"
+#include "detector.h"
+#include "frame_log.h"
+#include "frame_log_store.h"
+#include "pipeline.h"
+#include "video_panel.h"
 #include <memory>
 #include <chrono>
+#include <mutex>
+#include <thread>
 #include <vector>
 
-struct FrameLog {
-    wxString timestamp;
-    int frame_number;
-    int person_count;
-};
-
-struct Detection {
-    float x, y, width, height;
-    float confidence;
-};
-
 class MyFrame : public wxFrame {
 public:
-    MyFrame(const wxString& title);
+    MyFrame(const wxString& title, const AppConfig& config);
     ~MyFrame();
 
 private:
@@ -29,41 +26,90 @@ private:
     void OnQuit(wxCommandEvent& event);
     void OnStartCamera(wxCommandEvent& event);
     void OnStopCamera(wxCommandEvent& event);
-    void OnTimer(wxTimerEvent& event);
     void OnExportLog(wxCommandEvent& event);
     void OnClearLog(wxCommandEvent& event);
+    void OnPipelineResult(ProcessedFrame&& processed);
+    void OnPipelineError(int stream_id, const std::string& message);
+    void StopStreaming();
     void UpdateFrame();
-    wxBitmap MatToBitmap(const cv::Mat& mat);
+    void CreateVideoTiles();
     wxString GetCurrentTimestamp();
-    void LogFrame(int frame_num, int person_count);
     void UpdateLogDisplay();
+    bool HasFrameLogs() const;
     void ExportLogToFile(const wxString& filename);
-    std::vector<Detection> DetectObjects(const cv::Mat& frame);
-    void InitializeYOLO();
+    wxString CameraFileName(const wxString& filename, size_t view) const;
+    wxString FormatCameraStats(size_t view) const;
+    void LoadDetectorAsync();
+    void OnDetectorLoaded(std::unique_ptr<Detector> detector, double load_ms);
+    void ReportFirstDetection();
+    
+    // One tile, frame log and set of counters per streaming camera
+    struct CameraView {
+        int camera_index = 0;
+        VideoPanel* tile = nullptr;
+        int frame_count = 0;
+        int person_count = 0;
+        int unique_persons = -1;
+        float fps = 0.0f;
+    };
+    
+    // Frame log of one camera: inference workers append without locking,
+    // the GUI formats the newest entries, the log writer saves them all
+    struct CameraLog {
+        explicit CameraLog(size_t capacity) : ring(capacity) {}
+        FrameLogRing ring;
+        uint64_t shown = 0;     // ring end when the log view was last refreshed
+        int64_t cleared_ns = INT64_MIN;  // exports start here after Clear Log
+    };
+    
+    // Latest result of one camera waiting for the GUI
+    struct PendingResult {
+        ProcessedFrame frame;
+        bool ready = false;
+    };
     
     wxTextCtrl* m_textCtrl;
     wxTextCtrl* m_logCtrl;
-    wxStaticBitmap* m_imageCtrl;
+    wxPanel* m_videoPanel;
     wxButton* m_startBtn;
     wxButton* m_stopBtn;
     wxButton* m_clickBtn;
     wxButton* m_quitBtn;
     wxButton* m_exportBtn;
     wxButton* m_clearBtn;
-    wxComboBox* m_cameraChoice;
+    wxCheckListBox* m_cameraList;
     
-    cv::VideoCapture m_cap;
-    wxTimer m_timer;
+    AppConfig m_config;
+    std::unique_ptr<FramePipeline> m_pipeline;
     bool m_camera_running;
-    int m_frame_count;
-    int m_fps_counter;
-    std::vector<FrameLog> m_frame_logs;
+    std::vector<CameraView> m_views;  // indexed by pipeline stream id
+    std::vector<std::unique_ptr<CameraLog>> m_logs;  // same; fixed while streaming
+    std::unique_ptr<FrameLogWriter> m_log_writer;    // with --log-spill=disk, while streaming
+    std::unique_ptr<ClipRecorder> m_clip_recorder;   // with --clips=on; set under m_result_mutex
     std::chrono::high_resolution_clock::time_point m_start_time;
-    std::chrono::high_resolution_clock::time_point m_fps_time;
+
+    // Scraped from the metrics thread; the server only exists with --metrics-port
+    PipelineMetrics m_metrics;
+    std::unique_ptr<MetricsServer> m_metrics_server;
+
+    // Handoff from the inference workers to the GUI stage
+    std::mutex m_result_mutex;
+    std::vector<PendingResult> m_pending;
+    bool m_update_posted;
     
-    // YOLO detection with OpenCV DNN
-    cv::dnn::Net m_net;
+    // Detector loaded in the background at startup; handed to the first
+    // inference worker, the others load their own. Start Camera waits for it.
+    std::mutex m_detector_mutex;
+    std::unique_ptr<Detector> m_detector;
     bool m_yolo_initialized;
+    bool m_model_loading;
+    std::thread m_model_thread;
+    
+    // Cold start timing: launch -> model ready -> first detection
+    std::chrono::steady_clock::time_point m_launch_time;
+    std::chrono::steady_clock::time_point m_stream_start_time;
+    double m_model_ready_ms;        // since launch, -1 while loading
+    double m_first_detection_ms;    // since Start Camera, -1 until one arrives
 };
 
 #endif // FRAME_H
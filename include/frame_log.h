@@ -0,0 +1,97 @@
+#ifndef FRAME_LOG_H
+#define FRAME_LOG_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// One logged frame. Plain data, formatted only when shown or exported.
+struct FrameLog {
+    int64_t timestamp_ns = 0;     // wall clock since the epoch, or media position (batch tool)
+    int32_t frame_number = 0;
+    int32_t person_count = 0;
+    int32_t unique_persons = -1;  // tracked persons so far; -1 (empty column) without tracking
+    int32_t latency_us = -1;      // capture to detection result; -1 (empty column) if unknown
+};
+static_assert(std::is_trivially_copyable<FrameLog>::value && sizeof(FrameLog) % 8 == 0,
+              "FrameLog is stored as 64-bit words");
+
+// What happens to the oldest entries once a ring is full
+enum class LogSpill {
+    Overwrite,  // dropped; memory stays bounded and nothing touches the disk
+    Disk,       // already on disk: a background writer appends every entry to rotating files
+};
+
+struct FrameLogOptions {
+    size_t capacity = 65536;             // entries per camera, rounded up to a power of two
+    LogSpill spill = LogSpill::Disk;
+    std::string dir = "logs";
+    size_t rotate_bytes = 64u << 20;     // start a new file past this size
+    int keep_files = 0;                  // per camera, older files are deleted; 0 = keep all
+    int flush_ms = 1000;                 // how often the writer appends new entries
+};
+
+// Fixed-capacity ring of frame logs. push() is wait-free and safe from any
+// number of threads; it overwrites the oldest entry when the ring is full.
+// Readers copy entries out by sequence number at the same time; each slot
+// carries the sequence it holds, so entries overwritten during a read are
+// reported as lost instead of coming back torn.
+class FrameLogRing {
+public:
+    explicit FrameLogRing(size_t capacity);
+
+    void push(const FrameLog& log);
+
+    // Appends entries [from, end()) to out, oldest first, stopping at the
+    // first entry still being written or after max_count entries. Returns
+    // the sequence to continue from. Entries already overwritten are
+    // skipped and added to *lost.
+    uint64_t read(uint64_t from, std::vector<FrameLog>& out, size_t max_count = SIZE_MAX,
+                  uint64_t* lost = nullptr) const;
+
+    // Sequence of the oldest entry still kept, and one past the newest
+    uint64_t begin() const;
+    uint64_t end() const { return head.load(std::memory_order_acquire); }
+    size_t size() const { return (size_t)(end() - begin()); }
+    size_t capacity() const { return mask + 1; }
+
+    // Forgets everything logged so far; concurrent pushes are kept
+    void clear() { base.store(end(), std::memory_order_release); }
+
+private:
+    static constexpr size_t kWords = sizeof(FrameLog) / sizeof(uint64_t);
+
+    struct Slot {
+        std::atomic<uint64_t> sequence{0};  // entry sequence + 1, kBusy while written
+        std::atomic<uint64_t> words[kWords];
+    };
+
+    std::unique_ptr<Slot[]> slots;
+    size_t mask = 0;
+    std::atomic<uint64_t> head{0};
+    std::atomic<uint64_t> base{0};
+};
+
+enum class LogClock {
+    Wall,   // timestamp_ns is wall-clock time: "YYYY-MM-DD HH:MM:SS.mmm"
+    Media,  // timestamp_ns is a media position: "HH:MM:SS.mmm"
+};
+
+// Formats the timestamp of a log entry
+std::string formatLogTime(const FrameLog& log, LogClock clock = LogClock::Wall);
+
+// Writes the Timestamp,Frame_Number,Person_Count,Unique_Persons,Latency_ms CSV used by Export Log
+void writeFrameLogCsvHeader(std::ostream& out);
+void writeFrameLogCsvRow(std::ostream& out, const FrameLog& log, LogClock clock = LogClock::Wall);
+void writeFrameLogCsv(std::ostream& out, const std::vector<FrameLog>& logs,
+                      LogClock clock = LogClock::Wall);
+
+// Formats a media position as "HH:MM:SS.mmm"
+std::string formatMediaTime(double milliseconds);
+
+#endif // FRAME_LOG_H
@@ -0,0 +1,135 @@
+#ifndef FRAME_LOG_STORE_H
+#define FRAME_LOG_STORE_H
+
+#include "frame_log.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// On-disk frame log, one file per camera and rotation:
+//   file header   "FRAMELOG", version, camera index, creation time (32 bytes)
+//   blocks        header (count, min/max timestamp) followed by one column
+//                 per FrameLog field: timestamp_ns[count], frame_number[count],
+//                 person_count[count], unique_persons[count], latency_us[count]
+// Every block is 8-byte aligned and holds whatever was logged since the
+// previous flush. Values are in host byte order. A block cut short by a
+// crash is ignored when the file is read back.
+struct FrameLogFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t header_bytes;
+    int32_t camera_index;
+    uint32_t reserved;
+    int64_t created_ns;
+};
+
+struct FrameLogBlockHeader {
+    uint32_t magic;
+    uint32_t count;
+    int64_t min_timestamp_ns;
+    int64_t max_timestamp_ns;
+};
+
+// Appends the entries of frame log rings to rotating files on its own
+// thread, so neither the pipeline nor the GUI ever waits for the disk.
+// Each flush interval it copies whatever is new out of every ring and
+// writes it as one block per camera.
+class FrameLogWriter {
+public:
+    explicit FrameLogWriter(const FrameLogOptions& options);
+    ~FrameLogWriter();
+
+    // Register rings before start(); they must outlive the writer's thread
+    void addSource(int camera_index, const FrameLogRing& ring);
+    bool start();
+    // Writes everything still pending and joins the thread
+    void stop();
+    // Blocks until every entry pushed before the call is written
+    void flush();
+
+    // Files written for a camera since start(), oldest first; rotated-out
+    // files beyond keep_files are gone
+    std::vector<std::string> files(int camera_index) const;
+    // Entries overwritten in a ring before the writer got to them
+    uint64_t lost() const { return lost_count.load(std::memory_order_relaxed); }
+
+private:
+    struct Source {
+        int camera_index = 0;
+        const FrameLogRing* ring = nullptr;
+        uint64_t cursor = 0;
+        std::FILE* file = nullptr;
+        size_t file_bytes = 0;
+        std::vector<std::string> paths;
+    };
+
+    void run();
+    void writePending(Source& source);
+    bool openFile(Source& source);
+    void closeFile(Source& source);
+
+    FrameLogOptions options;
+    std::vector<Source> sources;
+    std::vector<FrameLog> entries;
+    std::vector<char> block;
+    std::atomic<uint64_t> lost_count{0};
+
+    std::thread thread;
+    mutable std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable flushed;
+    bool running = false;
+    bool stopping = false;
+    uint64_t flush_requested = 0;
+    uint64_t flush_done = 0;
+};
+
+// Read-only view of one frame log file, memory-mapped. Opening only walks
+// the block headers; a range query skips every block whose timestamps lie
+// outside the range and scans just the timestamp column of the others.
+class FrameLogFile {
+public:
+    FrameLogFile() = default;
+    ~FrameLogFile();
+    FrameLogFile(const FrameLogFile&) = delete;
+    FrameLogFile& operator=(const FrameLogFile&) = delete;
+
+    bool open(const std::string& path, std::string& error);
+    void close();
+
+    int cameraIndex() const { return header.camera_index; }
+    int64_t createdNs() const { return header.created_ns; }
+    size_t size() const { return record_count; }
+
+    // Appends the records with from_ns <= timestamp_ns < to_ns in file order
+    size_t query(int64_t from_ns, int64_t to_ns, std::vector<FrameLog>& out) const;
+    size_t readAll(std::vector<FrameLog>& out) const { return query(INT64_MIN, INT64_MAX, out); }
+
+private:
+    struct Block {
+        const char* columns = nullptr;
+        uint32_t count = 0;
+        int64_t min_timestamp_ns = 0;
+        int64_t max_timestamp_ns = 0;
+    };
+
+    FrameLogFileHeader header{};
+    const char* data = nullptr;
+    size_t length = 0;
+    std::vector<char> buffer;  // file contents where mmap is unavailable
+    std::vector<Block> blocks;
+    size_t record_count = 0;
+};
+
+// Converts frame log files to the Export Log CSV, keeping records in
+// [from_ns, to_ns). Returns false with a message if a file cannot be read.
+bool convertFrameLogsToCsv(const std::vector<std::string>& paths, std::ostream& out,
+                           std::string& error, int64_t from_ns = INT64_MIN,
+                           int64_t to_ns = INT64_MAX);
+
+#endif // FRAME_LOG_STORE_H
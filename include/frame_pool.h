@@ -0,0 +1,27 @@
+#ifndef FRAME_POOL_H
+#define FRAME_POOL_H
+
+#include <opencv2/opencv.hpp>
+#include <cstddef>
+#include <vector>
+
+// Recycles frame buffers between the capture thread and whoever holds a
+// frame last: the inference worker, the GUI or the video panel. A buffer is
+// free again once no other cv::Mat shares it, so nothing is handed back
+// explicitly. acquire() is for one thread; the holders may be any thread.
+class FramePool {
+public:
+    explicit FramePool(size_t max_buffers = 8) : max_buffers(max_buffers) {}
+
+    // A buffer of this size and type that nobody else references. Beyond
+    // max_buffers in use, frames are allocated outside the pool.
+    cv::Mat acquire(const cv::Size& size, int type);
+
+    size_t size() const { return buffers.size(); }
+
+private:
+    std::vector<cv::Mat> buffers;
+    size_t max_buffers;
+};
+
+#endif // FRAME_POOL_H
@@ -0,0 +1,226 @@
+#ifndef FRAME_QUEUE_H
+#define FRAME_QUEUE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+
+// What push() does when the queue is full
+enum class QueuePolicy {
+    DropOldest,  // evict the oldest queued frame to make room
+    KeepLatest,  // evict everything queued; the consumer always sees the newest frame
+    Block        // wait for the consumer (no drops, latency grows instead)
+};
+
+inline const char* queuePolicyName(QueuePolicy policy) {
+    switch (policy) {
+        case QueuePolicy::DropOldest: return "drop-oldest";
+        case QueuePolicy::KeepLatest: return "keep-latest";
+        case QueuePolicy::Block: return "block";
+    }
+    return "unknown";
+}
+
+inline bool parseQueuePolicy(const std::string& name, QueuePolicy& policy) {
+    if (name == "drop-oldest") {
+        policy = QueuePolicy::DropOldest;
+    } else if (name == "keep-latest") {
+        policy = QueuePolicy::KeepLatest;
+    } else if (name == "block") {
+        policy = QueuePolicy::Block;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// Bounded lock-free frame queue (Vyukov sequence-per-cell ring).
+// Safe for any number of producers and consumers; the pipeline uses it as
+// SPSC between capture and detection. Evictions are done by the producer
+// popping the oldest cell itself, so no cell is ever written while read.
+template <typename T>
+class FrameQueue {
+public:
+    FrameQueue(size_t capacity, QueuePolicy policy)
+        : policy(policy), capacity(capacity < 1 ? 1 : capacity), closed(false),
+          pushed(0), dropped(0), popped(0) {
+        // The ring needs a power of two of at least two cells
+        size_t cell_count = 2;
+        while (cell_count < this->capacity) {
+            cell_count <<= 1;
+        }
+        mask = cell_count - 1;
+        cells.reset(new Cell[cell_count]);
+        for (size_t i = 0; i < cell_count; ++i) {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+        enqueue_pos.store(0, std::memory_order_relaxed);
+        dequeue_pos.store(0, std::memory_order_relaxed);
+    }
+
+    FrameQueue(const FrameQueue&) = delete;
+    FrameQueue& operator=(const FrameQueue&) = delete;
+
+    // Returns false if the frame was not queued (queue closed while blocking)
+    bool push(T&& item) {
+        pushed.fetch_add(1, std::memory_order_relaxed);
+
+        int spins = 0;
+        if (policy == QueuePolicy::KeepLatest) {
+            evict(size());
+        } else if (policy == QueuePolicy::DropOldest && size() >= capacity) {
+            evict(size() - capacity + 1);
+        } else if (policy == QueuePolicy::Block) {
+            // The ring can have more cells than capacity, so a free cell is
+            // not enough; wait until the queue is below capacity
+            while (size() >= capacity) {
+                if (closed.load(std::memory_order_acquire)) {
+                    return false;
+                }
+                backoff(spins);
+            }
+        }
+
+        while (!tryEnqueue(item)) {
+            if (policy != QueuePolicy::Block) {
+                // Raced with another producer; make room again
+                evict(1);
+                continue;
+            }
+            if (closed.load(std::memory_order_acquire)) {
+                return false;
+            }
+            backoff(spins);
+        }
+        return true;
+    }
+
+    bool tryPop(T& item) {
+        if (!tryDequeue(item)) {
+            return false;
+        }
+        popped.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Waits for a frame; returns false once the queue is closed and drained
+    bool waitPop(T& item) {
+        int spins = 0;
+        while (!tryPop(item)) {
+            if (closed.load(std::memory_order_acquire)) {
+                return tryPop(item);
+            }
+            backoff(spins);
+        }
+        return true;
+    }
+
+    // Wakes blocked producers/consumers; they return false from then on
+    void close() { closed.store(true, std::memory_order_release); }
+
+    // Reopens a closed queue and discards anything left in it
+    void reset() {
+        T discarded;
+        while (tryDequeue(discarded)) {
+        }
+        pushed.store(0, std::memory_order_relaxed);
+        dropped.store(0, std::memory_order_relaxed);
+        popped.store(0, std::memory_order_relaxed);
+        closed.store(false, std::memory_order_release);
+    }
+
+    size_t size() const {
+        size_t tail = enqueue_pos.load(std::memory_order_acquire);
+        size_t head = dequeue_pos.load(std::memory_order_acquire);
+        return tail > head ? tail - head : 0;
+    }
+
+    size_t getCapacity() const { return capacity; }
+    QueuePolicy getPolicy() const { return policy; }
+    uint64_t pushedCount() const { return pushed.load(std::memory_order_relaxed); }
+    uint64_t droppedCount() const { return dropped.load(std::memory_order_relaxed); }
+    uint64_t poppedCount() const { return popped.load(std::memory_order_relaxed); }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T data;
+    };
+
+    bool tryEnqueue(T& item) {
+        size_t pos = enqueue_pos.load(std::memory_order_relaxed);
+        while (true) {
+            Cell& cell = cells[pos & mask];
+            size_t seq = cell.sequence.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+            if (diff == 0) {
+                if (enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    cell.data = std::move(item);
+                    cell.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;  // full
+            } else {
+                pos = enqueue_pos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool tryDequeue(T& item) {
+        size_t pos = dequeue_pos.load(std::memory_order_relaxed);
+        while (true) {
+            Cell& cell = cells[pos & mask];
+            size_t seq = cell.sequence.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+            if (diff == 0) {
+                if (dequeue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    item = std::move(cell.data);
+                    cell.data = T();
+                    cell.sequence.store(pos + mask + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;  // empty
+            } else {
+                pos = dequeue_pos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    void evict(size_t count) {
+        T discarded;
+        for (size_t i = 0; i < count && tryDequeue(discarded); ++i) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    // Spin briefly, then yield, then sleep so an idle stage costs no CPU
+    static void backoff(int& spins) {
+        if (spins < 64) {
+            ++spins;
+        } else if (spins < 128) {
+            ++spins;
+            std::this_thread::yield();
+        } else {
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+    }
+
+    QueuePolicy policy;
+    size_t capacity;
+    size_t mask;
+    std::unique_ptr<Cell[]> cells;
+    alignas(64) std::atomic<size_t> enqueue_pos;
+    alignas(64) std::atomic<size_t> dequeue_pos;
+    std::atomic<bool> closed;
+    std::atomic<uint64_t> pushed;
+    std::atomic<uint64_t> dropped;
+    std::atomic<uint64_t> popped;
+};
+
+#endif // FRAME_QUEUE_H
@@ -0,0 +1,83 @@
+#ifndef FRAME_SOURCE_H
+#define FRAME_SOURCE_H
+
+#include <opencv2/opencv.hpp>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+
+// How recorded sources hand out frames: at their own frame rate, or as
+// fast as the consumer reads them
+enum class Pacing { Realtime, Max };
+
+bool parsePacing(const std::string& name, Pacing& pacing);
+const char* pacingName(Pacing pacing);
+
+struct FrameTime {
+    std::chrono::steady_clock::time_point capture;  // when the source produced the frame
+    double media_ms = 0.0;  // position in the recording; since the first frame for cameras
+};
+
+struct FrameSourceOptions {
+    cv::Size size = cv::Size(640, 480);  // requested from cameras, generated by synthetic
+    double fps = 30.0;                   // cameras, synthetic and image sequences
+    Pacing pacing = Pacing::Realtime;    // recorded sources only
+    bool loop = false;                   // restart recorded sources at their end
+};
+
+// Frames for one capture thread
+class FrameSource {
+public:
+    virtual ~FrameSource() = default;
+
+    // Next frame; false at the end or on an error. Raw files hand out views
+    // of their mapping: valid while the source lives, and writes to them
+    // stay private.
+    virtual bool read(cv::Mat& frame, FrameTime& time) = 0;
+    // Advances one frame without decoding it and without pacing
+    virtual bool skip();
+    // True once a recorded source ran out, as opposed to failing
+    virtual bool atEnd() const { return false; }
+    virtual std::string describe() const = 0;
+};
+
+// spec is one of
+//   0, /dev/video0          camera (V4L2 or whatever OpenCV picks)
+//   synthetic[:WxH[@FPS]]   moving boxes on a gradient, never ends
+//   clip.raw                raw frame file, memory-mapped (RawFrameWriter)
+//   frames/, frames/%04d.png   image directory or numbered sequence
+//   clip.mp4                anything else OpenCV can decode
+// Returns nullptr with a message if it cannot be opened.
+std::unique_ptr<FrameSource> openFrameSource(const std::string& spec, const FrameSourceOptions& options,
+                                             std::string& error);
+
+// Raw frame file: a 64-byte header ("WXRAWFRM", version, width, height,
+// cv type, record size), then one record per frame: the media time in
+// nanoseconds, padding, and the pixels at offset 64, each record padded
+// to 64 bytes so every frame starts cache-line aligned in the mapping.
+// The frame count follows from the file size, so a file cut short by a
+// crash still replays up to its last whole frame.
+class RawFrameWriter {
+public:
+    RawFrameWriter();
+    ~RawFrameWriter();
+
+    // Every frame written must have this size and type
+    bool open(const std::string& path, const cv::Size& size, int type, std::string& error);
+    bool write(const cv::Mat& frame, double media_ms);
+    void close();
+
+    bool isOpen() const { return out.is_open(); }
+    uint64_t frameCount() const { return frames; }
+
+private:
+    std::ofstream out;
+    cv::Size size;
+    int type;
+    size_t record_size;
+    uint64_t frames;
+};
+
+#endif // FRAME_SOURCE_H
@@ -0,0 +1,111 @@
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+// Log-linear (HDR-style) latency histogram in microseconds. Values below 16 us
+// get exact buckets; above that each power of two is split into 16 sub-buckets,
+// so any percentile is within ~6% of the true value. record() is wait-free
+// (relaxed atomics only) and safe from any number of threads.
+class LatencyHistogram {
+public:
+    struct Summary {
+        uint64_t count = 0;
+        double mean_ms = 0;
+        double p50_ms = 0;
+        double p95_ms = 0;
+        double p99_ms = 0;
+        double max_ms = 0;
+    };
+
+    LatencyHistogram();
+
+    void record(uint64_t micros);
+    void reset();
+
+    uint64_t count() const { return total.load(std::memory_order_relaxed); }
+    uint64_t sumMicros() const { return sum.load(std::memory_order_relaxed); }
+    uint64_t bucketCount(int index) const { return buckets[index].load(std::memory_order_relaxed); }
+    double percentileMs(double p) const;
+    Summary summary() const;
+
+    static constexpr int kSubBits = 4;
+    static constexpr int kSubBuckets = 1 << kSubBits;
+    static constexpr int kMaxExponent = 36;  // ~19 hours
+    static constexpr int kBucketCount = kSubBuckets + (kMaxExponent - kSubBits + 1) * kSubBuckets;
+
+    static int bucketIndex(uint64_t micros);
+    static uint64_t bucketLowerBound(int index);
+    static uint64_t bucketUpperBound(int index);
+
+private:
+    std::atomic<uint64_t> buckets[kBucketCount];
+    std::atomic<uint64_t> total;
+    std::atomic<uint64_t> sum;
+    std::atomic<uint64_t> max;
+};
+
+// Pipeline stages with their own histogram
+enum class Stage {
+    Capture,     // frame source read
+    Resize,      // display resize
+    Motion,      // motion gate check
+    Preprocess,  // letterbox / blob
+    Forward,     // net.forward / session Run
+    Decode,      // output decoding
+    Nms,         // non-maximum suppression
+    Track,       // tracker predict / update
+    Draw,        // overlay compositing at paint time
+    Convert,     // scale + BGR -> RGB of a frame about to be painted
+    Bitmap,      // wxImage -> wxBitmap on the GUI thread
+    Display,     // video panel paint
+    EndToEnd,    // capture timestamp -> on screen
+    Count
+};
+
+constexpr int kStageCount = (int)Stage::Count;
+
+const char* stageName(Stage stage);
+
+class StageLatencies {
+public:
+    void record(Stage stage, uint64_t micros) { histograms[(int)stage].record(micros); }
+    void record(Stage stage, std::chrono::steady_clock::duration elapsed) {
+        record(stage, (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count());
+    }
+    void reset();
+
+    const LatencyHistogram& get(Stage stage) const { return histograms[(int)stage]; }
+
+    // Multi-line "stage  p50 / p95 / p99 / max ms" table for the Status panel
+    std::string formatTable() const;
+    // Two short lines for the video overlay HUD
+    std::string formatOverlay() const;
+    // Stage,Count,Mean_ms,P50_ms,P95_ms,P99_ms,Max_ms
+    void writeCsv(std::ostream& out) const;
+
+private:
+    LatencyHistogram histograms[kStageCount];
+};
+
+// Measures the time since construction or the last lap()
+class StageTimer {
+public:
+    StageTimer() : start(std::chrono::steady_clock::now()) {}
+
+    uint64_t lap() {
+        auto now = std::chrono::steady_clock::now();
+        auto micros = std::chrono::duration_cast<std::chrono::microseconds>(now - start).count();
+        start = now;
+        return (uint64_t)micros;
+    }
+
+private:
+    std::chrono::steady_clock::time_point start;
+};
+
+#endif // LATENCY_HISTOGRAM_H
@@ -0,0 +1,45 @@
+#ifndef LETTERBOX_H
+#define LETTERBOX_H
+
+#include <opencv2/opencv.hpp>
+
+// Geometry of the last preprocessed frame; maps network pixels back to the
+// frame as frame = (net - pad) / scale
+struct LetterboxInfo {
+    float scale_x = 1.0f;
+    float scale_y = 1.0f;
+    float pad_x = 0.0f;
+    float pad_y = 0.0f;
+};
+
+// Turns a BGR frame into a normalized RGB CHW float tensor written straight
+// into caller-owned memory (e.g. a bound ONNX Runtime input tensor).
+// All intermediate buffers are kept between calls, so steady-state frames
+// do not allocate.
+class LetterboxPreprocessor {
+public:
+    // keep_aspect pads to the network size instead of stretching
+    LetterboxPreprocessor(int width, int height, bool keep_aspect = true);
+
+    // dst must hold 3 * width * height floats
+    LetterboxInfo run(const cv::Mat& frame, float* dst);
+
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    bool keepsAspect() const { return keep_aspect; }
+
+private:
+    void updateGeometry(const cv::Size& frame_size);
+
+    int width;
+    int height;
+    bool keep_aspect;
+
+    cv::Size last_frame_size;
+    LetterboxInfo info;
+    cv::Rect content;   // where the resized frame lands inside the canvas
+    cv::Mat canvas;     // padded 8-bit BGR image
+    cv::Mat planes[3];  // 8-bit B, G, R planes
+};
+
+#endif // LETTERBOX_H
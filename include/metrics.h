@@ -0,0 +1,85 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+class FramePipeline;
+
+struct MetricsOptions {
+    int port = 0;                         // 0 = no endpoint
+    std::string address = "127.0.0.1";   // only local scrapers by default
+};
+
+// Pipeline health in the Prometheus text format. Everything it reports is
+// either a relaxed atomic the pipeline already keeps (frame counters, queue
+// depths, stage histograms) or one of the few counters kept here, which the
+// result callback updates with relaxed atomics as well. render() never takes
+// a lock the pipeline threads take; its own mutex only orders it against
+// attach() and detach() on the GUI thread.
+class PipelineMetrics {
+public:
+    static constexpr int kMaxStreams = 64;
+
+    PipelineMetrics();
+
+    // The pipeline's streams change in start(), so a running pipeline is
+    // attached after start() and detached after stop(). Detaching also
+    // resets the person counts.
+    void attach(const FramePipeline* pipeline);
+    void detach();
+
+    // From the result callback of stream_id
+    void observeResult(int stream_id, int person_count);
+    // Model load plus warm-up
+    void setModelLoadMs(double ms);
+
+    // Prometheus text exposition format, version 0.0.4
+    std::string render() const;
+
+private:
+    struct StreamCounters {
+        std::atomic<int> persons{0};
+        std::atomic<uint64_t> person_sum{0};
+        std::atomic<uint64_t> results{0};
+    };
+
+    StreamCounters counters[kMaxStreams];
+    std::atomic<double> model_load_ms;
+    mutable std::mutex attach_mutex;
+    const FramePipeline* pipeline;
+};
+
+// Minimal HTTP/1.0 server for GET /metrics: one thread, one connection at a
+// time, each answered with a freshly rendered page and closed. Other paths get
+// a 404.
+class MetricsServer {
+public:
+    using RenderFn = std::function<std::string()>;
+
+    explicit MetricsServer(RenderFn render);
+    ~MetricsServer();
+
+    // Binds address:port (0 = any free port, see port()) and starts serving
+    bool start(const std::string& address, int port, std::string& error);
+    void stop();
+
+    bool isRunning() const { return running.load(); }
+    int port() const { return bound_port; }
+
+private:
+    void serve();
+    void answer(int client);
+
+    RenderFn render;
+    int listen_fd;
+    int bound_port;
+    std::atomic<bool> running;
+    std::thread thread;
+};
+
+#endif // METRICS_H
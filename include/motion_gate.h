@@ -0,0 +1,43 @@
+#ifndef MOTION_GATE_H
+#define MOTION_GATE_H
+
+#include <opencv2/opencv.hpp>
+#include <cstddef>
+#include <cstdint>
+
+struct MotionGateOptions {
+    bool enabled = false;
+    int width = 160;                    // analysis resolution
+    int height = 120;
+    int pixel_threshold = 20;           // gray-level change that marks a pixel as changed
+    float min_changed_percent = 0.5f;   // changed pixels needed to run the detector
+    int refresh_interval = 30;          // run the detector at least every N frames
+};
+
+// Cheap change detector in front of the YOLO forward pass. Frames are shrunk
+// to a small grayscale copy and compared with the copy taken when the
+// detector last ran, so slow changes still add up to a run.
+class MotionGate {
+public:
+    explicit MotionGate(const MotionGateOptions& options = MotionGateOptions());
+
+    // True if the detector should run on frame (always true when disabled)
+    bool shouldDetect(const cv::Mat& frame);
+    void reset();
+
+    float lastChangedPercent() const { return changed_percent; }
+    const MotionGateOptions& getOptions() const { return options; }
+
+private:
+    MotionGateOptions options;
+    cv::Mat small;
+    cv::Mat gray;
+    cv::Mat reference;
+    int frames_since_run;
+    float changed_percent;
+};
+
+// Pixels where |a - b| > threshold, over count bytes
+size_t countChangedPixels(const uint8_t* a, const uint8_t* b, size_t count, uint8_t threshold);
+
+#endif // MOTION_GATE_H
@@ -0,0 +1,63 @@
+#ifndef NMS_H
+#define NMS_H
+
+#include "detection.h"
+#include "yolo_decoder.h"
+#include <cstddef>
+#include <vector>
+
+struct NmsOptions {
+    float iou_threshold = 0.45f;
+    float score_threshold = 0.0f;       // Soft-NMS drops boxes decayed below this
+    int top_k = 1000;                   // best candidates considered, 0 = all
+    int max_detections = 300;           // boxes kept, 0 = no limit
+    bool class_aware = true;            // only boxes of the same class suppress each other
+    bool soft = false;                  // Gaussian Soft-NMS: decay overlapping scores instead
+    float soft_sigma = 0.5f;
+    float containment_threshold = 0.0f; // also drop boxes this much inside a keeper, 0 = off
+};
+
+// Greedy non-maximum suppression over float boxes. The best top_k
+// candidates are selected first, which bounds the quadratic part no matter
+// how crowded the frame is. Boxes are then kept as a structure of arrays
+// sorted by score, so each keeper is tested against all later boxes with
+// the SIMD wrapper, several boxes per instruction. Class-aware mode shifts
+// every class into its own x range, so one pass handles all classes.
+// All buffers are reused between calls; one instance per thread.
+class NonMaxSuppressor {
+public:
+    explicit NonMaxSuppressor(const NmsOptions& options = NmsOptions());
+
+    // Survivors are appended to out, best first
+    void suppress(const std::vector<YoloCandidate>& candidates, std::vector<Detection>& out);
+    // ranks, if given, order the boxes instead of their confidence
+    void suppress(const std::vector<Detection>& boxes, std::vector<Detection>& out,
+                  const std::vector<float>* ranks = nullptr);
+
+    const NmsOptions& getOptions() const { return options; }
+
+private:
+    // Picks and sorts the best candidates by keys into order; returns how many
+    size_t selectTopK(size_t count);
+    void resizeBoxes(size_t count);
+    void setBox(size_t slot, float x, float y, float width, float height, float score, int class_id);
+    void separateClasses(size_t count);
+    void runHard(size_t count);
+    void runSoft(size_t count);
+    void run(size_t count);
+
+    NmsOptions options;
+    std::vector<float> keys;
+    std::vector<int> order;
+
+    // Sorted boxes, padded by one SIMD width so the kernels never read past the end
+    std::vector<float> x1, y1, x2, y2, area, score;
+    std::vector<int> class_ids;
+    std::vector<float> alive;     // 1 = still a candidate, 0 = suppressed
+    std::vector<float> overlap;   // Soft-NMS IoU scratch
+
+    std::vector<int> kept;        // slots of the survivors
+    std::vector<float> kept_scores;
+};
+
+#endif // NMS_H
@@ -0,0 +1,41 @@
+#ifndef OPENCV_DETECTOR_H
+#define OPENCV_DETECTOR_H
+
+#include <opencv2/opencv.hpp>
+#include <opencv2/dnn.hpp>
+#include "detector.h"
+#include "letterbox.h"
+#include "nms.h"
+#include "yolo_decoder.h"
+#include <memory>
+
+// YOLO backend on cv::dnn::Net
+class OpenCVDetector : public Detector {
+public:
+    OpenCVDetector(const std::string& model_path, const DetectorConfig& config);
+
+    std::vector<Detection> detect(const cv::Mat& frame) override;
+    void detectBatch(const std::vector<cv::Mat>& frames,
+                     std::vector<std::vector<Detection>>& results) override;
+    bool isInitialized() const override { return initialized; }
+    std::string name() const override { return "opencv"; }
+    int maxBatchSize() const override { return max_batch; }
+
+private:
+    // One forward pass over count frames; adds its stage times to timings
+    bool runBatch(const cv::Mat* frames, int count, std::vector<Detection>* results);
+
+    cv::dnn::Net net;
+    DetectorConfig config;
+    bool initialized;
+    std::vector<cv::String> out_names;
+    std::vector<cv::Mat> outs;
+    cv::Mat blob;  // persistent max_batch x 3 x H x W input
+    int max_batch;
+    std::vector<LetterboxInfo> geometries;
+    std::vector<YoloCandidate> candidates;
+    NonMaxSuppressor suppressor;
+    std::unique_ptr<LetterboxPreprocessor> preprocessor;
+};
+
+#endif // OPENCV_DETECTOR_H
@@ -0,0 +1,175 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <opencv2/opencv.hpp>
+#include "detection.h"
+#include "detector.h"
+#include "frame_pool.h"
+#include "frame_source.h"
+#include "frame_queue.h"
+#include "latency_histogram.h"
+#include "motion_gate.h"
+#include "tracker.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Frame handed from the capture stage to the inference stage
+struct CapturedFrame {
+    cv::Mat image;  // display-sized BGR frame
+    cv::Mat full;   // camera-resolution frame, kept only when detecting at full resolution
+    int frame_number = 0;
+    std::chrono::steady_clock::time_point capture_time;  // stamped by the source
+    double media_ms = 0.0;  // position in the source
+};
+
+// Finished frame handed from the inference stage to the GUI stage
+struct ProcessedFrame {
+    cv::Mat image;  // clean BGR frame from the camera's frame pool
+    std::vector<Detection> detections;  // boxes for the overlay, in image pixels
+    std::string hud;  // latency overlay lines, refreshed with the FPS
+    int stream_id = 0;
+    int frame_number = 0;
+    int person_count = 0;
+    int unique_persons = -1;  // persons tracked since start, -1 without tracking
+    float fps = 0.0f;
+    std::chrono::steady_clock::time_point capture_time;
+};
+
+struct PipelineOptions {
+    QueuePolicy queue_policy = QueuePolicy::KeepLatest;
+    size_t queue_capacity = 1;   // per camera
+    cv::Size capture_size = cv::Size(640, 480);  // resolution requested from the cameras
+    Pacing replay_pacing = Pacing::Realtime;  // files, raw recordings and synthetic sources
+    bool replay_loop = false;    // restart them at their end
+    bool detect_full_frame = false;  // detect on the captured frame, not the 640x480 display copy
+    int inference_workers = 0;   // 0 = one per core, capped at the camera count
+    int max_batch = 1;           // frames per forward pass
+    int batch_timeout_ms = 0;    // how long a partial batch waits for more frames
+    MotionGateOptions motion;    // skip the detector on static scenes
+    TrackerOptions tracking;     // detect every k frames, track in between
+    int opencv_threads = 0;      // cv::setNumThreads, 0 = an equal share of the cores per worker
+    std::vector<int> capture_cpus;    // capture threads pinned here, empty = unpinned
+    std::vector<int> inference_cpus;  // same for the inference workers
+};
+
+// Backpressure counters of one camera, readable from any thread
+struct PipelineStats {
+    uint64_t captured = 0;
+    uint64_t dropped = 0;
+    uint64_t processed = 0;
+    uint64_t detections_run = 0;      // frames that went through the detector
+    uint64_t detections_skipped = 0;  // frames gated, tracked or with no detector available
+    int detection_interval = 0;       // current tracker k, 0 without tracking
+    size_t queue_depth = 0;
+    size_t queue_capacity = 0;
+    QueuePolicy queue_policy = QueuePolicy::KeepLatest;
+};
+
+// What one stream reads: a camera index, video file, image sequence,
+// synthetic generator or raw frame file (see openFrameSource). id names
+// the stream in logs and file names; cameras use their device index.
+struct StreamSource {
+    int id = 0;
+    std::string spec;
+};
+
+// Burns boxes, labels, timestamp, frame/person line and FPS into image,
+// plus any extra newline-separated HUD lines (e.g. latency percentiles).
+// The GUI composites the same overlay at paint time instead; this is for
+// consumers that want it in the pixels.
+void drawFrameOverlay(cv::Mat& image, const std::vector<Detection>& detections,
+                      int frame_number, int person_count, float fps,
+                      const std::string& hud = std::string());
+
+// Multi-camera pipeline:
+//   one capture thread per camera -> reads and resizes into that camera's queue
+//   shared inference pool         -> detects and tracks, one worker per core
+//   GUI stage                     -> receives finished frames through the result callback
+// Workers claim cameras round-robin and a camera is held by at most one
+// worker, so a busy camera cannot starve the others and each camera's frames
+// stay in order. With max_batch > 1 a worker collects frames (one per camera
+// per round) until the batch is full or batch_timeout_ms has passed since its
+// first frame, then runs them through a single forward pass. With tracking
+// on, each camera's tracker decides which frames need the detector and
+// carries the boxes forward on the others.
+class FramePipeline {
+public:
+    // Called once per inference worker, on that worker's thread before it
+    // takes its first frame, so possibly concurrently; may return nullptr
+    // (no detection)
+    using DetectorFactory = std::function<std::unique_ptr<Detector>()>;
+    using ResultFn = std::function<void(ProcessedFrame&&)>;
+    using ErrorFn = std::function<void(int stream_id, const std::string&)>;
+
+    // Callbacks are invoked from the pipeline threads; the GUI is expected
+    // to marshal them onto the main thread (CallAfter / wxThreadEvent).
+    FramePipeline(DetectorFactory make_detector, ResultFn on_result, ErrorFn on_error,
+                  const PipelineOptions& options = PipelineOptions());
+    ~FramePipeline();
+
+    // Opens every source that can be opened and starts streaming. Stream ids
+    // are 0..streamCount()-1 in source order; the ids of sources that failed
+    // to open are appended to failed. Returns false if none opened; the
+    // streams of the previous session are then left as they were.
+    bool start(const std::vector<StreamSource>& sources, std::vector<int>* failed = nullptr);
+    // Cameras by device index
+    bool start(const std::vector<int>& camera_indices, std::vector<int>* failed = nullptr);
+    void stop();
+    bool isRunning() const { return running.load(); }
+
+    int streamCount() const { return (int)streams.size(); }
+    int cameraIndex(int stream_id) const;  // StreamSource::id
+    std::string sourceName(int stream_id) const;
+    bool isStreamRunning(int stream_id) const;
+    int workerCount() const { return (int)workers.size(); }
+    // Frames per forward pass since start()
+    double averageBatchSize() const;
+
+    PipelineStats stats(int stream_id) const;
+
+    // Per-camera latency histograms; the GUI records its own stages here too
+    StageLatencies& latencies(int stream_id);
+    const StageLatencies& latencies(int stream_id) const;
+
+private:
+    struct Stream;
+    struct Batch;
+
+    void captureLoop(Stream* stream);
+    void workerLoop(int slot);
+    bool claimBatch(Batch& batch, int limit);
+    void releaseBatch(Batch& batch);
+    void finishFrame(Stream* stream, CapturedFrame& captured,
+                     const std::vector<Detection>& detections);
+
+    DetectorFactory make_detector;
+    ResultFn on_result;
+    ErrorFn on_error;
+    PipelineOptions options;
+
+    std::vector<std::unique_ptr<Stream>> streams;
+    std::atomic<bool> running;
+
+    // Inference pool; each worker creates its detector on first use, and it
+    // is kept across restarts
+    std::vector<std::unique_ptr<Detector>> detectors;
+    std::vector<std::thread> workers;
+
+    // Round-robin scheduling state
+    std::mutex schedule_mutex;
+    std::condition_variable work_available;
+    size_t next_stream;
+    std::atomic<uint64_t> batch_count;
+    std::atomic<uint64_t> batched_frames;
+    std::atomic<int> detecting_workers;  // workers whose detector loaded
+};
+
+#endif // PIPELINE_H
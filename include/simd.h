@@ -0,0 +1,161 @@
+#ifndef SIMD_H
+#define SIMD_H
+
+// Minimal float SIMD wrapper used by the hot loops (output decoding, NMS).
+// Picks the widest instruction set the compiler targets: AVX, SSE2, NEON,
+// or a one-lane scalar fallback, so the kernels are written once.
+// A small set of unsigned byte ops serves the 8-bit image kernels.
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SIMD_SSE2 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
+#include <bitset>
+#include <cstdint>
+
+namespace simd {
+
+#if defined(__AVX__)
+
+constexpr int kWidth = 8;
+struct VecF { __m256 v; };
+
+inline VecF load(const float* p) { return {_mm256_loadu_ps(p)}; }
+inline void store(float* p, VecF a) { _mm256_storeu_ps(p, a.v); }
+inline VecF set1(float x) { return {_mm256_set1_ps(x)}; }
+inline VecF add(VecF a, VecF b) { return {_mm256_add_ps(a.v, b.v)}; }
+inline VecF sub(VecF a, VecF b) { return {_mm256_sub_ps(a.v, b.v)}; }
+inline VecF mul(VecF a, VecF b) { return {_mm256_mul_ps(a.v, b.v)}; }
+inline VecF div(VecF a, VecF b) { return {_mm256_div_ps(a.v, b.v)}; }
+inline VecF max(VecF a, VecF b) { return {_mm256_max_ps(a.v, b.v)}; }
+inline VecF min(VecF a, VecF b) { return {_mm256_min_ps(a.v, b.v)}; }
+inline VecF gt(VecF a, VecF b) { return {_mm256_cmp_ps(a.v, b.v, _CMP_GT_OQ)}; }
+// Lanes of mask set -> a, otherwise b
+inline VecF select(VecF mask, VecF a, VecF b) { return {_mm256_blendv_ps(b.v, a.v, mask.v)}; }
+inline int movemask(VecF mask) { return _mm256_movemask_ps(mask.v); }
+
+#elif defined(SIMD_SSE2)
+
+constexpr int kWidth = 4;
+struct VecF { __m128 v; };
+
+inline VecF load(const float* p) { return {_mm_loadu_ps(p)}; }
+inline void store(float* p, VecF a) { _mm_storeu_ps(p, a.v); }
+inline VecF set1(float x) { return {_mm_set1_ps(x)}; }
+inline VecF add(VecF a, VecF b) { return {_mm_add_ps(a.v, b.v)}; }
+inline VecF sub(VecF a, VecF b) { return {_mm_sub_ps(a.v, b.v)}; }
+inline VecF mul(VecF a, VecF b) { return {_mm_mul_ps(a.v, b.v)}; }
+inline VecF div(VecF a, VecF b) { return {_mm_div_ps(a.v, b.v)}; }
+inline VecF max(VecF a, VecF b) { return {_mm_max_ps(a.v, b.v)}; }
+inline VecF min(VecF a, VecF b) { return {_mm_min_ps(a.v, b.v)}; }
+inline VecF gt(VecF a, VecF b) { return {_mm_cmpgt_ps(a.v, b.v)}; }
+inline VecF select(VecF mask, VecF a, VecF b) {
+    return {_mm_or_ps(_mm_and_ps(mask.v, a.v), _mm_andnot_ps(mask.v, b.v))};
+}
+inline int movemask(VecF mask) { return _mm_movemask_ps(mask.v); }
+
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+
+constexpr int kWidth = 4;
+struct VecF { float32x4_t v; };
+
+inline VecF load(const float* p) { return {vld1q_f32(p)}; }
+inline void store(float* p, VecF a) { vst1q_f32(p, a.v); }
+inline VecF set1(float x) { return {vdupq_n_f32(x)}; }
+inline VecF add(VecF a, VecF b) { return {vaddq_f32(a.v, b.v)}; }
+inline VecF sub(VecF a, VecF b) { return {vsubq_f32(a.v, b.v)}; }
+inline VecF mul(VecF a, VecF b) { return {vmulq_f32(a.v, b.v)}; }
+inline VecF max(VecF a, VecF b) { return {vmaxq_f32(a.v, b.v)}; }
+inline VecF min(VecF a, VecF b) { return {vminq_f32(a.v, b.v)}; }
+inline VecF gt(VecF a, VecF b) { return {vreinterpretq_f32_u32(vcgtq_f32(a.v, b.v))}; }
+inline VecF select(VecF mask, VecF a, VecF b) {
+    return {vbslq_f32(vreinterpretq_u32_f32(mask.v), a.v, b.v)};
+}
+inline int movemask(VecF mask) {
+    uint32x4_t m = vshrq_n_u32(vreinterpretq_u32_f32(mask.v), 31);
+    return (int)(vgetq_lane_u32(m, 0) | (vgetq_lane_u32(m, 1) << 1) |
+                 (vgetq_lane_u32(m, 2) << 2) | (vgetq_lane_u32(m, 3) << 3));
+}
+inline VecF div(VecF a, VecF b) {
+    float x[4], y[4];
+    vst1q_f32(x, a.v);
+    vst1q_f32(y, b.v);
+    for (int i = 0; i < 4; ++i) {
+        x[i] /= y[i];
+    }
+    return {vld1q_f32(x)};
+}
+
+#else
+
+constexpr int kWidth = 1;
+struct VecF { float v; };
+
+inline VecF load(const float* p) { return {*p}; }
+inline void store(float* p, VecF a) { *p = a.v; }
+inline VecF set1(float x) { return {x}; }
+inline VecF add(VecF a, VecF b) { return {a.v + b.v}; }
+inline VecF sub(VecF a, VecF b) { return {a.v - b.v}; }
+inline VecF mul(VecF a, VecF b) { return {a.v * b.v}; }
+inline VecF div(VecF a, VecF b) { return {a.v / b.v}; }
+inline VecF max(VecF a, VecF b) { return {a.v > b.v ? a.v : b.v}; }
+inline VecF min(VecF a, VecF b) { return {a.v < b.v ? a.v : b.v}; }
+// Scalar masks use 1.0f for "set" so select/movemask stay branch-free
+inline VecF gt(VecF a, VecF b) { return {a.v > b.v ? 1.0f : 0.0f}; }
+inline VecF select(VecF mask, VecF a, VecF b) { return {mask.v != 0.0f ? a.v : b.v}; }
+inline int movemask(VecF mask) { return mask.v != 0.0f ? 1 : 0; }
+
+#endif
+
+// Unsigned byte lanes. AVX without AVX2 has no 256-bit integer ops, so x86
+// uses 128-bit SSE2 here even when the float path is AVX.
+#if defined(__AVX__) || defined(SIMD_SSE2)
+
+constexpr int kByteWidth = 16;
+struct VecU8 { __m128i v; };
+
+inline VecU8 loadU8(const uint8_t* p) { return {_mm_loadu_si128((const __m128i*)p)}; }
+inline VecU8 set1U8(uint8_t x) { return {_mm_set1_epi8((char)x)}; }
+inline VecU8 absdiffU8(VecU8 a, VecU8 b) {
+    return {_mm_or_si128(_mm_subs_epu8(a.v, b.v), _mm_subs_epu8(b.v, a.v))};
+}
+// Number of lanes where a > b
+inline int countGtU8(VecU8 a, VecU8 b) {
+    __m128i not_greater = _mm_cmpeq_epi8(_mm_subs_epu8(a.v, b.v), _mm_setzero_si128());
+    return kByteWidth - (int)std::bitset<16>(_mm_movemask_epi8(not_greater)).count();
+}
+
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+
+constexpr int kByteWidth = 16;
+struct VecU8 { uint8x16_t v; };
+
+inline VecU8 loadU8(const uint8_t* p) { return {vld1q_u8(p)}; }
+inline VecU8 set1U8(uint8_t x) { return {vdupq_n_u8(x)}; }
+inline VecU8 absdiffU8(VecU8 a, VecU8 b) { return {vabdq_u8(a.v, b.v)}; }
+inline int countGtU8(VecU8 a, VecU8 b) {
+    uint8x16_t ones = vshrq_n_u8(vcgtq_u8(a.v, b.v), 7);
+    uint64x2_t sum = vpaddlq_u32(vpaddlq_u16(vpaddlq_u8(ones)));
+    return (int)(vgetq_lane_u64(sum, 0) + vgetq_lane_u64(sum, 1));
+}
+
+#else
+
+constexpr int kByteWidth = 1;
+struct VecU8 { uint8_t v; };
+
+inline VecU8 loadU8(const uint8_t* p) { return {*p}; }
+inline VecU8 set1U8(uint8_t x) { return {x}; }
+inline VecU8 absdiffU8(VecU8 a, VecU8 b) { return {(uint8_t)(a.v > b.v ? a.v - b.v : b.v - a.v)}; }
+inline int countGtU8(VecU8 a, VecU8 b) { return a.v > b.v ? 1 : 0; }
+
+#endif
+
+} // namespace simd
+
+#endif // SIMD_H
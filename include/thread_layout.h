@@ -0,0 +1,75 @@
+#ifndef THREAD_LAYOUT_H
+#define THREAD_LAYOUT_H
+
+#include <string>
+#include <vector>
+
+// Threading knobs of every stage; 0 / empty = derived from the CPU topology
+struct ThreadingOptions {
+    int ort_intra_threads = 0;        // ONNX Runtime pool shared by all sessions
+    int ort_inter_threads = 0;
+    bool ort_spinning = false;        // spin-wait between parallel sections
+    int opencv_threads = 0;           // cv::setNumThreads
+    bool affinity = true;             // pin stages to CPUs (Linux only)
+    int numa_node = -1;               // keep every stage on this node, -1 = auto
+    std::vector<int> gui_cpus;        // explicit CPU sets override the plan
+    std::vector<int> capture_cpus;
+    std::vector<int> inference_cpus;
+};
+
+struct LogicalCpu {
+    int id = 0;
+    int core = 0;      // physical core within the package; SMT siblings share it
+    int package = 0;
+    int node = 0;      // NUMA node
+};
+
+// CPUs this process may run on, in id order
+struct CpuTopology {
+    std::vector<LogicalCpu> cpus;
+    int numa_nodes = 1;
+};
+
+// Where each stage runs. Empty CPU sets leave the stage unpinned.
+struct ThreadLayout {
+    int logical_cpus = 0;
+    int physical_cores = 0;
+    int numa_nodes = 1;
+    int numa_node = -1;               // node every stage is kept on, -1 = none
+    std::vector<int> gui_cpus;
+    std::vector<int> capture_cpus;
+    std::vector<int> inference_cpus;  // inference workers, all SMT siblings
+    std::vector<int> compute_cpus;    // one per physical inference core, for the ORT pool
+    bool onnxruntime = false;         // ORT settings only matter to that backend
+    int ort_intra_threads = 1;
+    int ort_inter_threads = 1;
+    bool ort_spinning = false;
+    int opencv_threads = 0;           // 0 = an equal share of the cores per worker
+};
+
+// Reads /sys on Linux; elsewhere every hardware thread is its own core
+CpuTopology detectCpuTopology();
+
+// With affinity on and at least four physical cores, the first eighth of
+// the cores (at least one) run the GUI and capture threads and the rest
+// run inference, so decoding and painting never queue behind a forward
+// pass. The ORT pool gets one thread per physical inference core; SMT
+// siblings share the core's vector units and only add contention. With
+// several NUMA nodes everything stays on one, so first-touch allocations
+// (frames, tensors) are node-local. onnxruntime is true for the ORT
+// backend (isOnnxRuntimeBackend).
+ThreadLayout planThreadLayout(const ThreadingOptions& options, const CpuTopology& topology,
+                              bool onnxruntime);
+
+// Multi-line startup report
+std::string formatThreadLayout(const ThreadLayout& layout);
+
+// Restricts the calling thread (and threads it creates later) to cpus;
+// true without doing anything for an empty set
+bool pinCurrentThread(const std::vector<int>& cpus);
+
+// "0-3,8,10-11" <-> {0, 1, 2, 3, 8, 10, 11}
+bool parseCpuList(const std::string& value, std::vector<int>& cpus);
+std::string formatCpuList(const std::vector<int>& cpus);
+
+#endif // THREAD_LAYOUT_H
@@ -0,0 +1,67 @@
+#ifndef TILED_DETECTOR_H
+#define TILED_DETECTOR_H
+
+#include <opencv2/opencv.hpp>
+#include "detector.h"
+#include "tiling.h"
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Runs a high-resolution frame through overlapping network-sized tiles
+// instead of downscaling it, so distant people keep enough pixels to be
+// found. With one inner detector all tiles go through it as one batch
+// (up to its max_batch per forward pass); with several, each takes an equal
+// share of the tiles on its own core. Boxes are merged with a global NMS.
+// The shares run on threads of the detector's own, not on OpenCV's pool,
+// which the thread layout may have shrunk to one thread.
+class TiledDetector : public Detector {
+public:
+    TiledDetector(std::vector<std::unique_ptr<Detector>> detectors, const TilingOptions& options,
+                  const NmsOptions& nms);
+    ~TiledDetector() override;
+
+    std::vector<Detection> detect(const cv::Mat& frame) override;
+    bool isInitialized() const override;
+    std::string name() const override;
+    // A frame already expands to a batch of tiles
+    int maxBatchSize() const override { return 1; }
+
+    // Tiles used for the last frame size
+    const std::vector<cv::Rect>& getTiles() const { return tiles; }
+
+private:
+    // Tiles handled by one inner detector
+    struct Share {
+        std::vector<cv::Mat> views;
+        std::vector<std::vector<Detection>> results;
+        DetectTimings timings;
+    };
+
+    void runShare(size_t w);
+    void shareLoop(size_t w);
+
+    std::vector<std::unique_ptr<Detector>> detectors;
+    TilingOptions options;
+    NonMaxSuppressor suppressor;
+
+    cv::Size tiled_size;
+    std::vector<cv::Rect> tiles;
+    std::vector<Share> shares;
+    std::vector<TileDetections> tile_detections;
+
+    // Share w > 0 runs on share_threads[w - 1]; detect() runs share 0 itself
+    std::vector<std::thread> share_threads;
+    std::mutex share_mutex;
+    std::condition_variable share_start;
+    std::condition_variable share_done;
+    uint64_t share_round = 0;   // bumped once per frame
+    size_t share_count = 0;     // shares in the current round
+    size_t shares_pending = 0;  // pool shares still running
+    bool stopping = false;
+};
+
+#endif // TILED_DETECTOR_H
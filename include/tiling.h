@@ -0,0 +1,42 @@
+#ifndef TILING_H
+#define TILING_H
+
+#include <opencv2/opencv.hpp>
+#include "detection.h"
+#include "nms.h"
+#include <vector>
+
+struct TilingOptions {
+    bool enabled = false;
+    int tile_size = 640;             // square tiles at the network input size
+    float overlap = 0.2f;            // fraction of a tile shared with its neighbour
+    std::vector<cv::Rect> regions;   // frame areas to tile; empty = the whole frame
+    bool overview = true;            // also detect on the whole frame, downscaled
+    int workers = 0;                 // detectors running tiles in parallel; 0 = one batch
+};
+
+// Overlapping tiles covering each region (or the whole frame), in frame
+// pixels. Tiles are tile_size square unless the region is smaller, and are
+// spread evenly so the overlap is at least the requested fraction.
+std::vector<cv::Rect> computeTiles(const cv::Size& frame_size, const TilingOptions& options);
+
+// Detections of one tile, already in frame coordinates
+struct TileDetections {
+    cv::Rect tile;
+    bool overview = false;
+    std::vector<Detection> detections;
+};
+
+// Global NMS over all tiles. Boxes cut by an inner tile edge are partial
+// views of an object that the overlap shows whole in a neighbouring tile,
+// so whole boxes rank above cut ones; the suppressor should also drop
+// boxes lying mostly inside a keeper (see tileMergeOptions).
+std::vector<Detection> mergeTileDetections(const std::vector<TileDetections>& tiles,
+                                           const cv::Size& frame_size,
+                                           NonMaxSuppressor& suppressor);
+
+// Detector NMS settings adapted for merging tiles: hard suppression plus a
+// containment test for the partial boxes at tile edges
+NmsOptions tileMergeOptions(const NmsOptions& nms);
+
+#endif // TILING_H
@@ -0,0 +1,16 @@
+#ifndef TIMESTAMP_H
+#define TIMESTAMP_H
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+// Formats a wall-clock time as "YYYY-MM-DD HH:MM:SS.mmm" (local time)
+std::string formatTimestamp(std::chrono::system_clock::time_point time);
+// Same for nanoseconds since the epoch
+std::string formatTimestamp(int64_t epoch_ns);
+
+// Nanoseconds since the epoch, the form frame logs store
+int64_t epochNanoseconds(std::chrono::system_clock::time_point time);
+
+#endif // TIMESTAMP_H
@@ -0,0 +1,86 @@
+#ifndef TRACKER_H
+#define TRACKER_H
+
+#include "detection.h"
+#include <vector>
+
+struct TrackerOptions {
+    bool enabled = false;
+    float iou_threshold = 0.3f;   // least IoU to match a detection to a track
+    int min_hits = 2;             // matches before a track counts as a person
+    int max_misses = 3;           // detector runs a track may go unmatched
+    int min_interval = 1;         // adaptive detection interval bounds, in frames
+    int max_interval = 8;
+    float max_drift = 0.25f;      // box widths a track may drift between detections
+    float min_confidence = 0.5f;  // detections below this are not tracked
+};
+
+// Constant-velocity Kalman state of one box coordinate and its rate per frame
+struct KalmanAxis {
+    float value = 0, velocity = 0;
+    float p00 = 0, p01 = 0, p11 = 0;  // covariance of (value, velocity)
+
+    void init(float measured, float value_variance, float velocity_variance);
+    void predict(float value_noise, float velocity_noise);
+    void correct(float measured, float measurement_noise);
+};
+
+// SORT-style person tracker: every track carries a Kalman filter over box
+// center, area and aspect ratio; detections are matched to the predicted
+// boxes by IoU with the Hungarian algorithm. Between detector runs the
+// predictions carry the boxes forward, and the detection interval adapts to
+// how fast the tracks move. Not thread-safe; one instance per camera.
+class MultiObjectTracker {
+public:
+    explicit MultiObjectTracker(const TrackerOptions& options = TrackerOptions());
+
+    // Called once per frame, in order: true if the detector should run on it
+    bool shouldDetect();
+    // Advance one frame, with the detector's output or without
+    void update(const std::vector<Detection>& detections);
+    void predict();
+    void reset();
+
+    // Confirmed tracks at the current frame, with track_id set
+    const std::vector<Detection>& tracks() const { return output; }
+    // Persons confirmed since the last reset
+    int uniqueCount() const { return unique_count; }
+    int detectionInterval() const { return interval; }
+    const TrackerOptions& getOptions() const { return options; }
+
+private:
+    struct Track {
+        int id = -1;  // assigned on confirmation
+        KalmanAxis cx, cy, area, aspect;
+        Detection last;
+        int hits = 0;
+        int misses = 0;
+    };
+
+    Detection predictedBox(const Track& track) const;
+    void predictTracks();
+    void adaptInterval();
+    void publish();
+
+    TrackerOptions options;
+    std::vector<Track> active;
+    std::vector<Detection> output;
+    int next_id;
+    int unique_count;
+    int interval;
+    int frames_since_detection;
+
+    // Scratch buffers reused across updates
+    std::vector<Detection> candidates;
+    std::vector<float> cost;
+    std::vector<int> assignment;
+};
+
+float boxIoU(const Detection& a, const Detection& b);
+
+// Minimum-cost assignment over a rows x cols row-major matrix (Hungarian
+// algorithm, O(n^2 m)). Returns the column of each row, or -1 for rows left
+// over when rows > cols.
+std::vector<int> solveAssignment(const std::vector<float>& cost, int rows, int cols);
+
+#endif // TRACKER_H
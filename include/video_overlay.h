@@ -0,0 +1,57 @@
+#ifndef VIDEO_OVERLAY_H
+#define VIDEO_OVERLAY_H
+
+#include <wx/wx.h>
+#include "detection.h"
+#include <cstdint>
+#include <ctime>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Boxes, labels and HUD text of one video tile, kept apart from the frame
+// and drawn over it at paint time, so frames stay clean for anything else
+// that reads them. Text is rendered once into small bitmaps cached by
+// content; a label or HUD line is only rendered again when its text
+// changes, and the HUD strings are only rebuilt when a value changes.
+class VideoOverlay {
+public:
+    VideoOverlay();
+
+    // What drawFrameOverlay used to burn in; detections in frame pixels
+    void Update(const std::vector<Detection>& detections, int frame_number, int person_count,
+                float fps, const std::string& hud);
+
+    // Draws over a frame painted at offset, scaled by scale
+    void Draw(wxDC& dc, const wxPoint& offset, double scale);
+
+private:
+    enum TextStyle { Title, Info, Latency, Label };
+
+    struct CachedText {
+        wxBitmap bitmap;
+        uint64_t used = 0;  // last Draw that showed it
+    };
+
+    void RebuildHud(std::time_t second);
+    const wxBitmap& RenderText(TextStyle style, const std::string& text);
+    void EvictUnused();
+
+    std::vector<Detection> m_detections;  // the ones worth a box
+    std::vector<std::string> m_labels;    // one per detection
+    int m_frame_number;
+    int m_person_count;
+    int m_fps;
+    std::string m_hud;
+    bool m_hud_dirty;
+    std::time_t m_hud_second;             // the clock line shows whole seconds
+    std::vector<std::pair<TextStyle, std::string>> m_hud_lines;
+
+    wxFont m_title_font;
+    wxFont m_font;
+    wxBitmap m_measure_bitmap;            // selected while measuring text
+    std::unordered_map<std::string, CachedText> m_cache;  // keyed by style + text
+    uint64_t m_draw_count;
+};
+
+#endif // VIDEO_OVERLAY_H
@@ -0,0 +1,52 @@
+#ifndef VIDEO_PANEL_H
+#define VIDEO_PANEL_H
+
+#include <wx/wx.h>
+#include <opencv2/opencv.hpp>
+#include "latency_histogram.h"
+#include "video_overlay.h"
+#include <chrono>
+
+// Shows the newest frame of one camera. SetFrame only keeps a reference to
+// the pooled frame; scaling to the window and the BGR->RGB conversion happen
+// in OnPaint, into buffers reused from frame to frame, so a frame replaced
+// before the next paint costs nothing. Repaints are coalesced to the display
+// refresh rate and double-buffered, with no relayout per frame. Boxes and
+// HUD text are composited from the overlay layer, never drawn into frames.
+class VideoPanel : public wxWindow {
+public:
+    VideoPanel(wxWindow* parent, const wxSize& min_size);
+
+    // BGR frame; capture_time gives the end-to-end latency once it is painted
+    void SetFrame(const cv::Mat& frame, std::chrono::steady_clock::time_point capture_time);
+    // Boxes and HUD drawn over the frame; update it before SetFrame
+    VideoOverlay& Overlay() { return m_overlay; }
+    // Convert, Bitmap, Display, Draw and EndToEnd are recorded here when set
+    void SetLatencies(StageLatencies* latencies) { m_latencies = latencies; }
+
+private:
+    void OnPaint(wxPaintEvent& event);
+    void OnTimer(wxTimerEvent& event);
+    void ScheduleRefresh();
+    void RenderBitmap(const wxSize& size);
+
+    cv::Mat m_frame;               // newest frame, shared with the camera's frame pool
+    bool m_frame_dirty;            // not painted yet
+    std::chrono::steady_clock::time_point m_capture_time;
+    StageLatencies* m_latencies;
+
+    cv::Mat m_scaled;              // frame resized to the window
+    wxImage m_image;               // RGB pixels, converted in place
+    wxBitmap m_bitmap;
+    wxSize m_bitmap_window;        // client size m_bitmap was rendered for
+    wxPoint m_offset;              // keeps the aspect ratio, black bars around
+    double m_scale;                // window pixels per frame pixel
+    VideoOverlay m_overlay;
+
+    wxTimer m_refresh_timer;
+    bool m_refresh_pending;
+    std::chrono::steady_clock::time_point m_last_paint;
+    std::chrono::steady_clock::duration m_refresh_interval;  // one display refresh
+};
+
+#endif // VIDEO_PANEL_H
@@ -0,0 +1,49 @@
+#ifndef YOLO_DECODER_H
+#define YOLO_DECODER_H
+
+#include <cstdint>
+#include <vector>
+
+// Memory layout of a YOLO detection head, inferred from the output shape.
+//   YOLOv8: [1, 4 + classes, N]  channel-major, no objectness column
+//   YOLOv5: [1, N, 5 + classes]  row-major, objectness at index 4
+struct YoloOutputLayout {
+    int batch = 1;
+    int num_candidates = 0;
+    int num_channels = 0;
+    int num_classes = 0;
+    bool channel_major = false;
+    bool has_objectness = false;
+};
+
+struct YoloDecodeParams {
+    float confidence_threshold = 0.5f;  // keep scores strictly above this
+    bool person_only = false;           // score class 0 only and skip the class argmax
+    // Maps network-input pixels back to the frame: frame = (net - pad) / scale
+    float scale_x = 1.0f;
+    float scale_y = 1.0f;
+    float pad_x = 0.0f;
+    float pad_y = 0.0f;
+    // Boxes are clamped to the frame when these are set
+    int frame_width = 0;
+    int frame_height = 0;
+};
+
+// Box in frame pixels, (x, y) is the top-left corner
+struct YoloCandidate {
+    float x, y, width, height;
+    float confidence;
+    int class_id;
+};
+
+// Fills layout from an output tensor shape; num_classes <= 0 means "guess".
+bool inferYoloLayout(const std::vector<int64_t>& shape, int num_classes,
+                     YoloOutputLayout& layout);
+
+// Thresholds and decodes one batch item straight from the tensor memory.
+// Candidates are appended to out (no NMS is applied here).
+void decodeYoloOutput(const float* data, const YoloOutputLayout& layout,
+                      const YoloDecodeParams& params, std::vector<YoloCandidate>& out,
+                      int batch_index = 0);
+
+#endif // YOLO_DECODER_H
@@ -3,38 +3,81 @@
 
 #include <opencv2/opencv.hpp>
 #include <onnxruntime_cxx_api.h>
+#include "detector.h"
+#include "letterbox.h"
+#include "nms.h"
+#include "yolo_decoder.h"
 #include <vector>
 #include <string>
 #include <memory>
 
-struct Detection {
-    float x, y, w, h;  // bounding box
-    float confidence;
-    int class_id;
-};
-
-class YOLODetector {
+// YOLO backend on ONNX Runtime
+class YOLODetector : public Detector {
 public:
-    YOLODetector(const std::string& model_path);
+    YOLODetector(const std::string& model_path, const DetectorConfig& config = DetectorConfig());
     ~YOLODetector();
     
-    std::vector<Detection> detect(const cv::Mat& frame);
+    std::vector<Detection> detect(const cv::Mat& frame) override;
+    void detectBatch(const std::vector<cv::Mat>& frames,
+                     std::vector<std::vector<Detection>>& results) override;
     cv::Mat drawDetections(const cv::Mat& frame, const std::vector<Detection>& detections);
-    bool isInitialized() const { return initialized; }
+    bool isInitialized() const override { return initialized; }
+    std::string name() const override { return "onnxruntime"; }
+    int maxBatchSize() const override { return max_batch; }
     
 private:
     std::unique_ptr<Ort::Session> session;
-    std::unique_ptr<Ort::Env> env;
+    Ort::Env* env;        // shared by every detector in the process
+    bool global_pools;    // sessions run on the environment's thread pools
     bool initialized;
     std::vector<std::string> class_names;
     int input_width;
     int input_height;
     float confidence_threshold;
-    float nms_threshold;
+    bool person_only;
+    
+    // Tensors of one batch size over the shared buffers, bound once
+    struct BatchBinding {
+        Ort::Value input_tensor{nullptr};
+        Ort::Value output_tensor{nullptr};
+        std::unique_ptr<Ort::IoBinding> binding;
+    };
+    
+    // Persistent I/O, bound once: preprocessing writes into input_buffer and
+    // the output is decoded in place from output_buffer. Both hold max_batch
+    // items; bindings[n - 1] views the first n of them. FP16 and uint8
+    // model I/O (quantized or half-precision exports) is bound to
+    // input_storage / output_storage instead and converted on the way.
+    std::string input_name;
+    std::string output_name;
+    std::vector<float> input_buffer;
+    std::vector<float> output_buffer;
+    ONNXTensorElementDataType input_type;
+    ONNXTensorElementDataType output_type;
+    std::vector<uint8_t> input_storage;
+    std::vector<uint8_t> output_storage;
+    std::vector<float> widened_output;  // FP16 output ORT allocated itself
+    std::vector<int64_t> output_shape;
+    Ort::MemoryInfo memory_info;
+    std::vector<BatchBinding> bindings;
+    int max_batch;
+    std::vector<LetterboxInfo> geometries;
+    std::unique_ptr<LetterboxPreprocessor> preprocessor;
+    bool letterbox;
+    std::vector<YoloCandidate> candidates;
+    NonMaxSuppressor suppressor;
     
-    std::vector<Detection> parseOutput(const std::vector<float>& output, 
-                                       const cv::Mat& frame, 
-                                       const std::vector<int64_t>& output_shape);
+    // Loads the optimized graph from config.model_cache_dir if it holds one
+    // for this model and runtime, else optimizes model_path and saves it there
+    void createSession(const std::string& model_path, const DetectorConfig& config);
+    void bindTensors();
+    // One Run() over count frames; adds its stage times to timings
+    bool runBatch(const cv::Mat* frames, int count, std::vector<Detection>* results);
+    std::vector<Detection> parseOutput(const float* output,
+                                       const std::vector<int64_t>& output_shape,
+                                       const cv::Mat& frame,
+                                       const LetterboxInfo& geometry,
+                                       int batch_index);
     void loadClassNames();
 };
 
@@ -0,0 +1,410 @@
+#include "app_config.h"
+#include <algorithm>
+#include <cstdlib>
+#include <sstream>
+
+namespace {
+
+// "1920x1080"
+bool parseSize(const std::string& value, cv::Size& size) {
+    int width = 0, height = 0;
+    char separator = 0;
+    std::istringstream in(value);
+    if (!(in >> width >> separator >> height) || separator != 'x' || width <= 0 || height <= 0) {
+        return false;
+    }
+    size = cv::Size(width, height);
+    return true;
+}
+
+// "x,y,w,h;x,y,w,h" in frame pixels
+bool parseRegions(const std::string& value, std::vector<cv::Rect>& regions) {
+    regions.clear();
+    std::istringstream list(value);
+    std::string item;
+    while (std::getline(list, item, ';')) {
+        int x = 0, y = 0, w = 0, h = 0;
+        char c1 = 0, c2 = 0, c3 = 0;
+        std::istringstream in(item);
+        if (!(in >> x >> c1 >> y >> c2 >> w >> c3 >> h) || c1 != ',' || c2 != ',' || c3 != ',' ||
+            w <= 0 || h <= 0) {
+            return false;
+        }
+        regions.emplace_back(x, y, w, h);
+    }
+    return true;
+}
+
+// "0,2,3"
+bool parseCameraList(const std::string& value, std::vector<int>& cameras) {
+    cameras.clear();
+    std::istringstream list(value);
+    std::string item;
+    while (std::getline(list, item, ',')) {
+        size_t used = 0;
+        int camera = std::stoi(item, &used);
+        if (used != item.size() || camera < 0) {
+            return false;
+        }
+        cameras.push_back(camera);
+    }
+    return true;
+}
+
+bool applyOption(const std::string& key, const std::string& value, AppConfig& config,
+                 std::string& error) {
+    try {
+        if (key == "backend") {
+            config.detector.backend = value;
+        } else if (key == "model") {
+            config.detector.model_path = value;
+        } else if (key == "precision") {
+            if (value != "fp32" && value != "fp16" && value != "int8") {
+                error = "Expected fp32, fp16 or int8 for --precision";
+                return false;
+            }
+            config.detector.precision = value;
+        } else if (key == "model-cache") {
+            config.detector.model_cache_dir = value == "off" ? "" : value;
+        } else if (key == "warmup") {
+            config.detector.warmup_runs = std::max(0, std::stoi(value));
+        } else if (key == "confidence") {
+            config.detector.confidence_threshold = std::stof(value);
+        } else if (key == "nms") {
+            if (value != "greedy" && value != "soft") {
+                error = "Expected greedy or soft for --nms";
+                return false;
+            }
+            config.detector.nms.soft = value == "soft";
+        } else if (key == "nms-iou") {
+            config.detector.nms.iou_threshold = std::min(1.0f, std::max(0.0f, std::stof(value)));
+        } else if (key == "nms-top-k") {
+            config.detector.nms.top_k = std::max(0, std::stoi(value));
+        } else if (key == "nms-class-aware") {
+            if (value != "on" && value != "off") {
+                error = "Expected on or off for --nms-class-aware";
+                return false;
+            }
+            config.detector.nms.class_aware = value == "on";
+        } else if (key == "queue-policy") {
+            if (!parseQueuePolicy(value, config.pipeline.queue_policy)) {
+                error = "Unknown queue policy '" + value +
+                        "' (expected drop-oldest, keep-latest or block)";
+                return false;
+            }
+        } else if (key == "queue-capacity") {
+            int capacity = std::stoi(value);
+            config.pipeline.queue_capacity = capacity < 1 ? 1 : (size_t)capacity;
+        } else if (key == "inference-workers") {
+            int workers = std::stoi(value);
+            config.pipeline.inference_workers = workers < 0 ? 0 : workers;
+        } else if (key == "max-batch") {
+            // Detectors size their input buffers for it; the pipeline fills them
+            int batch = std::max(1, std::stoi(value));
+            config.detector.max_batch = batch;
+            config.pipeline.max_batch = batch;
+        } else if (key == "batch-timeout-ms") {
+            config.pipeline.batch_timeout_ms = std::max(0, std::stoi(value));
+        } else if (key == "motion-gate") {
+            if (value != "on" && value != "off") {
+                error = "Expected on or off for --motion-gate";
+                return false;
+            }
+            config.pipeline.motion.enabled = value == "on";
+        } else if (key == "motion-threshold") {
+            config.pipeline.motion.min_changed_percent = std::max(0.0f, std::stof(value));
+        } else if (key == "motion-refresh") {
+            config.pipeline.motion.refresh_interval = std::max(1, std::stoi(value));
+        } else if (key == "tracking") {
+            if (value != "on" && value != "off") {
+                error = "Expected on or off for --tracking";
+                return false;
+            }
+            config.pipeline.tracking.enabled = value == "on";
+        } else if (key == "track-max-interval") {
+            config.pipeline.tracking.max_interval = std::max(1, std::stoi(value));
+        } else if (key == "capture-size") {
+            if (!parseSize(value, config.pipeline.capture_size)) {
+                error = "Expected WxH for --capture-size, e.g. 1920x1080";
+                return false;
+            }
+        } else if (key == "sources") {
+            config.sources.clear();
+            std::istringstream list(value);
+            std::string spec;
+            while (std::getline(list, spec, ',')) {
+                if (!spec.empty()) {
+                    config.sources.push_back(spec);
+                }
+            }
+        } else if (key == "replay") {
+            if (!parsePacing(value, config.pipeline.replay_pacing)) {
+                error = "Expected realtime or max for --replay";
+                return false;
+            }
+        } else if (key == "replay-loop") {
+            if (value != "on" && value != "off") {
+                error = "Expected on or off for --replay-loop";
+                return false;
+            }
+            config.pipeline.replay_loop = value == "on";
+        } else if (key == "tiling") {
+            if (value != "on" && value != "off") {
+                error = "Expected on or off for --tiling";
+                return false;
+            }
+            // Tiles need the camera-resolution frame, not the display copy
+            config.detector.tiling.enabled = value == "on";
+            config.pipeline.detect_full_frame = value == "on";
+        } else if (key == "tile-overlap") {
+            config.detector.tiling.overlap = std::min(0.9f, std::max(0.0f, std::stof(value)));
+        } else if (key == "tile-regions") {
+            if (!parseRegions(value, config.detector.tiling.regions)) {
+                error = "Expected X,Y,W,H[;X,Y,W,H...] for --tile-regions";
+                return false;
+            }
+        } else if (key == "tile-workers") {
+            config.detector.tiling.workers = std::max(0, std::stoi(value));
+        } else if (key == "log-capacity") {
+            config.log.capacity = (size_t)std::max(1, std::stoi(value));
+        } else if (key == "log-spill") {
+            if (value != "overwrite" && value != "disk") {
+                error = "Expected overwrite or disk for --log-spill";
+                return false;
+            }
+            config.log.spill = value == "disk" ? LogSpill::Disk : LogSpill::Overwrite;
+        } else if (key == "log-dir") {
+            config.log.dir = value;
+        } else if (key == "log-rotate-mb") {
+            config.log.rotate_bytes = (size_t)std::max(1, std::stoi(value)) << 20;
+        } else if (key == "log-keep-files") {
+            config.log.keep_files = std::max(0, std::stoi(value));
+        } else if (key == "log-flush-ms") {
+            config.log.flush_ms = std::max(1, std::stoi(value));
+        } else if (key == "clips") {
+            if (value != "on" && value != "off") {
+                error = "Expected on or off for --clips";
+                return false;
+            }
+            config.clips.enabled = value == "on";
+        } else if (key == "clip-pre-roll") {
+            config.clips.pre_roll_s = std::max(0.0, std::stod(value));
+        } else if (key == "clip-post-roll") {
+            config.clips.post_roll_s = std::max(0.0, std::stod(value));
+        } else if (key == "clip-memory-mb") {
+            config.clips.memory_bytes = (size_t)std::max(1, std::stoi(value)) << 20;
+        } else if (key == "clip-quality") {
+            config.clips.jpeg_quality = std::min(100, std::max(1, std::stoi(value)));
+        } else if (key == "clip-dir") {
+            config.clips.dir = value;
+        } else if (key == "metrics-port") {
+            int port = std::stoi(value);
+            if (port < 0 || port > 65535) {
+                error = "Expected a port from 0 to 65535 for --metrics-port";
+                return false;
+            }
+            config.metrics.port = port;
+        } else if (key == "metrics-address") {
+            config.metrics.address = value;
+        } else if (key == "autostart") {
+            if (!parseCameraList(value, config.autostart_cameras)) {
+                error = "Expected camera indices like 0,1 for --autostart";
+                return false;
+            }
+        } else if (key == "ort-intra-threads") {
+            config.threading.ort_intra_threads = std::max(0, std::stoi(value));
+        } else if (key == "ort-inter-threads") {
+            config.threading.ort_inter_threads = std::max(0, std::stoi(value));
+        } else if (key == "ort-spinning") {
+            if (value != "on" && value != "off") {
+                error = "Expected on or off for --ort-spinning";
+                return false;
+            }
+            config.threading.ort_spinning = value == "on";
+        } else if (key == "opencv-threads") {
+            config.threading.opencv_threads = std::max(0, std::stoi(value));
+        } else if (key == "affinity") {
+            if (value != "auto" && value != "off") {
+                error = "Expected auto or off for --affinity";
+                return false;
+            }
+            config.threading.affinity = value == "auto";
+        } else if (key == "numa-node") {
+            config.threading.numa_node = value == "auto" ? -1 : std::max(0, std::stoi(value));
+        } else if (key == "gui-cpus" || key == "capture-cpus" || key == "inference-cpus") {
+            std::vector<int>& cpus = key == "gui-cpus" ? config.threading.gui_cpus :
+                                     key == "capture-cpus" ? config.threading.capture_cpus :
+                                     config.threading.inference_cpus;
+            if (!parseCpuList(value, cpus)) {
+                error = "Expected CPUs like 0-3,8 for --" + key;
+                return false;
+            }
+        } else {
+            error = "Unknown option --" + key;
+            return false;
+        }
+    } catch (const std::exception&) {
+        error = "Invalid value '" + value + "' for --" + key;
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+bool parseAppConfig(const std::vector<std::string>& args, AppConfig& config, std::string& error) {
+    static const struct { const char* env; const char* key; } kEnvironment[] = {
+        {"DETECTOR_BACKEND", "backend"},
+        {"YOLO_MODEL_PATH", "model"},
+        {"MODEL_PRECISION", "precision"},
+        {"MODEL_CACHE_DIR", "model-cache"},
+        {"DETECTOR_WARMUP", "warmup"},
+        {"DETECTOR_CONFIDENCE", "confidence"},
+        {"NMS", "nms"},
+        {"NMS_IOU", "nms-iou"},
+        {"NMS_TOP_K", "nms-top-k"},
+        {"NMS_CLASS_AWARE", "nms-class-aware"},
+        {"FRAME_QUEUE_POLICY", "queue-policy"},
+        {"FRAME_QUEUE_CAPACITY", "queue-capacity"},
+        {"INFERENCE_WORKERS", "inference-workers"},
+        {"MAX_BATCH", "max-batch"},
+        {"BATCH_TIMEOUT_MS", "batch-timeout-ms"},
+        {"MOTION_GATE", "motion-gate"},
+        {"MOTION_THRESHOLD", "motion-threshold"},
+        {"MOTION_REFRESH", "motion-refresh"},
+        {"TRACKING", "tracking"},
+        {"TRACK_MAX_INTERVAL", "track-max-interval"},
+        {"CAPTURE_SIZE", "capture-size"},
+        {"SOURCES", "sources"},
+        {"REPLAY_PACING", "replay"},
+        {"REPLAY_LOOP", "replay-loop"},
+        {"TILING", "tiling"},
+        {"TILE_OVERLAP", "tile-overlap"},
+        {"TILE_REGIONS", "tile-regions"},
+        {"TILE_WORKERS", "tile-workers"},
+        {"LOG_CAPACITY", "log-capacity"},
+        {"LOG_SPILL", "log-spill"},
+        {"LOG_DIR", "log-dir"},
+        {"LOG_ROTATE_MB", "log-rotate-mb"},
+        {"LOG_KEEP_FILES", "log-keep-files"},
+        {"LOG_FLUSH_MS", "log-flush-ms"},
+        {"CLIPS", "clips"},
+        {"CLIP_PRE_ROLL", "clip-pre-roll"},
+        {"CLIP_POST_ROLL", "clip-post-roll"},
+        {"CLIP_MEMORY_MB", "clip-memory-mb"},
+        {"CLIP_QUALITY", "clip-quality"},
+        {"CLIP_DIR", "clip-dir"},
+        {"METRICS_PORT", "metrics-port"},
+        {"METRICS_ADDRESS", "metrics-address"},
+        {"AUTOSTART_CAMERAS", "autostart"},
+        {"ORT_INTRA_THREADS", "ort-intra-threads"},
+        {"ORT_INTER_THREADS", "ort-inter-threads"},
+        {"ORT_SPINNING", "ort-spinning"},
+        {"OPENCV_THREADS", "opencv-threads"},
+        {"THREAD_AFFINITY", "affinity"},
+        {"NUMA_NODE", "numa-node"},
+        {"GUI_CPUS", "gui-cpus"},
+        {"CAPTURE_CPUS", "capture-cpus"},
+        {"INFERENCE_CPUS", "inference-cpus"},
+    };
+    for (const auto& entry : kEnvironment) {
+        if (const char* value = std::getenv(entry.env)) {
+            if (!applyOption(entry.key, value, config, error)) {
+                error = std::string(entry.env) + ": " + error;
+                return false;
+            }
+        }
+    }
+
+    for (const auto& arg : args) {
+        if (arg == "--no-letterbox") {
+            config.detector.letterbox = false;
+            continue;
+        }
+        if (arg.compare(0, 2, "--") != 0 || arg.find('=') == std::string::npos) {
+            error = "Unexpected argument '" + arg + "'";
+            return false;
+        }
+        size_t eq = arg.find('=');
+        if (!applyOption(arg.substr(2, eq - 2), arg.substr(eq + 1), config, error)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::string appConfigUsage() {
+    std::string backends;
+    for (const auto& backend : availableBackends()) {
+        backends += (backends.empty() ? "" : "|") + backend;
+    }
+    return "Options:\n"
+           "  --backend=" + backends + "   detector backend (DETECTOR_BACKEND)\n"
+           "  --model=PATH                  YOLO ONNX model, default ./yolov8s.onnx (YOLO_MODEL_PATH)\n"
+           "  --precision=fp32|fp16|int8    default model variant, e.g. yolov8s-int8.onnx (MODEL_PRECISION)\n"
+           "  --model-cache=DIR|off         optimized ONNX Runtime graphs, default model_cache (MODEL_CACHE_DIR)\n"
+           "  --warmup=N                    blank forward passes after loading, default 2 (DETECTOR_WARMUP)\n"
+           "  --confidence=F                detection threshold (DETECTOR_CONFIDENCE)\n"
+           "  --no-letterbox                stretch frames instead of padding\n"
+           "  --nms=greedy|soft             suppression, soft = Gaussian Soft-NMS (NMS)\n"
+           "  --nms-iou=F                   overlap that suppresses a box, default 0.45 (NMS_IOU)\n"
+           "  --nms-top-k=N                 candidates considered, 0 = all, default 1000 (NMS_TOP_K)\n"
+           "  --nms-class-aware=on|off      suppress only within a class (NMS_CLASS_AWARE)\n"
+           "  --queue-policy=drop-oldest|keep-latest|block (FRAME_QUEUE_POLICY)\n"
+           "  --queue-capacity=N            capture queue size per camera (FRAME_QUEUE_CAPACITY)\n"
+           "  --inference-workers=N         shared detection threads, 0 = cores (INFERENCE_WORKERS)\n"
+           "  --max-batch=N                 frames per forward pass (MAX_BATCH)\n"
+           "  --batch-timeout-ms=T          max wait to fill a batch (BATCH_TIMEOUT_MS)\n"
+           "  --motion-gate=on|off          skip detection on static scenes (MOTION_GATE)\n"
+           "  --motion-threshold=P          % of pixels that must change (MOTION_THRESHOLD)\n"
+           "  --motion-refresh=N            detect at least every N frames (MOTION_REFRESH)\n"
+           "  --tracking=on|off             track persons, detect every k frames (TRACKING)\n"
+           "  --track-max-interval=N        largest k while tracking (TRACK_MAX_INTERVAL)\n"
+           "  --capture-size=WxH            camera resolution, default 640x480 (CAPTURE_SIZE)\n"
+           "  --sources=SPEC[,SPEC...]      stream files, image sequences, synthetic[:WxH[@FPS]]\n"
+           "                                or .raw recordings instead of cameras (SOURCES)\n"
+           "  --replay=realtime|max         recorded sources at their frame rate or flat out (REPLAY_PACING)\n"
+           "  --replay-loop=on|off          restart recorded sources at their end (REPLAY_LOOP)\n"
+           "  --tiling=on|off               detect on full-resolution 640 tiles (TILING)\n"
+           "  --tile-overlap=F              overlap between tiles, default 0.2 (TILE_OVERLAP)\n"
+           "  --tile-regions=X,Y,W,H[;...]  only tile these frame areas (TILE_REGIONS)\n"
+           "  --tile-workers=N              tiles in parallel, 0 = one batch (TILE_WORKERS)\n"
+           "  --log-capacity=N              frame log entries kept per camera (LOG_CAPACITY)\n"
+           "  --log-spill=overwrite|disk    keep logs in memory only, or also on disk (LOG_SPILL)\n"
+           "  --log-dir=DIR                 frame log files, default logs (LOG_DIR)\n"
+           "  --log-rotate-mb=N             start a new log file past N MB, default 64 (LOG_ROTATE_MB)\n"
+           "  --log-keep-files=N            log files kept per camera, 0 = all (LOG_KEEP_FILES)\n"
+           "  --log-flush-ms=T              how often new entries are written (LOG_FLUSH_MS)\n"
+           "  --clips=on|off                save a clip when persons appear, default off (CLIPS)\n"
+           "  --clip-pre-roll=S             seconds kept before the event, default 5 (CLIP_PRE_ROLL)\n"
+           "  --clip-post-roll=S            seconds after the last person, default 10 (CLIP_POST_ROLL)\n"
+           "  --clip-memory-mb=N            compressed pre-roll of all cameras, default 64 (CLIP_MEMORY_MB)\n"
+           "  --clip-quality=Q              JPEG quality 1-100, default 80 (CLIP_QUALITY)\n"
+           "  --clip-dir=DIR                clip files, default clips (CLIP_DIR)\n"
+           "  --metrics-port=N              serve Prometheus metrics at /metrics, 0 = off (METRICS_PORT)\n"
+           "  --metrics-address=ADDR        listen address, default 127.0.0.1 (METRICS_ADDRESS)\n"
+           "  --autostart=I[,I...]          stream these cameras once the model is ready (AUTOSTART_CAMERAS)\n"
+           "  --ort-intra-threads=N         ONNX Runtime pool, 0 = one per inference core (ORT_INTRA_THREADS)\n"
+           "  --ort-inter-threads=N         parallel graph branches, 0 = 1 (ORT_INTER_THREADS)\n"
+           "  --ort-spinning=on|off         ORT threads spin between ops, default off (ORT_SPINNING)\n"
+           "  --opencv-threads=N            cv::setNumThreads, 0 = auto (OPENCV_THREADS)\n"
+           "  --affinity=auto|off           pin GUI, capture and inference to CPUs (THREAD_AFFINITY)\n"
+           "  --numa-node=N|auto            keep every stage on one NUMA node (NUMA_NODE)\n"
+           "  --gui-cpus=LIST               e.g. 0,8 - overrides the planned GUI CPUs (GUI_CPUS)\n"
+           "  --capture-cpus=LIST           same for the capture threads (CAPTURE_CPUS)\n"
+           "  --inference-cpus=LIST         same for the inference workers, e.g. 1-7 (INFERENCE_CPUS)\n";
+}
+
+ThreadLayout applyThreadLayout(AppConfig& config) {
+    ThreadLayout layout = planThreadLayout(config.threading, detectCpuTopology(),
+                                           isOnnxRuntimeBackend(config.detector.backend));
+    config.detector.threads.intra_threads = layout.ort_intra_threads;
+    config.detector.threads.inter_threads = layout.ort_inter_threads;
+    config.detector.threads.spinning = layout.ort_spinning;
+    config.detector.threads.intra_cpus = layout.compute_cpus;
+    config.pipeline.opencv_threads = layout.opencv_threads;
+    config.pipeline.capture_cpus = layout.capture_cpus;
+    config.pipeline.inference_cpus = layout.inference_cpus;
+    config.clips.cpus = layout.capture_cpus;
+    return layout;
+}
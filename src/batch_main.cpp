@@ -0,0 +1,218 @@
+// Headless batch mode: runs the same detect + count + log logic as the GUI
+// over recorded video files, image directories or raw frame files, as fast
+// as the CPU allows.
+#include "app_config.h"
+#include "detector.h"
+#include "frame_log.h"
+#include "frame_source.h"
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+struct BatchOptions {
+    std::vector<std::string> inputs;
+    std::string output_dir = ".";
+    int jobs = 0;            // 0 = one per core
+    int log_every = 10;      // same cadence as the GUI frame log
+    double image_fps = 30.0; // timestamps for image directories
+};
+
+std::mutex g_output_mutex;
+
+void printUsage() {
+    std::cout << "Usage: wxapp_batch [options] VIDEO|IMAGE_DIR|PATTERN|FILE.raw...\n"
+                 "  --output-dir=DIR    where <input>.csv files are written (default .)\n"
+                 "  --jobs=N            files processed in parallel (default: cores)\n"
+                 "  --log-every=N       log every Nth frame (default 10, 1 = all)\n"
+                 "  --image-fps=F       frame rate assumed for image directories (default 30)\n"
+              << appConfigUsage();
+}
+
+bool processInput(const std::string& input, Detector* detector, const BatchOptions& options) {
+    FrameSourceOptions source_options;
+    source_options.fps = options.image_fps;
+    source_options.pacing = Pacing::Max;
+    std::string error;
+    std::unique_ptr<FrameSource> reader = openFrameSource(input, source_options, error);
+    if (!reader) {
+        std::lock_guard<std::mutex> lock(g_output_mutex);
+        std::cerr << "Failed to open " << input << ": " << error << std::endl;
+        return false;
+    }
+
+    fs::path input_path(input);
+    if (input_path.filename().empty()) {
+        input_path = input_path.parent_path();  // "dir/"
+    }
+    fs::path csv_path = fs::path(options.output_dir) / input_path.filename();
+    csv_path.replace_extension(".csv");
+    std::ofstream file(csv_path);
+    if (!file.is_open()) {
+        std::lock_guard<std::mutex> lock(g_output_mutex);
+        std::cerr << "Failed to create " << csv_path << std::endl;
+        return false;
+    }
+    writeFrameLogCsvHeader(file);
+
+    auto start = std::chrono::steady_clock::now();
+    FrameTime time;
+    int frame_number = 0;
+
+    // Logged frames are detected max_batch at a time in one forward pass
+    const size_t batch_limit = detector ? (size_t)std::max(1, detector->maxBatchSize()) : 1;
+    std::vector<cv::Mat> batch;
+    std::vector<FrameLog> batch_logs;
+    std::vector<std::vector<Detection>> results;
+    auto flush = [&]() {
+        if (detector) {
+            detector->detectBatch(batch, results);
+        }
+        for (size_t i = 0; i < batch_logs.size(); ++i) {
+            batch_logs[i].person_count = detector ? countPersons(results[i]) : 0;
+            writeFrameLogCsvRow(file, batch_logs[i], LogClock::Media);
+        }
+        batch.clear();
+        batch_logs.clear();
+    };
+
+    while (true) {
+        // Only logged frames need detection, so the others are not even decoded
+        if ((frame_number + 1) % options.log_every != 0) {
+            if (!reader->skip()) {
+                break;
+            }
+            frame_number++;
+            continue;
+        }
+        // A fresh Mat per frame: the reader would otherwise decode over the batch
+        cv::Mat frame;
+        if (!reader->read(frame, time)) {
+            break;
+        }
+        frame_number++;
+
+        FrameLog log;
+        log.timestamp_ns = (int64_t)(time.media_ms * 1e6);
+        log.frame_number = frame_number;
+        batch.push_back(frame);
+        batch_logs.push_back(log);
+        if (batch.size() >= batch_limit) {
+            flush();
+        }
+    }
+    flush();
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::lock_guard<std::mutex> lock(g_output_mutex);
+    std::cout << input << ": " << frame_number << " frames in " << seconds << " s ("
+              << (seconds > 0 ? frame_number / seconds : 0.0) << " FPS) -> "
+              << csv_path.string() << std::endl;
+    return true;
+}
+
+bool parseBatchOptions(int argc, char** argv, BatchOptions& options,
+                       std::vector<std::string>& config_args) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        try {
+            if (arg == "--help" || arg == "-h") {
+                return false;
+            } else if (arg.rfind("--output-dir=", 0) == 0) {
+                options.output_dir = arg.substr(13);
+            } else if (arg.rfind("--jobs=", 0) == 0) {
+                options.jobs = std::stoi(arg.substr(7));
+            } else if (arg.rfind("--log-every=", 0) == 0) {
+                options.log_every = std::max(1, std::stoi(arg.substr(12)));
+            } else if (arg.rfind("--image-fps=", 0) == 0) {
+                options.image_fps = std::stod(arg.substr(12));
+            } else if (arg.rfind("--", 0) == 0) {
+                config_args.push_back(arg);
+            } else {
+                options.inputs.push_back(arg);
+            }
+        } catch (const std::exception&) {
+            std::cerr << "Invalid value in " << arg << std::endl;
+            return false;
+        }
+    }
+    return !options.inputs.empty() && options.image_fps > 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    BatchOptions options;
+    std::vector<std::string> config_args;
+    if (!parseBatchOptions(argc, argv, options, config_args)) {
+        printUsage();
+        return 1;
+    }
+
+    AppConfig config;
+    std::string error;
+    if (!parseAppConfig(config_args, config, error)) {
+        std::cerr << error << "\n\n";
+        printUsage();
+        return 1;
+    }
+
+    ThreadLayout layout = applyThreadLayout(config);
+    std::cout << formatThreadLayout(layout);
+
+    int hardware_threads = std::max(1u, std::thread::hardware_concurrency());
+    int jobs = options.jobs > 0 ? options.jobs : hardware_threads;
+    jobs = std::min(jobs, (int)options.inputs.size());
+
+    // Parallelism comes from running files side by side; give each job an
+    // equal share of OpenCV's internal threads instead of oversubscribing
+    int cores = layout.inference_cpus.empty() ? hardware_threads : (int)layout.inference_cpus.size();
+    cv::setNumThreads(layout.opencv_threads > 0 ? layout.opencv_threads : std::max(1, cores / jobs));
+    fs::create_directories(options.output_dir);
+
+    std::cout << "Processing " << options.inputs.size() << " input(s) with " << jobs
+              << " job(s), backend " << config.detector.backend << std::endl;
+
+    std::atomic<size_t> next_input(0);
+    std::atomic<int> failures(0);
+    std::vector<std::thread> workers;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int j = 0; j < jobs; ++j) {
+        workers.emplace_back([&]() {
+            pinCurrentThread(config.pipeline.inference_cpus);
+            // One detector per worker, reused across its files
+            std::unique_ptr<Detector> detector = createDetector(config.detector);
+            if (!detector || !detector->isInitialized()) {
+                std::lock_guard<std::mutex> lock(g_output_mutex);
+                std::cerr << "Warning: no detector, person counts will be 0" << std::endl;
+                detector.reset();
+            }
+
+            size_t i;
+            while ((i = next_input.fetch_add(1)) < options.inputs.size()) {
+                if (!processInput(options.inputs[i], detector.get(), options)) {
+                    failures++;
+                }
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Done in " << seconds << " s, " << failures.load() << " failure(s)" << std::endl;
+    return failures.load() == 0 ? 0 : 2;
+}
@@ -0,0 +1,484 @@
+// Microbenchmarks for every hot-path stage of the camera pipeline.
+// Prints a table and, with --json=FILE, one JSON object per stage so runs
+// from different builds can be diffed.
+#include "detector.h"
+#include "letterbox.h"
+#include "motion_gate.h"
+#include "nms.h"
+#include "pipeline.h"
+#include "tracker.h"
+#include "yolo_decoder.h"
+#include <opencv2/opencv.hpp>
+#include <opencv2/dnn.hpp>
+#ifdef HAVE_ONNXRUNTIME
+#include <onnxruntime_cxx_api.h>
+#endif
+#include <wx/image.h>
+#include <wx/init.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+// Counts C++ heap allocations made by the measured code. OpenCV's own
+// buffers come from cv::fastMalloc and are not seen here.
+static std::atomic<uint64_t> g_alloc_count(0);
+static std::atomic<uint64_t> g_alloc_bytes(0);
+
+void* operator new(size_t size) {
+    g_alloc_count.fetch_add(1, std::memory_order_relaxed);
+    g_alloc_bytes.fetch_add(size, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+
+namespace {
+
+struct BenchOptions {
+    int iterations = 200;
+    int warmup = 10;
+    int width = 1280;
+    int height = 720;
+    std::string input;      // recorded video; synthetic frames when empty
+    std::string model_path;
+    std::string json_path;
+    std::string filter;     // run only stages whose name contains this
+    int batch = 4;          // frames per call in the detect_batch stages
+};
+
+struct StageResult {
+    std::string stage;
+    int iterations = 0;
+    double mean_us = 0, p50_us = 0, p90_us = 0, p99_us = 0, max_us = 0;
+    double allocs_per_iter = 0;
+    double bytes_per_iter = 0;
+};
+
+double percentile(const std::vector<double>& sorted, double p) {
+    if (sorted.empty()) {
+        return 0.0;
+    }
+    size_t index = (size_t)std::min<double>(sorted.size() - 1, p / 100.0 * sorted.size());
+    return sorted[index];
+}
+
+class BenchRunner {
+public:
+    explicit BenchRunner(const BenchOptions& options) : options(options) {}
+
+    // fn(i) runs one iteration; i cycles through the input frames
+    void run(const std::string& stage, const std::function<void(int)>& fn) {
+        if (!options.filter.empty() && stage.find(options.filter) == std::string::npos) {
+            return;
+        }
+
+        for (int i = 0; i < options.warmup; ++i) {
+            fn(i);
+        }
+
+        std::vector<double> samples;
+        samples.reserve(options.iterations);
+        uint64_t allocs_before = g_alloc_count.load();
+        uint64_t bytes_before = g_alloc_bytes.load();
+
+        for (int i = 0; i < options.iterations; ++i) {
+            auto start = std::chrono::steady_clock::now();
+            fn(i);
+            auto end = std::chrono::steady_clock::now();
+            samples.push_back(std::chrono::duration<double, std::micro>(end - start).count());
+        }
+
+        // The samples vector was reserved up front, so it adds no allocations here
+        uint64_t allocs = g_alloc_count.load() - allocs_before;
+        uint64_t bytes = g_alloc_bytes.load() - bytes_before;
+
+        StageResult result;
+        result.stage = stage;
+        result.iterations = options.iterations;
+        double total = 0.0;
+        for (double s : samples) {
+            total += s;
+        }
+        std::sort(samples.begin(), samples.end());
+        result.mean_us = total / samples.size();
+        result.p50_us = percentile(samples, 50);
+        result.p90_us = percentile(samples, 90);
+        result.p99_us = percentile(samples, 99);
+        result.max_us = samples.back();
+        result.allocs_per_iter = (double)allocs / options.iterations;
+        result.bytes_per_iter = (double)bytes / options.iterations;
+
+        std::cout << std::left << std::setw(28) << stage << std::right << std::fixed
+                  << std::setprecision(1)
+                  << std::setw(10) << result.p50_us
+                  << std::setw(10) << result.p90_us
+                  << std::setw(10) << result.p99_us
+                  << std::setw(10) << result.max_us
+                  << std::setw(10) << result.allocs_per_iter
+                  << std::setw(12) << result.bytes_per_iter << std::endl;
+        results.push_back(result);
+    }
+
+    void writeJson(const std::string& path) const {
+        std::ofstream file(path);
+        for (const auto& r : results) {
+            file << "{\"stage\":\"" << r.stage << "\",\"iterations\":" << r.iterations
+                 << ",\"mean_us\":" << r.mean_us << ",\"p50_us\":" << r.p50_us
+                 << ",\"p90_us\":" << r.p90_us << ",\"p99_us\":" << r.p99_us
+                 << ",\"max_us\":" << r.max_us << ",\"allocs_per_iter\":" << r.allocs_per_iter
+                 << ",\"bytes_per_iter\":" << r.bytes_per_iter << "}\n";
+        }
+    }
+
+private:
+    const BenchOptions& options;
+    std::vector<StageResult> results;
+};
+
+std::vector<cv::Mat> loadFrames(const BenchOptions& options) {
+    std::vector<cv::Mat> frames;
+    if (!options.input.empty()) {
+        cv::VideoCapture cap(options.input);
+        cv::Mat frame;
+        while (frames.size() < 32 && cap.read(frame)) {
+            frames.push_back(frame.clone());
+        }
+        if (frames.empty()) {
+            std::cerr << "No frames read from " << options.input << ", using synthetic frames"
+                      << std::endl;
+        }
+    }
+
+    // Synthetic: noise plus a few person-sized blocks, fixed seed
+    cv::RNG rng(42);
+    while (frames.size() < 8) {
+        cv::Mat frame(options.height, options.width, CV_8UC3);
+        rng.fill(frame, cv::RNG::UNIFORM, 0, 255);
+        for (int i = 0; i < 4; ++i) {
+            int w = options.width / 10, h = options.height / 3;
+            cv::Point tl(rng.uniform(0, options.width - w), rng.uniform(0, options.height - h));
+            cv::rectangle(frame, cv::Rect(tl, cv::Size(w, h)),
+                          cv::Scalar(rng.uniform(0, 255), rng.uniform(0, 255), rng.uniform(0, 255)), -1);
+        }
+        frames.push_back(frame);
+    }
+    return frames;
+}
+
+// Synthetic YOLOv8 head (1x84x8400) with a few hundred confident candidates
+std::vector<float> makeSyntheticOutput(int num_candidates, int num_channels) {
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> low(0.0f, 0.2f);
+    std::uniform_real_distribution<float> coord(0.0f, 640.0f);
+    std::uniform_real_distribution<float> size(10.0f, 200.0f);
+
+    std::vector<float> output((size_t)num_candidates * num_channels);
+    for (int c = 4; c < num_channels; ++c) {
+        for (int i = 0; i < num_candidates; ++i) {
+            output[(size_t)c * num_candidates + i] = low(rng);
+        }
+    }
+    for (int i = 0; i < num_candidates; ++i) {
+        output[i] = coord(rng);
+        output[num_candidates + i] = coord(rng);
+        output[2 * num_candidates + i] = size(rng);
+        output[3 * num_candidates + i] = size(rng);
+        if (i % 25 == 0) {
+            output[4 * (size_t)num_candidates + i] = 0.9f;  // person
+        }
+    }
+    return output;
+}
+
+bool parseOptions(int argc, char** argv, BenchOptions& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto value = [&arg](const char* prefix) { return arg.substr(std::string(prefix).size()); };
+        try {
+            if (arg.rfind("--iterations=", 0) == 0) options.iterations = std::max(1, std::stoi(value("--iterations=")));
+            else if (arg.rfind("--warmup=", 0) == 0) options.warmup = std::stoi(value("--warmup="));
+            else if (arg.rfind("--width=", 0) == 0) options.width = std::stoi(value("--width="));
+            else if (arg.rfind("--height=", 0) == 0) options.height = std::stoi(value("--height="));
+            else if (arg.rfind("--input=", 0) == 0) options.input = value("--input=");
+            else if (arg.rfind("--model=", 0) == 0) options.model_path = value("--model=");
+            else if (arg.rfind("--json=", 0) == 0) options.json_path = value("--json=");
+            else if (arg.rfind("--filter=", 0) == 0) options.filter = value("--filter=");
+            else if (arg.rfind("--batch=", 0) == 0) options.batch = std::max(1, std::stoi(value("--batch=")));
+            else return false;
+        } catch (const std::exception&) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    BenchOptions options;
+    if (!parseOptions(argc, argv, options)) {
+        std::cout << "Usage: bench [--iterations=N] [--warmup=N] [--width=W --height=H]\n"
+                     "             [--input=VIDEO] [--model=yolov8s.onnx] [--json=FILE] [--filter=STAGE]\n"
+                     "             [--batch=N]\n";
+        return 1;
+    }
+
+    wxInitializer wx_init;
+    std::vector<cv::Mat> frames = loadFrames(options);
+    const int frame_count = (int)frames.size();
+    auto frameAt = [&](int i) -> const cv::Mat& { return frames[i % frame_count]; };
+
+    std::cout << "Frames: " << frame_count << " x " << frames[0].cols << "x" << frames[0].rows
+              << (options.input.empty() ? " (synthetic)" : " (recorded)") << ", "
+              << options.iterations << " iterations\n\n";
+    std::cout << std::left << std::setw(28) << "stage" << std::right
+              << std::setw(10) << "p50 us" << std::setw(10) << "p90 us" << std::setw(10) << "p99 us"
+              << std::setw(10) << "max us" << std::setw(10) << "allocs" << std::setw(12) << "bytes"
+              << std::endl;
+
+    BenchRunner bench(options);
+
+    // Capture-side resize to the display size. The later stages use their
+    // inputs prepared outside any timed stage, so --filter can pick any of them.
+    cv::Mat display;
+    cv::resize(frameAt(0), display, cv::Size(640, 480));
+    cv::Mat resized;
+    bench.run("resize_640x480", [&](int i) {
+        cv::resize(frameAt(i), resized, cv::Size(640, 480));
+    });
+
+    // Motion gate check (refresh disabled so every call compares)
+    MotionGateOptions motion_options;
+    motion_options.enabled = true;
+    motion_options.refresh_interval = 1 << 30;
+    MotionGate gate(motion_options);
+    bench.run("motion_gate", [&](int i) {
+        gate.shouldDetect(frameAt(i));
+    });
+
+    // Preprocessing
+    cv::Mat blob;
+    bench.run("blob_from_image", [&](int i) {
+        blob = cv::dnn::blobFromImage(frameAt(i), 1.0 / 255.0, cv::Size(640, 640),
+                                      cv::Scalar(0, 0, 0), true, false);
+    });
+
+    int blob_shape[] = {1, 3, 640, 640};
+    cv::Mat letterbox_blob(4, blob_shape, CV_32F);
+    LetterboxPreprocessor preprocessor(640, 640, true);
+    preprocessor.run(frameAt(0), letterbox_blob.ptr<float>());
+    bench.run("letterbox_preprocess", [&](int i) {
+        preprocessor.run(frameAt(i), letterbox_blob.ptr<float>());
+    });
+
+    // Forward passes (need a model)
+    DetectorConfig detector_config;
+    detector_config.model_path = options.model_path;
+    std::string model_path = options.model_path.empty() ? "" : resolveModelPath(detector_config);
+    if (!model_path.empty()) {
+        cv::dnn::Net net = cv::dnn::readNetFromONNX(model_path);
+        std::vector<cv::String> out_names = net.getUnconnectedOutLayersNames();
+        std::vector<cv::Mat> outs;
+        net.setInput(letterbox_blob);
+        bench.run("forward_opencv", [&](int) {
+            net.setInput(letterbox_blob);
+            net.forward(outs, out_names);
+        });
+
+#ifdef HAVE_ONNXRUNTIME
+        Ort::Env env(ORT_LOGGING_LEVEL_WARNING, "bench");
+        Ort::SessionOptions session_options;
+        session_options.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_ENABLE_ALL);
+        Ort::Session session(env, model_path.c_str(), session_options);
+        Ort::AllocatorWithDefaultOptions allocator;
+        std::string input_name = session.GetInputNameAllocated(0, allocator).get();
+        std::string output_name = session.GetOutputNameAllocated(0, allocator).get();
+        const char* input_names[] = {input_name.c_str()};
+        const char* output_names[] = {output_name.c_str()};
+        std::vector<int64_t> input_shape = {1, 3, 640, 640};
+        Ort::MemoryInfo memory_info = Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeDefault);
+        Ort::Value input = Ort::Value::CreateTensor<float>(
+            memory_info, letterbox_blob.ptr<float>(), letterbox_blob.total(),
+            input_shape.data(), input_shape.size());
+        bench.run("forward_onnxruntime", [&](int) {
+            session.Run(Ort::RunOptions{nullptr}, input_names, &input, 1, output_names, 1);
+        });
+#endif
+
+        for (const auto& backend : availableBackends()) {
+            detector_config.backend = backend;
+            std::unique_ptr<Detector> detector = createDetector(detector_config);
+            if (detector && detector->isInitialized()) {
+                bench.run("detect_" + backend, [&](int i) { detector->detect(frameAt(i)); });
+            }
+
+            // Same frames through one forward pass; divide by --batch for per-frame cost
+            detector_config.max_batch = options.batch;
+            std::unique_ptr<Detector> batched = createDetector(detector_config);
+            detector_config.max_batch = 1;
+            if (options.batch > 1 && batched && batched->isInitialized() &&
+                batched->maxBatchSize() > 1) {
+                std::vector<cv::Mat> batch_frames(options.batch);
+                std::vector<std::vector<Detection>> batch_results;
+                bench.run("detect_batch" + std::to_string(options.batch) + "_" + backend, [&](int i) {
+                    for (int b = 0; b < options.batch; ++b) {
+                        batch_frames[b] = frameAt(i * options.batch + b);
+                    }
+                    batched->detectBatch(batch_frames, batch_results);
+                });
+            }
+
+            // Full-resolution frame through overlapping 640 tiles, one batch of --batch
+            detector_config.tiling.enabled = true;
+            detector_config.max_batch = options.batch;
+            std::unique_ptr<Detector> tiled = createDetector(detector_config);
+            detector_config.tiling.enabled = false;
+            detector_config.max_batch = 1;
+            if (tiled && tiled->isInitialized()) {
+                bench.run("detect_tiled_" + backend, [&](int i) { tiled->detect(frameAt(i)); });
+            }
+        }
+    } else {
+        std::cout << "(forward stages skipped: pass --model=PATH)" << std::endl;
+    }
+
+    // Output decoding on a synthetic YOLOv8 head
+    const int num_candidates = 8400, num_channels = 84;
+    std::vector<float> output = makeSyntheticOutput(num_candidates, num_channels);
+    YoloOutputLayout layout;
+    inferYoloLayout({1, num_channels, num_candidates}, 80, layout);
+    YoloDecodeParams params;
+    params.confidence_threshold = 0.5f;
+    std::vector<YoloCandidate> candidates;
+    candidates.reserve(num_candidates);
+    params.person_only = true;
+    decodeYoloOutput(output.data(), layout, params, candidates);
+    params.person_only = false;
+    bench.run("decode_all_classes", [&](int) {
+        candidates.clear();
+        decodeYoloOutput(output.data(), layout, params, candidates);
+    });
+    params.person_only = true;
+    bench.run("decode_person_only", [&](int) {
+        candidates.clear();
+        decodeYoloOutput(output.data(), layout, params, candidates);
+    });
+
+    // NMS over the decoded candidates
+    std::vector<cv::Rect> boxes;
+    std::vector<float> scores;
+    for (const auto& c : candidates) {
+        boxes.emplace_back((int)c.x, (int)c.y, (int)c.width, (int)c.height);
+        scores.push_back(c.confidence);
+    }
+    std::vector<int> keep;
+    bench.run("nms_boxes_" + std::to_string(boxes.size()), [&](int) {
+        cv::dnn::NMSBoxes(boxes, scores, 0.5f, 0.45f, keep);
+    });
+    NonMaxSuppressor suppressor;
+    std::vector<Detection> kept;
+    bench.run("nms_simd_" + std::to_string(candidates.size()), [&](int) {
+        kept.clear();
+        suppressor.suppress(candidates, kept);
+    });
+
+    // Crowded scene: thousands of overlapping candidates, capped by top-k
+    std::vector<YoloCandidate> crowd;
+    std::mt19937 crowd_rng(11);
+    std::uniform_real_distribution<float> crowd_pos(0.0f, 600.0f);
+    std::uniform_real_distribution<float> crowd_score(0.5f, 1.0f);
+    for (int i = 0; i < 5000; ++i) {
+        crowd.push_back({crowd_pos(crowd_rng), crowd_pos(crowd_rng), 40.0f, 90.0f,
+                         crowd_score(crowd_rng), 0});
+    }
+    std::vector<cv::Rect> crowd_boxes;
+    std::vector<float> crowd_scores;
+    for (const auto& c : crowd) {
+        crowd_boxes.emplace_back((int)c.x, (int)c.y, (int)c.width, (int)c.height);
+        crowd_scores.push_back(c.confidence);
+    }
+    bench.run("nms_boxes_crowd_5000", [&](int) {
+        cv::dnn::NMSBoxes(crowd_boxes, crowd_scores, 0.5f, 0.45f, keep);
+    });
+    bench.run("nms_simd_crowd_5000_top1000", [&](int) {
+        kept.clear();
+        suppressor.suppress(crowd, kept);
+    });
+    NmsOptions soft_options;
+    soft_options.soft = true;
+    soft_options.score_threshold = 0.5f;
+    NonMaxSuppressor soft_suppressor(soft_options);
+    bench.run("nms_soft_crowd_5000_top1000", [&](int) {
+        kept.clear();
+        soft_suppressor.suppress(crowd, kept);
+    });
+
+    // Overlay drawing on the display frame (includes restoring a clean copy)
+    std::vector<Detection> detections;
+    for (size_t i = 0; i < candidates.size() && i < 8; ++i) {
+        const auto& c = candidates[i];
+        detections.push_back({c.x, c.y * 0.75f, c.width, c.height * 0.75f, c.confidence, 0});
+    }
+
+    // Tracker on the same boxes walking right: a detector frame, then a predicted one
+    MultiObjectTracker tracker;
+    std::vector<Detection> moved = detections;
+    bench.run("track_update_" + std::to_string(detections.size()), [&](int i) {
+        for (size_t d = 0; d < moved.size(); ++d) {
+            moved[d].x = detections[d].x + (i % 100) * 2.0f;
+        }
+        tracker.update(moved);
+    });
+    bench.run("track_predict", [&](int) { tracker.predict(); });
+
+    // Burning the overlay into the frame, as the pipeline did per frame
+    // before the GUI composited it at paint time
+    cv::Mat overlay_frame = display.clone();
+    bench.run("draw_overlay", [&](int i) {
+        display.copyTo(overlay_frame);
+        drawFrameOverlay(overlay_frame, detections, i, (int)detections.size(), 30.0f);
+    });
+
+    // Display conversion: BGR->RGB plus a wxImage copy, as done per frame
+    // before the video panel
+    cv::Mat rgb;
+    bench.run("mat_to_wximage", [&](int) {
+        cv::cvtColor(overlay_frame, rgb, cv::COLOR_BGR2RGB);
+        wxImage image(rgb.cols, rgb.rows, rgb.data, true);
+        wxImage copy = image.Copy();
+    });
+
+    // What VideoPanel does per painted frame: scale to a 2x2-grid tile and
+    // convert straight into a reused wxImage
+    cv::Mat scaled;
+    wxImage tile_image(320, 240, false);
+    bench.run("video_panel_convert_320x240", [&](int) {
+        cv::resize(overlay_frame, scaled, cv::Size(320, 240), 0, 0, cv::INTER_AREA);
+        cv::Mat tile_rgb(240, 320, CV_8UC3, tile_image.GetData());
+        cv::cvtColor(scaled, tile_rgb, cv::COLOR_BGR2RGB);
+    });
+
+    if (!options.json_path.empty()) {
+        bench.writeJson(options.json_path);
+        std::cout << "\nWrote " << options.json_path << std::endl;
+    }
+    return 0;
+}
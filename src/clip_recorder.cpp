@@ -0,0 +1,554 @@
+#include "clip_recorder.h"
+#include "thread_layout.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <deque>
+#include <filesystem>
+#include <iostream>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// A clip file is closed and the clip continues in a new one past this size;
+// AVI 1.0 offsets are 32-bit
+const uint64_t kMaxFileBytes = 1u << 30;
+
+// RIFF header, main AVI header, one MJPEG stream header and format, then the
+// 'movi' list header: everything before the first frame
+const size_t kHeaderBytes = 224;
+
+std::string clipFileName(const std::string& dir, int camera_index, std::chrono::system_clock::time_point time) {
+    std::time_t seconds = std::chrono::system_clock::to_time_t(time);
+    int ms = (int)(std::chrono::duration_cast<std::chrono::milliseconds>(
+        time.time_since_epoch()).count() % 1000);
+    std::tm local_tm{};
+#ifdef _WIN32
+    localtime_s(&local_tm, &seconds);
+#else
+    localtime_r(&seconds, &local_tm);
+#endif
+    char stamp[32];
+    std::strftime(stamp, sizeof(stamp), "%Y%m%d_%H%M%S", &local_tm);
+    char name[96];
+    std::snprintf(name, sizeof(name), "clip_cam%d_%s_%03d.avi", camera_index, stamp, ms);
+    return (fs::path(dir) / name).string();
+}
+
+void put32(std::vector<uint8_t>& out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        out.push_back((uint8_t)(value >> (8 * i)));
+    }
+}
+
+void put16(std::vector<uint8_t>& out, uint16_t value) {
+    out.push_back((uint8_t)value);
+    out.push_back((uint8_t)(value >> 8));
+}
+
+void putTag(std::vector<uint8_t>& out, const char* tag) {
+    out.insert(out.end(), tag, tag + 4);
+}
+
+} // namespace
+
+// MJPEG AVI written frame by frame; the header is rewritten with the final
+// frame count and rate on close
+struct ClipRecorder::ClipFile {
+    std::FILE* file = nullptr;
+    std::string path;
+    cv::Size size;
+    uint32_t frames = 0;
+    uint64_t movi_bytes = 4;  // 'movi' tag
+    uint32_t largest = 0;
+    std::vector<uint32_t> index;  // offset, size per frame
+    std::chrono::steady_clock::time_point first;
+    std::chrono::steady_clock::time_point last;
+
+    bool open(const std::string& file_path, const cv::Size& frame_size) {
+        path = file_path;
+        size = frame_size;
+        file = std::fopen(path.c_str(), "wb");
+        if (!file) {
+            std::cerr << "Failed to create clip " << path << std::endl;
+            return false;
+        }
+        std::vector<uint8_t> header = makeHeader(30.0);
+        return std::fwrite(header.data(), 1, header.size(), file) == header.size();
+    }
+
+    bool write(const uint8_t* jpeg, size_t bytes, std::chrono::steady_clock::time_point time) {
+        if (frames == 0) {
+            first = time;
+        }
+        last = time;
+        std::vector<uint8_t> chunk;
+        putTag(chunk, "00dc");
+        put32(chunk, (uint32_t)bytes);
+        index.push_back((uint32_t)movi_bytes);
+        index.push_back((uint32_t)bytes);
+        bool ok = std::fwrite(chunk.data(), 1, chunk.size(), file) == chunk.size() &&
+                  std::fwrite(jpeg, 1, bytes, file) == bytes;
+        if (bytes % 2 != 0) {
+            ok = ok && std::fputc(0, file) != EOF;
+        }
+        movi_bytes += 8 + bytes + bytes % 2;
+        largest = std::max(largest, (uint32_t)bytes);
+        frames++;
+        return ok;
+    }
+
+    bool full() const { return kHeaderBytes + movi_bytes + 16ull * frames >= kMaxFileBytes; }
+
+    // Appends the index and fixes up the header; the rate is the clip's
+    // average, so playback takes as long as the recording did
+    bool close() {
+        double seconds = std::chrono::duration<double>(last - first).count();
+        double fps = frames > 1 && seconds > 0 ? (frames - 1) / seconds : 30.0;
+        std::vector<uint8_t> idx;
+        putTag(idx, "idx1");
+        put32(idx, 16 * frames);
+        for (uint32_t i = 0; i < frames; ++i) {
+            putTag(idx, "00dc");
+            put32(idx, 0x10);  // AVIIF_KEYFRAME
+            put32(idx, index[2 * i]);
+            put32(idx, index[2 * i + 1]);
+        }
+        bool ok = std::fwrite(idx.data(), 1, idx.size(), file) == idx.size();
+        std::vector<uint8_t> header = makeHeader(fps);
+        ok = ok && std::fseek(file, 0, SEEK_SET) == 0 &&
+             std::fwrite(header.data(), 1, header.size(), file) == header.size();
+        ok = std::fclose(file) == 0 && ok;
+        file = nullptr;
+        return ok;
+    }
+
+    std::vector<uint8_t> makeHeader(double fps) const {
+        uint32_t scale = 1000;
+        uint32_t rate = (uint32_t)std::lround(fps * scale);
+        std::vector<uint8_t> out;
+        putTag(out, "RIFF");
+        put32(out, (uint32_t)(kHeaderBytes - 8 + movi_bytes - 4 + 8 + 16ull * frames));
+        putTag(out, "AVI ");
+        putTag(out, "LIST");
+        put32(out, 192);
+        putTag(out, "hdrl");
+        putTag(out, "avih");
+        put32(out, 56);
+        put32(out, (uint32_t)std::lround(1e6 / fps));  // microseconds per frame
+        put32(out, (uint32_t)(largest * fps));         // max bytes per second
+        put32(out, 0);                                 // padding granularity
+        put32(out, 0x10);                              // AVIF_HASINDEX
+        put32(out, frames);
+        put32(out, 0);                                 // initial frames
+        put32(out, 1);                                 // streams
+        put32(out, largest);                           // suggested buffer size
+        put32(out, (uint32_t)size.width);
+        put32(out, (uint32_t)size.height);
+        for (int i = 0; i < 4; ++i) {
+            put32(out, 0);
+        }
+        putTag(out, "LIST");
+        put32(out, 116);
+        putTag(out, "strl");
+        putTag(out, "strh");
+        put32(out, 56);
+        putTag(out, "vids");
+        putTag(out, "MJPG");
+        put32(out, 0);                                 // flags
+        put32(out, 0);                                 // priority, language
+        put32(out, 0);                                 // initial frames
+        put32(out, scale);
+        put32(out, rate);
+        put32(out, 0);                                 // start
+        put32(out, frames);                            // length
+        put32(out, largest);
+        put32(out, 0xffffffff);                        // quality: default
+        put32(out, 0);                                 // sample size: varies
+        put16(out, 0);
+        put16(out, 0);
+        put16(out, (uint16_t)size.width);
+        put16(out, (uint16_t)size.height);
+        putTag(out, "strf");
+        put32(out, 40);                                // BITMAPINFOHEADER
+        put32(out, 40);
+        put32(out, (uint32_t)size.width);
+        put32(out, (uint32_t)size.height);
+        put16(out, 1);                                 // planes
+        put16(out, 24);                                // bits per pixel
+        putTag(out, "MJPG");
+        put32(out, (uint32_t)(size.width * size.height * 3));
+        for (int i = 0; i < 4; ++i) {
+            put32(out, 0);
+        }
+        putTag(out, "LIST");
+        put32(out, (uint32_t)movi_bytes);
+        putTag(out, "movi");
+        return out;
+    }
+};
+
+struct ClipRecorder::Stream {
+    struct Entry {
+        uint64_t seq = 0;
+        size_t offset = 0;
+        size_t size = 0;
+        std::chrono::steady_clock::time_point time;
+    };
+
+    int camera_index = 0;
+    int last_persons = 0;                // push() only
+    std::atomic<bool> triggered{false};  // 0 -> >0 seen, not turned into a clip yet
+    std::atomic<uint64_t> skipped{0};
+
+    // Newest frame not taken by the encoder yet
+    cv::Mat pending;
+    int pending_persons = 0;
+    std::chrono::steady_clock::time_point pending_time;
+    bool pending_ready = false;
+
+    // Compressed frames, oldest first, laid out circularly in arena
+    std::vector<uint8_t> arena;
+    std::deque<Entry> entries;
+    size_t head = 0;  // where the next frame would go
+    size_t ring_bytes = 0;
+    uint64_t next_seq = 0;
+    cv::Size frame_size;
+    uint64_t encoded = 0;
+    uint64_t dropped = 0;
+    uint64_t clips = 0;
+
+    // The clip in progress: frames [clip_next, clip_end) still have to be
+    // written and may not be overwritten
+    bool recording = false;  // post-roll not over yet; clip_end is open
+    bool writing = false;    // a clip has frames left to write or a file to close
+    uint64_t clip_next = 0;
+    uint64_t clip_end = UINT64_MAX;
+    std::chrono::steady_clock::time_point clip_until;
+    std::chrono::system_clock::time_point clip_event;
+
+    // Writer thread only
+    std::unique_ptr<ClipFile> file;
+    bool file_failed = false;
+};
+
+ClipRecorder::ClipRecorder(const ClipOptions& options)
+    : options(options), running(false), encoder_stopping(false), writer_stopping(false) {}
+
+ClipRecorder::~ClipRecorder() {
+    stop();
+}
+
+void ClipRecorder::addStream(int camera_index) {
+    auto stream = std::make_unique<Stream>();
+    stream->camera_index = camera_index;
+    streams.push_back(std::move(stream));
+}
+
+bool ClipRecorder::start() {
+    if (running || streams.empty()) {
+        return running;
+    }
+    std::error_code ec;
+    fs::create_directories(options.dir, ec);
+    if (ec) {
+        std::cerr << "Failed to create clip directory " << options.dir << ": " << ec.message()
+                  << std::endl;
+        return false;
+    }
+    // The whole budget is allocated up front and never grows
+    size_t per_stream = options.memory_bytes / streams.size();
+    for (auto& stream : streams) {
+        stream->arena.assign(per_stream, 0);
+    }
+    finished.clear();
+    encoder_stopping = false;
+    writer_stopping = false;
+    running = true;
+    encoder = std::thread(&ClipRecorder::encodeLoop, this);
+    writer = std::thread(&ClipRecorder::writeLoop, this);
+    return true;
+}
+
+void ClipRecorder::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!running) {
+            return;
+        }
+        running = false;
+        encoder_stopping = true;
+    }
+    frames_ready.notify_all();
+    encoder.join();
+    {
+        // Open clips end with what the ring already holds
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto& stream : streams) {
+            if (stream->recording) {
+                stream->recording = false;
+                stream->clip_end = stream->next_seq;
+            }
+        }
+        writer_stopping = true;
+    }
+    clip_ready.notify_all();
+    writer.join();
+}
+
+void ClipRecorder::push(int stream_id, const cv::Mat& frame, int person_count,
+                        std::chrono::steady_clock::time_point capture_time) {
+    if (stream_id < 0 || stream_id >= (int)streams.size()) {
+        return;
+    }
+    Stream& stream = *streams[stream_id];
+    if (stream.last_persons == 0 && person_count > 0) {
+        stream.triggered.store(true);
+    }
+    stream.last_persons = person_count;
+
+    // The encoder and writer hold the lock only for short copies, but a
+    // worker still never waits for them
+    std::unique_lock<std::mutex> lock(mutex, std::try_to_lock);
+    if (!lock.owns_lock()) {
+        stream.skipped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    if (!running) {
+        return;
+    }
+    if (stream.pending_ready) {
+        stream.skipped.fetch_add(1, std::memory_order_relaxed);
+    }
+    stream.pending = frame;
+    stream.pending_persons = person_count;
+    stream.pending_time = capture_time;
+    stream.pending_ready = true;
+    lock.unlock();
+    frames_ready.notify_one();
+}
+
+void ClipRecorder::encodeLoop() {
+    pinCurrentThread(options.cpus);
+    const std::vector<int> params = {cv::IMWRITE_JPEG_QUALITY, options.jpeg_quality};
+    std::vector<uint8_t> jpeg;
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        frames_ready.wait(lock, [this]() {
+            return encoder_stopping || std::any_of(streams.begin(), streams.end(),
+                                                   [](const auto& s) { return s->pending_ready; });
+        });
+        if (encoder_stopping) {
+            break;
+        }
+        for (auto& stream : streams) {
+            if (!stream->pending_ready) {
+                continue;
+            }
+            cv::Mat frame = std::move(stream->pending);
+            stream->pending = cv::Mat();
+            stream->pending_ready = false;
+            int persons = stream->pending_persons;
+            auto time = stream->pending_time;
+
+            lock.unlock();
+            bool encoded = cv::imencode(".jpg", frame, jpeg, params);
+            cv::Size size = frame.size();
+            frame.release();  // back to the camera's frame pool
+            lock.lock();
+            if (encoded) {
+                append(*stream, jpeg, size, time, persons);
+            }
+        }
+        clip_ready.notify_one();
+    }
+    for (auto& stream : streams) {
+        stream->pending.release();
+        stream->pending_ready = false;
+    }
+}
+
+// Under the lock
+void ClipRecorder::append(Stream& stream, const std::vector<uint8_t>& jpeg, const cv::Size& size,
+                          std::chrono::steady_clock::time_point time, int person_count) {
+    // Evict the oldest frames until the new one fits, unless the writer
+    // still needs them
+    const size_t capacity = stream.arena.size();
+    const uint64_t pinned = stream.writing ? stream.clip_next : stream.next_seq;
+    bool stored = false;
+    size_t offset = 0;
+    while (jpeg.size() <= capacity) {
+        if (stream.entries.empty()) {
+            stream.head = 0;
+            offset = 0;
+            stored = true;
+            break;
+        }
+        size_t tail = stream.entries.front().offset;
+        if (tail >= stream.head) {
+            if (jpeg.size() <= tail - stream.head) {
+                offset = stream.head;
+                stored = true;
+                break;
+            }
+        } else if (stream.head + jpeg.size() <= capacity) {
+            offset = stream.head;
+            stored = true;
+            break;
+        } else if (jpeg.size() <= tail) {
+            offset = 0;
+            stored = true;
+            break;
+        }
+        if (stream.entries.front().seq >= pinned) {
+            break;
+        }
+        stream.ring_bytes -= stream.entries.front().size;
+        stream.entries.pop_front();
+    }
+
+    if (stored) {
+        std::memcpy(stream.arena.data() + offset, jpeg.data(), jpeg.size());
+        Stream::Entry entry;
+        entry.seq = stream.next_seq++;
+        entry.offset = offset;
+        entry.size = jpeg.size();
+        entry.time = time;
+        stream.entries.push_back(entry);
+        stream.head = offset + jpeg.size();
+        stream.ring_bytes += jpeg.size();
+        stream.frame_size = size;
+        stream.encoded++;
+    } else {
+        stream.dropped++;
+    }
+
+    // One clip at a time per camera; an event while the previous clip is
+    // still being written starts the next one as soon as it is done
+    if (stream.recording) {
+        stream.triggered.store(false);
+    } else if (!stream.writing && stream.triggered.exchange(false)) {
+        stream.recording = true;
+        stream.writing = true;
+        stream.clip_event = std::chrono::system_clock::now();
+        stream.clip_until = time + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                       std::chrono::duration<double>(options.post_roll_s));
+        stream.clip_next = stream.next_seq;
+        stream.clip_end = UINT64_MAX;
+        auto pre_roll = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<double>(options.pre_roll_s));
+        for (const auto& entry : stream.entries) {
+            if (entry.time >= time - pre_roll) {
+                stream.clip_next = entry.seq;
+                break;
+            }
+        }
+    }
+    if (stream.recording) {
+        if (person_count > 0) {
+            stream.clip_until = time + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                           std::chrono::duration<double>(options.post_roll_s));
+        }
+        if (time >= stream.clip_until) {
+            stream.recording = false;
+            stream.clip_end = stream.next_seq;
+        }
+    }
+}
+
+// Under the lock
+bool ClipRecorder::hasWork() const {
+    for (const auto& stream : streams) {
+        if (stream->writing &&
+            (stream->clip_next < std::min(stream->next_seq, stream->clip_end) || !stream->recording)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void ClipRecorder::writeLoop() {
+    pinCurrentThread(options.cpus);
+    std::vector<uint8_t> buffer;
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        clip_ready.wait(lock, [this]() { return writer_stopping || hasWork(); });
+        if (!hasWork()) {
+            break;  // stopping and nothing left
+        }
+        for (auto& stream_ptr : streams) {
+            Stream& stream = *stream_ptr;
+            // Frames are copied out one at a time; the file write happens unlocked
+            while (stream.writing && stream.clip_next < std::min(stream.next_seq, stream.clip_end)) {
+                const Stream::Entry& entry = stream.entries[stream.clip_next - stream.entries.front().seq];
+                buffer.assign(stream.arena.data() + entry.offset, stream.arena.data() + entry.offset + entry.size);
+                auto time = entry.time;
+                cv::Size size = stream.frame_size;
+                auto event = stream.clip_event;
+                stream.clip_next++;
+                lock.unlock();
+
+                if (stream.file && stream.file->full()) {
+                    stream.file->close();
+                    std::lock_guard<std::mutex> relock(mutex);
+                    finished.push_back(stream.file->path);
+                    stream.file.reset();
+                    event = std::chrono::system_clock::now();
+                }
+                if (!stream.file && !stream.file_failed) {
+                    stream.file = std::make_unique<ClipFile>();
+                    if (!stream.file->open(clipFileName(options.dir, stream.camera_index, event), size)) {
+                        stream.file.reset();
+                        stream.file_failed = true;  // the rest of this clip is discarded
+                    }
+                }
+                if (stream.file && !stream.file->write(buffer.data(), buffer.size(), time)) {
+                    std::cerr << "Failed to write clip " << stream.file->path << std::endl;
+                    stream.file->close();
+                    stream.file.reset();
+                    stream.file_failed = true;
+                }
+                lock.lock();
+            }
+
+            if (stream.writing && !stream.recording && stream.clip_next >= stream.clip_end) {
+                std::unique_ptr<ClipFile> file = std::move(stream.file);
+                stream.writing = false;
+                stream.file_failed = false;
+                stream.clips++;
+                lock.unlock();
+                bool saved = file && file->close();
+                if (saved) {
+                    std::cout << "Saved clip " << file->path << " (" << file->frames << " frames)" << std::endl;
+                }
+                lock.lock();
+                if (saved) {
+                    finished.push_back(file->path);
+                }
+            }
+        }
+    }
+}
+
+ClipRecorder::Stats ClipRecorder::stats(int stream_id) const {
+    Stats result;
+    if (stream_id < 0 || stream_id >= (int)streams.size()) {
+        return result;
+    }
+    const Stream& stream = *streams[stream_id];
+    std::lock_guard<std::mutex> lock(mutex);
+    result.encoded = stream.encoded;
+    result.skipped = stream.skipped.load(std::memory_order_relaxed);
+    result.dropped = stream.dropped;
+    result.clips = stream.clips;
+    result.ring_bytes = stream.ring_bytes;
+    return result;
+}
+
+std::vector<std::string> ClipRecorder::clips() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return finished;
+}
@@ -0,0 +1,126 @@
+#include "detector.h"
+#include "opencv_detector.h"
+#include "tiled_detector.h"
+#ifdef HAVE_ONNXRUNTIME
+#include "yolo_detector.h"
+#endif
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+
+int countPersons(const std::vector<Detection>& detections, float min_confidence) {
+    int person_count = 0;
+    for (const auto& det : detections) {
+        if (det.class_id == 0 && det.confidence > min_confidence) {
+            person_count++;
+        }
+    }
+    return person_count;
+}
+
+void Detector::detectBatch(const std::vector<cv::Mat>& frames,
+                           std::vector<std::vector<Detection>>& results) {
+    results.resize(frames.size());
+    DetectTimings total;
+    for (size_t i = 0; i < frames.size(); ++i) {
+        results[i] = detect(frames[i]);
+        total.preprocess_us += timings.preprocess_us;
+        total.forward_us += timings.forward_us;
+        total.decode_us += timings.decode_us;
+        total.nms_us += timings.nms_us;
+    }
+    timings = total;
+}
+
+std::vector<std::string> availableBackends() {
+    std::vector<std::string> backends = {"opencv"};
+#ifdef HAVE_ONNXRUNTIME
+    backends.push_back("onnxruntime");
+#endif
+    return backends;
+}
+
+bool isOnnxRuntimeBackend(const std::string& backend) {
+    return backend == "onnxruntime" || backend == "ort";
+}
+
+std::string resolveModelPath(const DetectorConfig& config) {
+    std::vector<std::string> model_paths;
+    if (!config.model_path.empty()) {
+        model_paths.push_back(config.model_path);
+    } else {
+        std::string file = config.precision == "fp32" ? "yolov8s.onnx"
+                                                      : "yolov8s-" + config.precision + ".onnx";
+        model_paths = {file, "models/" + file};
+    }
+    
+    std::string tried;
+    for (const auto& model_path : model_paths) {
+        std::error_code ec;
+        if (std::filesystem::is_regular_file(model_path, ec)) {
+            return model_path;
+        }
+        tried += (tried.empty() ? "" : ", ") + model_path;
+    }
+    std::cerr << "Model file not found (tried " << tried << "); set --model or YOLO_MODEL_PATH"
+              << std::endl;
+    return "";
+}
+
+void warmUpDetector(Detector& detector, int runs) {
+    std::vector<cv::Mat> frames(std::max(1, detector.maxBatchSize()), cv::Mat::zeros(480, 640, CV_8UC3));
+    std::vector<std::vector<Detection>> results;
+    for (int i = 0; i < runs; ++i) {
+        detector.detectBatch(frames, results);
+    }
+}
+
+std::unique_ptr<Detector> createDetector(const DetectorConfig& config) {
+    if (config.tiling.enabled) {
+        // One backend instance per parallel tile worker
+        DetectorConfig tile_config = config;
+        tile_config.tiling.enabled = false;
+        std::vector<std::unique_ptr<Detector>> detectors;
+        for (int i = 0; i < std::max(1, config.tiling.workers); ++i) {
+            std::unique_ptr<Detector> detector = createDetector(tile_config);
+            if (!detector) {
+                return nullptr;
+            }
+            detectors.push_back(std::move(detector));
+        }
+        return std::make_unique<TiledDetector>(std::move(detectors), config.tiling, config.nms);
+    }
+
+    std::string model_path = resolveModelPath(config);
+    if (model_path.empty()) {
+        std::cerr << "Warning: YOLO model not found. Running detection-free mode." << std::endl;
+        return nullptr;
+    }
+    
+    std::unique_ptr<Detector> detector;
+    if (config.backend == "opencv") {
+        detector = std::make_unique<OpenCVDetector>(model_path, config);
+    } else if (isOnnxRuntimeBackend(config.backend)) {
+#ifdef HAVE_ONNXRUNTIME
+        detector = std::make_unique<YOLODetector>(model_path, config);
+#else
+        std::cerr << "Detector backend 'onnxruntime' is not compiled in "
+                  << "(configure with -DWITH_ONNXRUNTIME=ON)" << std::endl;
+        return nullptr;
+#endif
+    } else {
+        std::cerr << "Unknown detector backend: " << config.backend << std::endl;
+        return nullptr;
+    }
+    
+    if (detector->isInitialized() && config.warmup_runs > 0) {
+        auto start = std::chrono::steady_clock::now();
+        warmUpDetector(*detector, config.warmup_runs);
+        std::cout << "Warm-up: " << config.warmup_runs << " pass(es) in "
+                  << std::chrono::duration_cast<std::chrono::milliseconds>(
+                         std::chrono::steady_clock::now() - start).count()
+                  << " ms" << std::endl;
+    }
+    return detector;
+}
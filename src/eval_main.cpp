@@ -0,0 +1,330 @@
+// Model evaluation: replays a labelled clip through each model variant
+// (e.g. FP32, FP16 and INT8 exports) and reports person-detection
+// precision/recall against the ground truth, their change relative to the
+// first model, and per-frame detection latency.
+#include "app_config.h"
+#include "detector.h"
+#include "frame_source.h"
+#include "latency_histogram.h"
+#include "tracker.h"
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct EvalOptions {
+    std::string input;                // any recorded frame source
+    std::string labels;
+    std::vector<std::string> models;  // the first one is the baseline
+    float match_iou = 0.5f;
+    int max_frames = 0;               // labelled frames evaluated, 0 = all
+    float min_precision = 0.0f;       // accuracy bar for the recommendation
+    float min_recall = 0.0f;
+    std::string csv_path;
+};
+
+// Person boxes per labelled frame; a frame listed without a box has none
+using GroundTruth = std::map<int, std::vector<Detection>>;
+
+struct ModelResult {
+    std::string model;
+    bool loaded = false;
+    double load_ms = 0.0;
+    int frames = 0;
+    uint64_t true_positives = 0;
+    uint64_t false_positives = 0;
+    uint64_t false_negatives = 0;
+    std::unique_ptr<LatencyHistogram> latency = std::make_unique<LatencyHistogram>();
+    std::unique_ptr<LatencyHistogram> forward = std::make_unique<LatencyHistogram>();
+
+    double precision() const {
+        uint64_t found = true_positives + false_positives;
+        return found ? (double)true_positives / found : 1.0;
+    }
+    double recall() const {
+        uint64_t expected = true_positives + false_negatives;
+        return expected ? (double)true_positives / expected : 1.0;
+    }
+};
+
+void printUsage() {
+    std::cout << "Usage: wxapp_eval [options] --input=CLIP --labels=FILE MODEL.onnx...\n"
+                 "  --input=CLIP        video file, image sequence (e.g. frames/%04d.png) or .raw file\n"
+                 "  --labels=FILE       ground truth CSV: frame,x,y,width,height per person,\n"
+                 "                      frames counted from 1; \"frame\" alone = no persons\n"
+                 "  --iou=F             overlap for a detection to match a person (default 0.5)\n"
+                 "  --max-frames=N      stop after N labelled frames\n"
+                 "  --min-precision=F   accuracy bar for picking a model (default 0)\n"
+                 "  --min-recall=F\n"
+                 "  --csv=FILE          also write the summary as CSV\n"
+                 "The first model is the baseline for the precision/recall deltas.\n"
+              << appConfigUsage();
+}
+
+bool loadGroundTruth(const std::string& path, GroundTruth& truth, std::string& error) {
+    std::ifstream in(path);
+    if (!in) {
+        error = "Cannot open " + path;
+        return false;
+    }
+    std::string line;
+    int line_number = 0;
+    while (std::getline(in, line)) {
+        line_number++;
+        if (line.empty() || !std::isdigit((unsigned char)line[0])) {
+            continue;  // header or comment
+        }
+        std::vector<std::string> fields;
+        std::istringstream row(line);
+        std::string field;
+        while (std::getline(row, field, ',')) {
+            fields.push_back(field);
+        }
+        try {
+            int frame = std::stoi(fields[0]);
+            std::vector<Detection>& boxes = truth[frame];
+            if (fields.size() >= 5 && !fields[1].empty()) {
+                Detection box{std::stof(fields[1]), std::stof(fields[2]),
+                              std::stof(fields[3]), std::stof(fields[4]), 1.0f, 0};
+                boxes.push_back(box);
+            }
+        } catch (const std::exception&) {
+            error = path + ":" + std::to_string(line_number) + ": expected frame,x,y,width,height";
+            return false;
+        }
+    }
+    if (truth.empty()) {
+        error = path + " has no labelled frames";
+        return false;
+    }
+    return true;
+}
+
+// Greedy matching, most confident detection first, each person at most once
+void scoreFrame(std::vector<Detection> detections, const std::vector<Detection>& truth,
+                float min_confidence, float match_iou, ModelResult& result) {
+    detections.erase(std::remove_if(detections.begin(), detections.end(),
+                                    [&](const Detection& det) {
+                                        return det.class_id != 0 || det.confidence <= min_confidence;
+                                    }),
+                     detections.end());
+    std::sort(detections.begin(), detections.end(),
+              [](const Detection& a, const Detection& b) { return a.confidence > b.confidence; });
+
+    std::vector<bool> matched(truth.size(), false);
+    for (const auto& det : detections) {
+        int best = -1;
+        float best_iou = match_iou;
+        for (size_t t = 0; t < truth.size(); ++t) {
+            float iou = matched[t] ? 0.0f : boxIoU(det, truth[t]);
+            if (iou >= best_iou) {
+                best = (int)t;
+                best_iou = iou;
+            }
+        }
+        if (best >= 0) {
+            matched[best] = true;
+            result.true_positives++;
+        } else {
+            result.false_positives++;
+        }
+    }
+    result.false_negatives += std::count(matched.begin(), matched.end(), false);
+}
+
+void evaluateModel(const EvalOptions& options, const DetectorConfig& base_config,
+                   const GroundTruth& truth, ModelResult& result) {
+    DetectorConfig config = base_config;
+    config.model_path = result.model;
+
+    auto start = std::chrono::steady_clock::now();
+    std::unique_ptr<Detector> detector = createDetector(config);
+    result.load_ms = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+    if (!detector || !detector->isInitialized()) {
+        std::cerr << "Skipping " << result.model << ": failed to load" << std::endl;
+        return;
+    }
+    result.loaded = true;
+
+    FrameSourceOptions source_options;
+    source_options.pacing = Pacing::Max;
+    std::string error;
+    std::unique_ptr<FrameSource> source = openFrameSource(options.input, source_options, error);
+    if (!source) {
+        std::cerr << "Failed to open " << options.input << ": " << error << std::endl;
+        result.loaded = false;
+        return;
+    }
+
+    // Only labelled frames are decoded in full and detected; decoding is not timed
+    const int last_frame = truth.rbegin()->first;
+    cv::Mat frame;
+    FrameTime time;
+    for (int frame_number = 1; frame_number <= last_frame; ++frame_number) {
+        auto labelled = truth.find(frame_number);
+        if (labelled == truth.end()) {
+            if (!source->skip()) {
+                break;
+            }
+            continue;
+        }
+        if (!source->read(frame, time)) {
+            break;
+        }
+
+        StageTimer timer;
+        std::vector<Detection> detections = detector->detect(frame);
+        result.latency->record(timer.lap());
+        result.forward->record(detector->lastTimings().forward_us);
+
+        scoreFrame(std::move(detections), labelled->second, config.confidence_threshold,
+                   options.match_iou, result);
+        result.frames++;
+        if (options.max_frames > 0 && result.frames >= options.max_frames) {
+            break;
+        }
+    }
+}
+
+bool parseEvalOptions(int argc, char** argv, EvalOptions& options,
+                      std::vector<std::string>& config_args) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        try {
+            if (arg == "--help" || arg == "-h") {
+                return false;
+            } else if (arg.rfind("--input=", 0) == 0) {
+                options.input = arg.substr(8);
+            } else if (arg.rfind("--labels=", 0) == 0) {
+                options.labels = arg.substr(9);
+            } else if (arg.rfind("--iou=", 0) == 0) {
+                options.match_iou = std::stof(arg.substr(6));
+            } else if (arg.rfind("--max-frames=", 0) == 0) {
+                options.max_frames = std::max(0, std::stoi(arg.substr(13)));
+            } else if (arg.rfind("--min-precision=", 0) == 0) {
+                options.min_precision = std::stof(arg.substr(16));
+            } else if (arg.rfind("--min-recall=", 0) == 0) {
+                options.min_recall = std::stof(arg.substr(13));
+            } else if (arg.rfind("--csv=", 0) == 0) {
+                options.csv_path = arg.substr(6);
+            } else if (arg.rfind("--", 0) == 0) {
+                config_args.push_back(arg);
+            } else {
+                options.models.push_back(arg);
+            }
+        } catch (const std::exception&) {
+            std::cerr << "Invalid value in " << arg << std::endl;
+            return false;
+        }
+    }
+    return !options.input.empty() && !options.labels.empty() && !options.models.empty();
+}
+
+void writeCsv(std::ostream& out, const std::vector<ModelResult>& results) {
+    out << "Model,Frames,Precision,Recall,Delta_Precision,Delta_Recall,"
+           "P50_ms,P95_ms,P99_ms,Mean_ms,Forward_P50_ms,Load_ms\n";
+    const ModelResult& baseline = results.front();
+    for (const auto& result : results) {
+        if (!result.loaded) {
+            continue;
+        }
+        LatencyHistogram::Summary s = result.latency->summary();
+        out << result.model << "," << result.frames << "," << result.precision() << ","
+            << result.recall() << "," << result.precision() - baseline.precision() << ","
+            << result.recall() - baseline.recall() << "," << s.p50_ms << "," << s.p95_ms << ","
+            << s.p99_ms << "," << s.mean_ms << "," << result.forward->percentileMs(50) << ","
+            << result.load_ms << "\n";
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    EvalOptions options;
+    std::vector<std::string> config_args;
+    if (!parseEvalOptions(argc, argv, options, config_args)) {
+        printUsage();
+        return 1;
+    }
+
+    AppConfig config;
+    std::string error;
+    if (!parseAppConfig(config_args, config, error)) {
+        std::cerr << error << "\n\n";
+        printUsage();
+        return 1;
+    }
+    // Latency per frame, one frame per forward pass like the live pipeline
+    config.detector.max_batch = 1;
+    // Measured on the cores and thread pools the live pipeline would use
+    ThreadLayout layout = applyThreadLayout(config);
+    std::cout << formatThreadLayout(layout);
+    pinCurrentThread(layout.inference_cpus);
+    if (layout.opencv_threads > 0) {
+        cv::setNumThreads(layout.opencv_threads);
+    }
+
+    GroundTruth truth;
+    if (!loadGroundTruth(options.labels, truth, error)) {
+        std::cerr << error << std::endl;
+        return 2;
+    }
+    std::cout << "Evaluating " << options.models.size() << " model(s) on " << truth.size()
+              << " labelled frame(s), backend " << config.detector.backend << std::endl;
+
+    std::vector<ModelResult> results(options.models.size());
+    for (size_t i = 0; i < options.models.size(); ++i) {
+        results[i].model = options.models[i];
+        evaluateModel(options, config.detector, truth, results[i]);
+    }
+
+    const ModelResult& baseline = results.front();
+    std::printf("\n%-32s %6s %6s %7s %7s %8s %8s %8s %8s\n", "Model", "Prec", "Recall",
+                "dPrec", "dRecall", "p50 ms", "p95 ms", "p99 ms", "fwd p50");
+    const ModelResult* pick = nullptr;
+    for (const auto& result : results) {
+        if (!result.loaded) {
+            std::printf("%-32s failed to load\n", result.model.c_str());
+            continue;
+        }
+        LatencyHistogram::Summary s = result.latency->summary();
+        std::printf("%-32s %6.3f %6.3f %+7.3f %+7.3f %8.1f %8.1f %8.1f %8.1f\n",
+                    result.model.c_str(), result.precision(), result.recall(),
+                    result.precision() - baseline.precision(), result.recall() - baseline.recall(),
+                    s.p50_ms, s.p95_ms, s.p99_ms, result.forward->percentileMs(50));
+        if (result.precision() >= options.min_precision && result.recall() >= options.min_recall &&
+            (!pick || s.p50_ms < pick->latency->percentileMs(50))) {
+            pick = &result;
+        }
+    }
+
+    if (!options.csv_path.empty()) {
+        std::ofstream csv(options.csv_path);
+        if (!csv.is_open()) {
+            std::cerr << "Failed to create " << options.csv_path << std::endl;
+            return 2;
+        }
+        writeCsv(csv, results);
+    }
+
+    if (!pick) {
+        std::printf("\nNo model meets precision >= %.3f and recall >= %.3f\n",
+                    options.min_precision, options.min_recall);
+        return 3;
+    }
+    std::printf("\nFastest meeting precision >= %.3f and recall >= %.3f: %s (p50 %.1f ms)\n",
+                options.min_precision, options.min_recall, pick->model.c_str(),
+                pick->latency->percentileMs(50));
+    return 0;
+}
@@ -1,18 +1,17 @@
 #include "frame.h"
+#include "timestamp.h"
 #include <iostream>
 #include <fstream>
-#include <sstream>
-#include <iomanip>
-#include <ctime>
 #include <algorithm>
+#include <cmath>
 
-MyFrame::MyFrame(const wxString& title)
+MyFrame::MyFrame(const wxString& title, const AppConfig& config)
     : wxFrame(NULL, wxID_ANY, title, wxDefaultPosition, wxSize(1200, 700)),
-      m_timer(this, wxID_ANY), m_camera_running(false), m_frame_count(0), m_fps_counter(0),
-      m_yolo_initialized(false) {
+      m_config(config), m_camera_running(false), m_update_posted(false),
+      m_yolo_initialized(false), m_model_loading(false),
+      m_launch_time(std::chrono::steady_clock::now()), m_model_ready_ms(-1.0),
+      m_first_detection_ms(-1.0) {
     
-    // Initialize YOLO
-    InitializeYOLO();
     // Create main panel
     wxPanel* panel = new wxPanel(this);
     wxBoxSizer* mainSizer = new wxBoxSizer(wxHORIZONTAL);
@@ -20,22 +19,31 @@ MyFrame::MyFrame(const wxString& title)
     // ==================== LEFT SIDE - VIDEO DISPLAY ====================
     wxBoxSizer* leftSizer = new wxBoxSizer(wxVERTICAL);
     
-    // Camera selection
+    // Camera selection; every checked camera streams at once. With
+    // --sources the list holds those (files, synthetic, ...) instead.
     wxBoxSizer* cameraSizer = new wxBoxSizer(wxHORIZONTAL);
-    wxStaticText* cameraLabel = new wxStaticText(panel, wxID_ANY, "Camera:");
-    wxString cameras[] = {"Camera 0", "Camera 1", "Camera 2"};
-    m_cameraChoice = new wxComboBox(panel, wxID_ANY, "Camera 0", wxDefaultPosition, 
-                                    wxDefaultSize, 3, cameras, wxCB_READONLY);
+    wxStaticText* cameraLabel = new wxStaticText(panel, wxID_ANY,
+                                                 m_config.sources.empty() ? "Cameras:" : "Sources:");
+    wxArrayString cameras;
+    for (const auto& spec : m_config.sources) {
+        cameras.Add(wxString(spec));
+    }
+    for (int i = 0; m_config.sources.empty() && i < 8; ++i) {
+        cameras.Add(wxString::Format("Camera %d", i));
+    }
+    m_cameraList = new wxCheckListBox(panel, wxID_ANY, wxDefaultPosition, wxSize(-1, 70), cameras);
+    for (unsigned int i = 0; i < (m_config.sources.empty() ? 1u : m_cameraList->GetCount()); ++i) {
+        m_cameraList->Check(i);
+    }
     cameraSizer->Add(cameraLabel, 0, wxALL | wxALIGN_CENTER_VERTICAL, 5);
-    cameraSizer->Add(m_cameraChoice, 1, wxALL | wxEXPAND, 5);
+    cameraSizer->Add(m_cameraList, 1, wxALL | wxEXPAND, 5);
     leftSizer->Add(cameraSizer, 0, wxALL | wxEXPAND, 5);
     
-    // Video display
+    // Video display: one tile per streaming camera
     wxStaticBoxSizer* videoBorder = new wxStaticBoxSizer(wxVERTICAL, panel, "Live Camera Feed");
-    wxBitmap placeholder(640, 480);
-    m_imageCtrl = new wxStaticBitmap(panel, wxID_ANY, placeholder);
-    m_imageCtrl->SetMinSize(wxSize(640, 480));
-    videoBorder->Add(m_imageCtrl, 1, wxALL | wxEXPAND, 5);
+    m_videoPanel = new wxPanel(panel, wxID_ANY);
+    m_videoPanel->SetMinSize(wxSize(640, 480));
+    videoBorder->Add(m_videoPanel, 1, wxALL | wxEXPAND, 5);
     leftSizer->Add(videoBorder, 1, wxALL | wxEXPAND, 10);
     
     // ==================== RIGHT SIDE - CONTROLS & INFO ====================
@@ -61,8 +69,10 @@ MyFrame::MyFrame(const wxString& title)
     // Information box
     wxStaticBoxSizer* infoBorder = new wxStaticBoxSizer(wxVERTICAL, panel, "Status");
     wxString infoText = "Status: Ready\nFrames: 0\nFPS: 0\nUptime: 00:00:00";
-    m_textCtrl = new wxTextCtrl(panel, wxID_ANY, infoText, wxDefaultPosition, wxSize(400, 100),
+    m_textCtrl = new wxTextCtrl(panel, wxID_ANY, infoText, wxDefaultPosition, wxSize(400, 300),
                                 wxTE_MULTILINE | wxTE_READONLY | wxTE_WORDWRAP);
+    // Monospace keeps the latency table columns aligned
+    m_textCtrl->SetFont(wxFont(9, wxFONTFAMILY_TELETYPE, wxFONTSTYLE_NORMAL, wxFONTWEIGHT_NORMAL));
     infoBorder->Add(m_textCtrl, 0, wxALL | wxEXPAND, 5);
     rightSizer->Add(infoBorder, 0, wxALL | wxEXPAND, 5);
     
@@ -102,53 +112,91 @@ MyFrame::MyFrame(const wxString& title)
     Bind(wxEVT_BUTTON, &MyFrame::OnExportLog, this, m_exportBtn->GetId());
     Bind(wxEVT_BUTTON, &MyFrame::OnClearLog, this, m_clearBtn->GetId());
     Bind(wxEVT_BUTTON, &MyFrame::OnQuit, this, wxID_EXIT);
-    Bind(wxEVT_TIMER, &MyFrame::OnTimer, this);
+
+    // Capture and inference run on pipeline threads; only finished frames reach the GUI.
+    // Each inference worker needs its own detector; the first one to ask
+    // reuses the detector loaded below, and none are loaded if that one
+    // failed. Workers call this on their own threads, never on the GUI thread.
+    m_pipeline = std::make_unique<FramePipeline>(
+        [this]() -> std::unique_ptr<Detector> {
+            {
+                std::lock_guard<std::mutex> lock(m_detector_mutex);
+                if (m_detector) {
+                    return std::move(m_detector);
+                }
+            }
+            return m_yolo_initialized ? createDetector(m_config.detector) : nullptr;
+        },
+        [this](ProcessedFrame&& processed) { OnPipelineResult(std::move(processed)); },
+        [this](int stream_id, const std::string& message) { OnPipelineError(stream_id, message); },
+        m_config.pipeline);
+    
+    if (m_config.metrics.port > 0) {
+        m_metrics_server = std::make_unique<MetricsServer>([this]() { return m_metrics.render(); });
+        std::string error;
+        if (m_metrics_server->start(m_config.metrics.address, m_config.metrics.port, error)) {
+            std::cout << "Metrics at http://" << m_config.metrics.address << ":"
+                      << m_metrics_server->port() << "/metrics" << std::endl;
+        } else {
+            std::cerr << error << std::endl;
+            m_metrics_server.reset();
+        }
+    }
+    
+    // The window shows right away; Start Camera is enabled once the model is ready
+    LoadDetectorAsync();
     
-    std::cout << "Camera application initialized - ready to stream" << std::endl;
+    std::cout << "Camera application initialized" << std::endl;
 }
 
 MyFrame::~MyFrame() {
-    if (m_camera_running) {
-        m_timer.Stop();
-        if (m_cap.isOpened()) {
-            m_cap.release();
-        }
+    if (m_model_thread.joinable()) {
+        m_model_thread.join();
     }
+    m_metrics_server.reset();
+    // Join the pipeline threads before any member they touch goes away
+    if (m_pipeline) {
+        m_pipeline->stop();
+    }
+    m_clip_recorder.reset();
+    m_log_writer.reset();
 }
 
 wxString MyFrame::GetCurrentTimestamp() {
-    auto now = std::chrono::system_clock::now();
-    auto time = std::chrono::system_clock::to_time_t(now);
-    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()) % 1000;
-    
-    std::stringstream ss;
-    ss << std::put_time(std::localtime(&time), "%Y-%m-%d %H:%M:%S")
-       << "." << std::setfill('0') << std::setw(3) << ms.count();
-    
-    return wxString(ss.str());
-}
-
-void MyFrame::LogFrame(int frame_num, int person_count) {
-    FrameLog log;
-    log.timestamp = GetCurrentTimestamp();
-    log.frame_number = frame_num;
-    log.person_count = person_count;
-    m_frame_logs.push_back(log);
-    UpdateLogDisplay();
+    return wxString(formatTimestamp(std::chrono::system_clock::now()));
 }
 
 void MyFrame::UpdateLogDisplay() {
-    wxString logText;
+    // Merge the newest entries of every camera; only these get formatted
+    std::vector<std::pair<FrameLog, int>> recent;
+    std::vector<FrameLog> entries;
+    for (size_t i = 0; i < m_views.size(); ++i) {
+        const FrameLogRing& ring = m_logs[i]->ring;
+        entries.clear();
+        ring.read(std::max(ring.begin(), ring.end() - std::min<uint64_t>(ring.end(), 20)), entries);
+        for (const auto& log : entries) {
+            recent.push_back({log, m_views[i].camera_index});
+        }
+    }
+    std::stable_sort(recent.begin(), recent.end(), [](const auto& a, const auto& b) {
+        return a.first.timestamp_ns < b.first.timestamp_ns;
+    });
     
     // Show last 20 frames
-    int start = std::max(0, (int)m_frame_logs.size() - 20);
+    wxString logText;
+    size_t start = recent.size() > 20 ? recent.size() - 20 : 0;
     
-    for (int i = start; i < (int)m_frame_logs.size(); ++i) {
-        const auto& log = m_frame_logs[i];
-        wxString line = wxString::Format("[%s] Frame: %d | Persons: %d\n",
-                                        log.timestamp,
+    for (size_t i = start; i < recent.size(); ++i) {
+        const FrameLog& log = recent[i].first;
+        wxString line = wxString::Format("[%s] Cam %d | Frame: %d | Persons: %d",
+                                        wxString(formatLogTime(log)),
+                                        recent[i].second,
                                         log.frame_number,
                                         log.person_count);
+        if (log.unique_persons >= 0) {
+            line += wxString::Format(" | Unique: %d", log.unique_persons);
+        }
+        line += "\n";
         logText += line;
     }
     
@@ -156,60 +204,156 @@ void MyFrame::UpdateLogDisplay() {
     m_logCtrl->SetInsertionPointEnd();
 }
 
+bool MyFrame::HasFrameLogs() const {
+    for (size_t i = 0; i < m_views.size(); ++i) {
+        if (m_logs[i]->ring.size() > 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
 void MyFrame::OnStartCamera(wxCommandEvent& event) {
-    // Get selected camera
-    int camera_idx = m_cameraChoice->GetSelection();
+    if (m_model_loading) {
+        return;
+    }
     
-    // Open camera
-    m_cap.open(camera_idx);
+    // Get selected cameras or sources; either way the list position is the stream's id
+    std::vector<StreamSource> sources;
+    for (unsigned int i = 0; i < m_cameraList->GetCount(); ++i) {
+        if (m_cameraList->IsChecked(i)) {
+            std::string spec = m_config.sources.empty() ? std::to_string(i) : m_config.sources[i];
+            sources.push_back({(int)i, spec});
+        }
+    }
+    if (sources.empty()) {
+        wxMessageBox("Select at least one camera.", "Camera Error", wxOK | wxICON_ERROR);
+        return;
+    }
     
-    if (!m_cap.isOpened()) {
-        wxMessageBox("Failed to open camera " + std::to_string(camera_idx) + "!\n"
-                    "Make sure your camera is connected and not in use.",
+    // The previous session's views and logs go now, so a start that fails
+    // leaves nothing behind to show, log or export
+    m_views.clear();
+    m_log_writer.reset();
+    m_logs.clear();
+    
+    // Open cameras and start the capture threads and inference pool
+    m_stream_start_time = std::chrono::steady_clock::now();
+    m_first_detection_ms = -1.0;
+    std::vector<int> failed;
+    if (!m_pipeline->start(sources, &failed)) {
+        wxMessageBox("Failed to open the selected camera(s)!\n"
+                    "Make sure your cameras are connected and not in use.",
                     "Camera Error", wxOK | wxICON_ERROR);
         return;
     }
     
-    // Set camera properties
-    m_cap.set(cv::CAP_PROP_FRAME_WIDTH, 640);
-    m_cap.set(cv::CAP_PROP_FRAME_HEIGHT, 480);
-    m_cap.set(cv::CAP_PROP_FPS, 30);
-    m_cap.set(cv::CAP_PROP_BUFFERSIZE, 1);
-    
     m_camera_running = true;
-    m_frame_count = 0;
-    m_fps_counter = 0;
     m_start_time = std::chrono::high_resolution_clock::now();
-    m_fps_time = std::chrono::high_resolution_clock::now();
-    m_frame_logs.clear();
+    m_metrics.attach(m_pipeline.get());
+    m_views.assign(m_pipeline->streamCount(), CameraView());
+    for (size_t i = 0; i < m_views.size(); ++i) {
+        m_views[i].camera_index = m_pipeline->cameraIndex((int)i);
+    }
+    // Encodes and saves clips on its own threads; workers only hand it frames
+    std::unique_ptr<ClipRecorder> clip_recorder;
+    if (m_config.clips.enabled) {
+        clip_recorder = std::make_unique<ClipRecorder>(m_config.clips);
+        for (const auto& view : m_views) {
+            clip_recorder->addStream(view.camera_index);
+        }
+        if (!clip_recorder->start()) {
+            clip_recorder.reset();
+        }
+    }
+    // One log ring per opened camera. Workers are already running, so the
+    // logs are swapped in under the same lock their results take.
+    std::vector<std::unique_ptr<CameraLog>> logs;
+    for (size_t i = 0; i < m_views.size(); ++i) {
+        logs.push_back(std::make_unique<CameraLog>(m_config.log.capacity));
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_result_mutex);
+        m_pending.assign(m_views.size(), PendingResult());
+        m_logs.swap(logs);
+        m_clip_recorder = std::move(clip_recorder);
+    }
+    CreateVideoTiles();
+    
+    // Saves every log entry on its own thread; the GUI never writes frame logs itself
+    if (m_config.log.spill == LogSpill::Disk) {
+        m_log_writer = std::make_unique<FrameLogWriter>(m_config.log);
+        for (size_t i = 0; i < m_views.size(); ++i) {
+            m_log_writer->addSource(m_views[i].camera_index, m_logs[i]->ring);
+        }
+        if (!m_log_writer->start()) {
+            m_log_writer.reset();
+        }
+    }
     
     m_startBtn->Disable();
     m_stopBtn->Enable();
-    m_cameraChoice->Disable();
+    m_cameraList->Disable();
     
-    m_logCtrl->SetValue("Camera connected. Streaming...\n");
+    wxString message = wxString::Format("%d camera(s) connected. Streaming...\n", (int)m_views.size());
+    for (int id : failed) {
+        message += m_cameraList->GetString(id) + " could not be opened.\n";
+    }
+    m_logCtrl->SetValue(message);
     
-    // Start timer for video capture (30 FPS = 33ms)
-    m_timer.Start(33, wxTIMER_CONTINUOUS);
+    std::cout << "Cameras started: " << m_views.size() << std::endl;
+}
+
+// Lays out one tile per camera in a near-square grid
+void MyFrame::CreateVideoTiles() {
+    m_videoPanel->DestroyChildren();
+    
+    int count = std::max(1, (int)m_views.size());
+    int cols = (int)std::ceil(std::sqrt((double)count));
+    wxGridSizer* grid = new wxGridSizer(cols, 2, 2);
+    wxSize tile_size(640 / cols, 480 / cols);
+    
+    for (size_t i = 0; i < m_views.size(); ++i) {
+        CameraView& view = m_views[i];
+        view.tile = new VideoPanel(m_videoPanel, tile_size);
+        view.tile->SetLatencies(&m_pipeline->latencies((int)i));
+        grid->Add(view.tile, 1, wxEXPAND);
+    }
     
-    std::cout << "Camera started: " << camera_idx << std::endl;
+    m_videoPanel->SetSizer(grid, true);
+    m_videoPanel->Layout();
 }
 
 void MyFrame::OnStopCamera(wxCommandEvent& event) {
-    m_timer.Stop();
-    if (m_cap.isOpened()) {
-        m_cap.release();
+    StopStreaming();
+}
+
+void MyFrame::StopStreaming() {
+    m_pipeline->stop();
+    m_metrics.detach();
+    // The tiles stay on screen, but the next start() frees the histograms
+    // they record into; CreateVideoTiles attaches the new ones
+    for (auto& view : m_views) {
+        if (view.tile) {
+            view.tile->SetLatencies(nullptr);
+        }
+    }
+    if (m_log_writer) {
+        m_log_writer->stop();
+    }
+    if (m_clip_recorder) {
+        m_clip_recorder->stop();  // saves what open clips have so far
     }
     
     m_camera_running = false;
     m_startBtn->Enable();
     m_stopBtn->Disable();
-    m_cameraChoice->Enable();
+    m_cameraList->Enable();
     
-    wxString statusText = wxString::Format(
-        "Status: Stopped\nTotal Frames: %d\nFrames Logged: %lu",
-        m_frame_count,
-        m_frame_logs.size());
+    wxString statusText = "Status: Stopped\n";
+    for (size_t i = 0; i < m_views.size(); ++i) {
+        statusText += FormatCameraStats(i);
+    }
     
     m_textCtrl->SetValue(statusText);
 }
@@ -219,7 +363,7 @@ void MyFrame::OnButtonClick(wxCommandEvent& event) {
 }
 
 void MyFrame::OnExportLog(wxCommandEvent& event) {
-    if (m_frame_logs.empty()) {
+    if (!HasFrameLogs()) {
         wxMessageBox("No frame logs to export!", "Info", wxOK | wxICON_INFORMATION);
         return;
     }
@@ -236,260 +380,361 @@ void MyFrame::OnExportLog(wxCommandEvent& event) {
 }
 
 void MyFrame::OnClearLog(wxCommandEvent& event) {
-    if (!m_frame_logs.empty()) {
+    if (HasFrameLogs()) {
         wxMessageDialog dlg(this, "Clear all frame logs?", "Confirm",
                            wxYES_NO | wxICON_QUESTION);
         if (dlg.ShowModal() == wxID_YES) {
-            m_frame_logs.clear();
+            // Entries still go to the log files first; exports skip them
+            if (m_log_writer) {
+                m_log_writer->flush();
+            }
+            int64_t now = epochNanoseconds(std::chrono::system_clock::now());
+            for (size_t i = 0; i < m_views.size(); ++i) {
+                m_logs[i]->ring.clear();
+                m_logs[i]->shown = m_logs[i]->ring.end();
+                m_logs[i]->cleared_ns = now;
+            }
             m_logCtrl->SetValue("");
         }
     }
 }
 
-void MyFrame::ExportLogToFile(const wxString& filename) {
-    std::ofstream file(filename.ToStdString());
-    
-    if (!file.is_open()) {
-        wxMessageBox("Failed to create file!", "Error", wxOK | wxICON_ERROR);
-        return;
+// "log.csv" for a single camera, "log_cam2.csv" when several are streaming
+wxString MyFrame::CameraFileName(const wxString& filename, size_t view) const {
+    if (m_views.size() <= 1) {
+        return filename;
     }
-    
-    // Write CSV header
-    file << "Timestamp,Frame_Number,Person_Count\n";
-    
-    // Write data
-    for (const auto& log : m_frame_logs) {
-        file << log.timestamp.ToStdString() << ","
-             << log.frame_number << ","
-             << log.person_count << "\n";
+    wxString suffix = wxString::Format("_cam%d", m_views[view].camera_index);
+    int dot = filename.Find('.', true);
+    int slash = filename.find_last_of("/\\");
+    if (dot == wxNOT_FOUND || dot < slash) {
+        return filename + suffix;
+    }
+    return filename.Left(dot) + suffix + filename.Mid(dot);
+}
+
+void MyFrame::ExportLogToFile(const wxString& filename) {
+    for (size_t i = 0; i < m_views.size(); ++i) {
+        wxString path = CameraFileName(filename, i);
+        std::ofstream file(path.ToStdString());
+        
+        if (!file.is_open()) {
+            wxMessageBox("Failed to create file " + path + "!", "Error", wxOK | wxICON_ERROR);
+            return;
+        }
+        
+        // Same CSV layout the batch tool writes, converted from this
+        // session's log files, or from the ring when nothing goes to disk
+        const CameraLog& log = *m_logs[i];
+        if (m_log_writer) {
+            m_log_writer->flush();
+            std::string error;
+            if (!convertFrameLogsToCsv(m_log_writer->files(m_views[i].camera_index), file, error,
+                                       log.cleared_ns)) {
+                wxMessageBox("Failed to read frame log: " + error, "Error", wxOK | wxICON_ERROR);
+                return;
+            }
+        } else {
+            std::vector<FrameLog> logs;
+            logs.reserve(log.ring.size());
+            log.ring.read(log.ring.begin(), logs);
+            writeFrameLogCsv(file, logs);
+        }
+        
+        file.close();
+        
+        // Per-stage latency summary next to the frame log
+        std::ofstream latency_file(path.ToStdString() + ".latency.csv");
+        if (latency_file.is_open()) {
+            m_pipeline->latencies((int)i).writeCsv(latency_file);
+        } else {
+            std::cerr << "Failed to write latency summary for " << path << std::endl;
+        }
     }
-    
-    file.close();
 }
 
 void MyFrame::OnQuit(wxCommandEvent& event) {
     if (m_camera_running) {
-        m_timer.Stop();
-        if (m_cap.isOpened()) {
-            m_cap.release();
-        }
+        m_pipeline->stop();
+        m_camera_running = false;
     }
     Close(true);
 }
 
-void MyFrame::OnTimer(wxTimerEvent& event) {
-    UpdateFrame();
+// Called on an inference worker; keeps only the newest frame of each camera for the GUI
+void MyFrame::OnPipelineResult(ProcessedFrame&& processed) {
+    m_metrics.observeResult(processed.stream_id, processed.person_count);
+    
+    std::lock_guard<std::mutex> lock(m_result_mutex);
+    if (processed.stream_id >= (int)m_pending.size()) {
+        return;
+    }
+    
+    // Log every 10th frame, even if the GUI skips displaying it. The lock
+    // only guards m_logs being set up by Start Camera; the GUI reads the ring
+    // without it, and formatting waits until it is shown or exported.
+    if (processed.frame_number % 10 == 0 && processed.stream_id < (int)m_logs.size()) {
+        FrameLog log;
+        log.timestamp_ns = epochNanoseconds(std::chrono::system_clock::now());
+        log.frame_number = processed.frame_number;
+        log.person_count = processed.person_count;
+        log.unique_persons = processed.unique_persons;
+        log.latency_us = (int32_t)std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - processed.capture_time).count();
+        m_logs[processed.stream_id]->ring.push(log);
+    }
+    if (m_clip_recorder) {
+        m_clip_recorder->push(processed.stream_id, processed.image, processed.person_count,
+                              processed.capture_time);
+    }
+    PendingResult& pending = m_pending[processed.stream_id];
+    pending.frame = std::move(processed);
+    pending.ready = true;
+    
+    if (!m_update_posted) {
+        m_update_posted = true;
+        CallAfter(&MyFrame::UpdateFrame);
+    }
 }
 
-void MyFrame::InitializeYOLO() {
-    try {
-        // Try to load YOLOv8s ONNX model using OpenCV DNN
-        std::vector<std::string> model_paths = {
-            "/home/hatem/CPP_wxwidgets/build/yolov8s.onnx",
-            "./yolov8s.onnx",
-            "yolov8s.onnx"
-        };
+// Called on a capture thread when its camera stops delivering frames
+void MyFrame::OnPipelineError(int stream_id, const std::string& message) {
+    CallAfter([this, stream_id, message]() {
+        if (!m_camera_running) {
+            return;
+        }
         
-        for (const auto& model_path : model_paths) {
-            std::cout << "Trying to load YOLO model from: " << model_path << std::endl;
-            
-            // Check if file exists
-            std::ifstream f(model_path);
-            if (!f.good()) {
-                std::cerr << "File not found: " << model_path << std::endl;
-                continue;
-            }
-            f.close();
-            
-            try {
-                m_net = cv::dnn::readNetFromONNX(model_path);
-                if (m_net.empty()) {
-                    std::cerr << "Failed to load network from " << model_path << std::endl;
-                    continue;
-                }
-                
-                m_net.setPreferableBackend(cv::dnn::DNN_BACKEND_DEFAULT);
-                m_net.setPreferableTarget(cv::dnn::DNN_TARGET_CPU);
-                
-                m_yolo_initialized = true;
-                std::cout << "✓ YOLO model loaded successfully from: " << model_path << std::endl;
+        // Keep the other cameras streaming; stop once none is left
+        for (int i = 0; i < m_pipeline->streamCount(); ++i) {
+            if (m_pipeline->isStreamRunning(i)) {
+                m_logCtrl->AppendText("[" + GetCurrentTimestamp() + "] " + message + "\n");
                 return;
-            } catch (const cv::Exception& e) {
-                std::cerr << "OpenCV error loading " << model_path << ": " << e.what() << std::endl;
             }
         }
+        StopStreaming();
+        wxMessageBox(message, "Camera Error", wxOK | wxICON_ERROR);
+    });
+}
+
+// Model loading, graph optimization and warm-up take seconds; they run on
+// their own thread while the window is already up
+void MyFrame::LoadDetectorAsync() {
+    m_model_loading = true;
+    m_startBtn->Disable();
+    m_textCtrl->SetValue(wxString::Format("Status: Loading model (%s)...\n",
+                                          wxString(m_config.detector.backend)));
+    
+    m_model_thread = std::thread([this]() {
+        // ONNX Runtime's pool threads start here and inherit the CPU set
+        pinCurrentThread(m_config.pipeline.inference_cpus);
+        auto start = std::chrono::steady_clock::now();
+        std::unique_ptr<Detector> detector;
+        try {
+            // Backend and model come from AppConfig (--backend / --model)
+            detector = createDetector(m_config.detector);
+        } catch (const std::exception& e) {
+            std::cerr << "Failed to initialize YOLO: " << e.what() << std::endl;
+        }
+        double load_ms = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - start).count();
         
-        std::cerr << "Warning: YOLO model not loaded. Running detection-free mode." << std::endl;
-        m_yolo_initialized = false;
-    } catch (const std::exception& e) {
-        std::cerr << "Failed to initialize YOLO: " << e.what() << std::endl;
-        m_yolo_initialized = false;
-    }
+        // CallAfter copies its functor; the detector travels in a shared holder
+        auto loaded = std::make_shared<std::unique_ptr<Detector>>(std::move(detector));
+        CallAfter([this, loaded, load_ms]() { OnDetectorLoaded(std::move(*loaded), load_ms); });
+    });
 }
 
-std::vector<Detection> MyFrame::DetectObjects(const cv::Mat& frame) {
-    std::vector<Detection> detections;
+void MyFrame::OnDetectorLoaded(std::unique_ptr<Detector> detector, double load_ms) {
+    m_model_thread.join();
+    m_model_loading = false;
+    m_detector = std::move(detector);
+    m_yolo_initialized = m_detector && m_detector->isInitialized();
+    m_model_ready_ms = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - m_launch_time).count();
+    if (m_yolo_initialized) {
+        m_metrics.setModelLoadMs(load_ms);
+    }
     
-    if (!m_yolo_initialized || m_net.empty()) {
-        return detections;
+    wxString message;
+    if (m_yolo_initialized) {
+        std::cout << "Detector backend: " << m_detector->name() << ", ready " << m_model_ready_ms
+                  << " ms after launch (load + warm-up " << load_ms << " ms)" << std::endl;
+        message = wxString::Format("Model ready in %.0f ms (%s)\n", load_ms,
+                                   wxString(m_detector->name()));
+    } else {
+        std::cerr << "Warning: YOLO model not loaded. Running detection-free mode." << std::endl;
+        m_detector.reset();
+        message = "Model not loaded, running without detection\n";
     }
+    m_textCtrl->SetValue("Status: Ready\n" + message);
+    m_logCtrl->AppendText("[" + GetCurrentTimestamp() + "] " + message);
+    m_startBtn->Enable();
     
-    try {
-        // Prepare input blob
-        cv::Mat blob = cv::dnn::blobFromImage(frame, 1.0 / 255.0, cv::Size(640, 640),
-                                             cv::Scalar(0, 0, 0), true, false);
-        
-        // Set input
-        m_net.setInput(blob);
-        
-        // Get output layer names
-        std::vector<cv::String> outNames = m_net.getUnconnectedOutLayersNames();
-        std::vector<cv::Mat> outs;
-        
-        // Forward pass
-        m_net.forward(outs, outNames);
-        
-        // Process detections
-        for (size_t i = 0; i < outs.size(); i++) {
-            float* data = (float*)outs[i].data;
-            int rows = outs[i].rows;
-            
-            for (int j = 0; j < rows; j++) {
-                // YOLOv8 output format: [cx, cy, w, h, conf_person, ...]
-                float conf = data[j * outs[i].cols + 4];
-                
-                if (conf > 0.5f) {  // Confidence threshold
-                    float cx = data[j * outs[i].cols + 0];
-                    float cy = data[j * outs[i].cols + 1];
-                    float w = data[j * outs[i].cols + 2];
-                    float h = data[j * outs[i].cols + 3];
-                    
-                    Detection det;
-                    det.x = cx;
-                    det.y = cy;
-                    det.width = w;
-                    det.height = h;
-                    det.confidence = conf;
-                    detections.push_back(det);
-                }
-            }
+    // After a restart by a supervisor, resume streaming without a click
+    if (!m_config.autostart_cameras.empty()) {
+        for (unsigned int i = 0; i < m_cameraList->GetCount(); ++i) {
+            bool selected = std::find(m_config.autostart_cameras.begin(),
+                                      m_config.autostart_cameras.end(),
+                                      (int)i) != m_config.autostart_cameras.end();
+            m_cameraList->Check(i, selected);
         }
-    } catch (const cv::Exception& e) {
-        std::cerr << "Detection error: " << e.what() << std::endl;
+        wxCommandEvent start;
+        OnStartCamera(start);
     }
-    
-    return detections;
 }
 
-void MyFrame::UpdateFrame() {
-    cv::Mat frame;
-    
-    if (!m_cap.read(frame)) {
-        wxMessageBox("Failed to read frame from camera!", "Camera Error", wxOK | wxICON_ERROR);
-        // Stop camera when frame read fails
-        m_timer.Stop();
-        if (m_cap.isOpened()) {
-            m_cap.release();
-        }
-        m_camera_running = false;
-        m_startBtn->Enable();
-        m_stopBtn->Disable();
-        m_cameraChoice->Enable();
+// Time to first detection, once per Start Camera: what a restart costs
+// before persons are counted again
+void MyFrame::ReportFirstDetection() {
+    if (m_first_detection_ms >= 0 || !m_yolo_initialized) {
         return;
     }
-    
-    // Resize frame to fit display
-    cv::Mat displayFrame;
-    cv::resize(frame, displayFrame, cv::Size(640, 480));
-    
-    // Increment frame counter
-    m_frame_count++;
-    m_fps_counter++;
-    
-    // Run object detection
-    std::vector<Detection> detections = DetectObjects(displayFrame);
-    int person_count = 0;
-    
-    // Draw detections
-    for (const auto& det : detections) {
-        if (det.confidence > 0.5f) {
-            person_count++;
-            int x = (int)(det.x - det.width / 2);
-            int y = (int)(det.y - det.height / 2);
-            int w = (int)det.width;
-            int h = (int)det.height;
-            
-            cv::rectangle(displayFrame, cv::Point(x, y), cv::Point(x + w, y + h),
-                         cv::Scalar(0, 255, 0), 2);
-            cv::putText(displayFrame, "Person: " + std::to_string((int)(det.confidence * 100)) + "%",
-                       cv::Point(x, y - 5), cv::FONT_HERSHEY_SIMPLEX, 0.5,
-                       cv::Scalar(0, 255, 0), 1);
+    for (size_t i = 0; i < m_views.size(); ++i) {
+        if (m_pipeline->stats((int)i).detections_run > 0) {
+            auto now = std::chrono::steady_clock::now();
+            m_first_detection_ms = std::chrono::duration<double, std::milli>(
+                now - m_stream_start_time).count();
+            double since_launch = std::chrono::duration<double, std::milli>(
+                now - m_launch_time).count();
+            std::cout << "First detection " << m_first_detection_ms << " ms after start, "
+                      << since_launch << " ms after launch" << std::endl;
+            m_logCtrl->AppendText(wxString::Format(
+                "[%s] First detection %.0f ms after start (%.0f ms after launch)\n",
+                GetCurrentTimestamp(), m_first_detection_ms, since_launch));
+            return;
         }
     }
-    
-    // Log every 10th frame
-    if (m_frame_count % 10 == 0) {
-        LogFrame(m_frame_count, person_count);
+}
+
+void MyFrame::UpdateFrame() {
+    std::vector<PendingResult> results;
+    {
+        std::lock_guard<std::mutex> lock(m_result_mutex);
+        m_update_posted = false;
+        results.resize(m_pending.size());
+        for (size_t i = 0; i < m_pending.size(); ++i) {
+            if (m_pending[i].ready) {
+                results[i].frame = std::move(m_pending[i].frame);
+                results[i].ready = true;
+                m_pending[i].ready = false;
+            }
+        }
     }
     
-    // Add timestamp and info to frame
-    wxString timestamp = GetCurrentTimestamp();
-    cv::putText(displayFrame, "Camera Feed - " + timestamp.ToStdString(),
-               cv::Point(10, 30), cv::FONT_HERSHEY_SIMPLEX, 0.6,
-               cv::Scalar(0, 255, 0), 2);
-    
-    cv::putText(displayFrame, "Frame: " + std::to_string(m_frame_count) + " | Persons: " + std::to_string(person_count),
-               cv::Point(10, 60), cv::FONT_HERSHEY_SIMPLEX, 0.5,
-               cv::Scalar(0, 255, 0), 1);
-    
-    // Calculate FPS
-    auto current_time = std::chrono::high_resolution_clock::now();
-    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
-        current_time - m_fps_time).count();
-    
-    float fps = 0;
-    if (elapsed >= 1000) {
-        fps = (m_fps_counter * 1000.0f) / elapsed;
-        m_fps_counter = 0;
-        m_fps_time = current_time;
+    // Ignore frames that were in flight when the cameras were stopped
+    if (!m_camera_running || results.size() != m_views.size()) {
+        return;
     }
     
-    cv::putText(displayFrame, "FPS: " + std::to_string((int)fps),
-               cv::Point(10, 90), cv::FONT_HERSHEY_SIMPLEX, 0.5,
-               cv::Scalar(0, 255, 0), 1);
+    bool new_logs = false;
+    for (size_t i = 0; i < results.size(); ++i) {
+        CameraView& view = m_views[i];
+        uint64_t logged = m_logs[i]->ring.end();
+        if (logged != m_logs[i]->shown) {
+            m_logs[i]->shown = logged;
+            new_logs = true;
+        }
+        if (!results[i].ready) {
+            continue;
+        }
+        
+        const ProcessedFrame& processed = results[i].frame;
+        view.frame_count = processed.frame_number;
+        view.person_count = processed.person_count;
+        view.unique_persons = processed.unique_persons;
+        view.fps = processed.fps;
+        
+        // Conversion, scaling and the overlay wait for the tile's next
+        // paint; frames replaced before then are never converted
+        view.tile->Overlay().Update(processed.detections, processed.frame_number,
+                                    processed.person_count, processed.fps, processed.hud);
+        view.tile->SetFrame(processed.image, processed.capture_time);
+    }
     
-    // Convert to wxBitmap and display
-    wxBitmap bitmap = MatToBitmap(displayFrame);
-    m_imageCtrl->SetBitmap(bitmap);
+    if (new_logs) {
+        UpdateLogDisplay();
+    }
+    ReportFirstDetection();
     
     // Calculate uptime
+    auto current_time = std::chrono::high_resolution_clock::now();
     auto uptime_duration = std::chrono::duration_cast<std::chrono::seconds>(
         current_time - m_start_time);
     int hours = uptime_duration.count() / 3600;
     int minutes = (uptime_duration.count() % 3600) / 60;
     int seconds = uptime_duration.count() % 60;
     
-    // Update info text
+    // Update info text: per-camera counters and backpressure, then the
+    // stage table of the camera with the worst end-to-end p95
     wxString infoText = wxString::Format(
-        "Status: RUNNING\nFrames: %d\nPersons: %d\nFPS: %.1f\nUptime: %02d:%02d:%02d",
-        m_frame_count,
-        person_count,
-        fps,
+        "Status: RUNNING\nCameras: %d | Workers: %d | Batch: %.1f/%d\nUptime: %02d:%02d:%02d\n",
+        (int)m_views.size(),
+        m_pipeline->workerCount(),
+        m_pipeline->averageBatchSize(),
+        m_config.pipeline.max_batch,
         hours, minutes, seconds);
+    if (m_first_detection_ms >= 0) {
+        infoText += wxString::Format("Startup: model %.0f ms | first detection %.0f ms\n",
+                                     m_model_ready_ms, m_first_detection_ms);
+    }
+    
+    size_t slowest = 0;
+    double slowest_p95 = -1.0;
+    for (size_t i = 0; i < m_views.size(); ++i) {
+        infoText += FormatCameraStats(i);
+        double p95 = m_pipeline->latencies((int)i).get(Stage::EndToEnd).percentileMs(95);
+        if (p95 > slowest_p95) {
+            slowest = i;
+            slowest_p95 = p95;
+        }
+    }
+    infoText += wxString::Format("\nSlowest: Cam %d\n", m_views[slowest].camera_index);
+    infoText += wxString(m_pipeline->latencies((int)slowest).formatTable());
     
     m_textCtrl->SetValue(infoText);
 }
 
-wxBitmap MyFrame::MatToBitmap(const cv::Mat& mat) {
-    cv::Mat rgbMat;
-    if (mat.channels() == 3) {
-        cv::cvtColor(mat, rgbMat, cv::COLOR_BGR2RGB);
-    } else if (mat.channels() == 1) {
-        cv::cvtColor(mat, rgbMat, cv::COLOR_GRAY2RGB);
-    } else {
-        rgbMat = mat;
+wxString MyFrame::FormatCameraStats(size_t view) const {
+    const CameraView& camera = m_views[view];
+    PipelineStats stats = m_pipeline->stats((int)view);
+    const LatencyHistogram& e2e = m_pipeline->latencies((int)view).get(Stage::EndToEnd);
+    uint64_t gated = stats.detections_run + stats.detections_skipped;
+    double skip_percent = gated ? 100.0 * stats.detections_skipped / gated : 0.0;
+    wxString persons = wxString::Format("%d", camera.person_count);
+    wxString detector = wxString::Format("ran %llu | skipped %llu (%.0f%%)",
+                                         (unsigned long long)stats.detections_run,
+                                         (unsigned long long)stats.detections_skipped,
+                                         skip_percent);
+    if (camera.unique_persons >= 0) {
+        persons += wxString::Format(" (%d unique)", camera.unique_persons);
+        detector += wxString::Format(" | k=%d", stats.detection_interval);
     }
-    
-    wxImage image(rgbMat.cols, rgbMat.rows, rgbMat.data, true);
-    return wxBitmap(image);
+    wxString clips;
+    if (m_clip_recorder) {
+        ClipRecorder::Stats clip_stats = m_clip_recorder->stats((int)view);
+        clips = wxString::Format("  Clips: %llu | pre-roll %.1f MB | skipped %llu | dropped %llu\n",
+                                 (unsigned long long)clip_stats.clips,
+                                 clip_stats.ring_bytes / (1024.0 * 1024.0),
+                                 (unsigned long long)clip_stats.skipped,
+                                 (unsigned long long)clip_stats.dropped);
+    }
+    return wxString::Format(
+        "Cam %d: Frames: %d | Persons: %s | FPS: %.1f\n"
+        "  Captured: %llu | Dropped: %llu | Processed: %llu\n"
+        "  Detector: %s\n"
+        "  Queue: %lu/%lu (%s) | e2e p50/p99: %.0f/%.0f ms\n%s",
+        camera.camera_index,
+        camera.frame_count,
+        persons,
+        camera.fps,
+        (unsigned long long)stats.captured,
+        (unsigned long long)stats.dropped,
+        (unsigned long long)stats.processed,
+        detector,
+        (unsigned long)stats.queue_depth,
+        (unsigned long)stats.queue_capacity,
+        queuePolicyName(stats.queue_policy),
+        e2e.percentileMs(50),
+        e2e.percentileMs(99),
+        clips);
 }
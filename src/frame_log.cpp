@@ -0,0 +1,134 @@
+#include "frame_log.h"
+#include "timestamp.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+namespace {
+
+constexpr uint64_t kBusy = UINT64_MAX;
+
+} // namespace
+
+FrameLogRing::FrameLogRing(size_t capacity) {
+    size_t rounded = 16;
+    while (rounded < capacity) {
+        rounded <<= 1;
+    }
+    slots.reset(new Slot[rounded]);
+    mask = rounded - 1;
+}
+
+// Each slot is a small seqlock. Two writers only meet in one slot if one of
+// them stalls for a whole lap of the ring, which a camera logging a few
+// entries per second never does.
+void FrameLogRing::push(const FrameLog& log) {
+    uint64_t sequence = head.fetch_add(1, std::memory_order_relaxed);
+    Slot& slot = slots[sequence & mask];
+
+    uint64_t words[kWords];
+    std::memcpy(words, &log, sizeof(log));
+    slot.sequence.store(kBusy, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (size_t i = 0; i < kWords; ++i) {
+        slot.words[i].store(words[i], std::memory_order_relaxed);
+    }
+    slot.sequence.store(sequence + 1, std::memory_order_release);
+}
+
+uint64_t FrameLogRing::read(uint64_t from, std::vector<FrameLog>& out, size_t max_count,
+                            uint64_t* lost) const {
+    const uint64_t last = end();
+    const uint64_t oldest = last > capacity() ? last - capacity() : 0;
+    uint64_t sequence = std::max(from, base.load(std::memory_order_acquire));
+    if (sequence < oldest) {
+        if (lost) {
+            *lost += oldest - sequence;
+        }
+        sequence = oldest;
+    }
+
+    for (size_t count = 0; sequence < last && count < max_count; ++sequence) {
+        const Slot& slot = slots[sequence & mask];
+        uint64_t published = slot.sequence.load(std::memory_order_acquire);
+        if (published != sequence + 1) {
+            // Not written yet, or overwritten by a later lap
+            bool pending = published == kBusy ? sequence + capacity() >= end()
+                                              : published < sequence + 1;
+            if (pending) {
+                break;
+            }
+            if (lost) {
+                ++*lost;
+            }
+            continue;
+        }
+
+        uint64_t words[kWords];
+        for (size_t i = 0; i < kWords; ++i) {
+            words[i] = slot.words[i].load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) != published) {
+            if (lost) {
+                ++*lost;
+            }
+            continue;
+        }
+
+        FrameLog log;
+        std::memcpy(&log, words, sizeof(log));
+        out.push_back(log);
+        ++count;
+    }
+    return sequence;
+}
+
+uint64_t FrameLogRing::begin() const {
+    uint64_t last = end();
+    uint64_t oldest = last > capacity() ? last - capacity() : 0;
+    return std::max(oldest, std::min(last, base.load(std::memory_order_acquire)));
+}
+
+std::string formatLogTime(const FrameLog& log, LogClock clock) {
+    if (clock == LogClock::Media) {
+        return formatMediaTime(log.timestamp_ns / 1e6);
+    }
+    return formatTimestamp(log.timestamp_ns);
+}
+
+void writeFrameLogCsvHeader(std::ostream& out) {
+    out << "Timestamp,Frame_Number,Person_Count,Unique_Persons,Latency_ms\n";
+}
+
+void writeFrameLogCsvRow(std::ostream& out, const FrameLog& log, LogClock clock) {
+    out << formatLogTime(log, clock) << ","
+        << log.frame_number << ","
+        << log.person_count << ",";
+    if (log.unique_persons >= 0) {
+        out << log.unique_persons;
+    }
+    out << ",";
+    if (log.latency_us >= 0) {
+        char latency[16];
+        std::snprintf(latency, sizeof(latency), "%.1f", log.latency_us / 1000.0);
+        out << latency;
+    }
+    out << "\n";
+}
+
+void writeFrameLogCsv(std::ostream& out, const std::vector<FrameLog>& logs, LogClock clock) {
+    writeFrameLogCsvHeader(out);
+    for (const auto& log : logs) {
+        writeFrameLogCsvRow(out, log, clock);
+    }
+}
+
+std::string formatMediaTime(double milliseconds) {
+    long long total_ms = milliseconds > 0 ? (long long)(milliseconds + 0.5) : 0;
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%02lld:%02lld:%02lld.%03lld",
+                  total_ms / 3600000, (total_ms / 60000) % 60,
+                  (total_ms / 1000) % 60, total_ms % 1000);
+    return buffer;
+}
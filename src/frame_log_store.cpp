@@ -0,0 +1,376 @@
+#include "frame_log_store.h"
+#include "timestamp.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <type_traits>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr char kFileMagic[8] = {'F', 'R', 'A', 'M', 'E', 'L', 'O', 'G'};
+constexpr uint32_t kVersion = 1;
+constexpr uint32_t kBlockMagic = 0x4b4c4246;  // "FBLK"
+
+static_assert(sizeof(FrameLogFileHeader) % 8 == 0 && sizeof(FrameLogBlockHeader) % 8 == 0,
+              "blocks must stay 8-byte aligned");
+
+// Bytes of the columns of count records; a multiple of 8 like FrameLog itself
+size_t columnBytes(size_t count) {
+    return count * sizeof(FrameLog);
+}
+
+// "logs/frames_cam0_20260120_013045_123.flog"
+std::string logFileName(const std::string& dir, int camera_index) {
+    auto now = std::chrono::system_clock::now();
+    std::time_t seconds = std::chrono::system_clock::to_time_t(now);
+    int ms = (int)(std::chrono::duration_cast<std::chrono::milliseconds>(
+        now.time_since_epoch()).count() % 1000);
+    std::tm local_tm{};
+#ifdef _WIN32
+    localtime_s(&local_tm, &seconds);
+#else
+    localtime_r(&seconds, &local_tm);
+#endif
+    char stamp[32];
+    std::strftime(stamp, sizeof(stamp), "%Y%m%d_%H%M%S", &local_tm);
+    char name[96];
+    std::snprintf(name, sizeof(name), "frames_cam%d_%s_%03d.flog", camera_index, stamp, ms);
+    return (fs::path(dir) / name).string();
+}
+
+} // namespace
+
+FrameLogWriter::FrameLogWriter(const FrameLogOptions& options) : options(options) {}
+
+FrameLogWriter::~FrameLogWriter() {
+    stop();
+}
+
+void FrameLogWriter::addSource(int camera_index, const FrameLogRing& ring) {
+    Source source;
+    source.camera_index = camera_index;
+    source.ring = &ring;
+    source.cursor = ring.begin();
+    sources.push_back(std::move(source));
+}
+
+bool FrameLogWriter::start() {
+    if (running) {
+        return true;
+    }
+    std::error_code ec;
+    fs::create_directories(options.dir, ec);
+    if (ec) {
+        std::cerr << "Failed to create log directory " << options.dir << ": " << ec.message()
+                  << std::endl;
+        return false;
+    }
+    stopping = false;
+    running = true;
+    thread = std::thread(&FrameLogWriter::run, this);
+    return true;
+}
+
+void FrameLogWriter::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!running) {
+            return;
+        }
+        stopping = true;
+    }
+    wake.notify_one();
+    thread.join();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        running = false;
+    }
+    for (auto& source : sources) {
+        closeFile(source);
+    }
+}
+
+void FrameLogWriter::flush() {
+    std::unique_lock<std::mutex> lock(mutex);
+    if (!running) {
+        return;
+    }
+    uint64_t request = ++flush_requested;
+    wake.notify_one();
+    flushed.wait(lock, [&]() { return flush_done >= request || !running; });
+}
+
+std::vector<std::string> FrameLogWriter::files(int camera_index) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<std::string> paths;
+    for (const auto& source : sources) {
+        if (source.camera_index == camera_index) {
+            paths.insert(paths.end(), source.paths.begin(), source.paths.end());
+        }
+    }
+    return paths;
+}
+
+void FrameLogWriter::run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        wake.wait_for(lock, std::chrono::milliseconds(std::max(1, options.flush_ms)),
+                      [this]() { return stopping || flush_requested > flush_done; });
+        uint64_t request = flush_requested;
+        bool stop = stopping;
+
+        // The disk is only touched with the lock released; flush() and
+        // files() callers never wait for a write
+        lock.unlock();
+        for (auto& source : sources) {
+            writePending(source);
+        }
+        lock.lock();
+
+        flush_done = request;
+        flushed.notify_all();
+        if (stop) {
+            break;
+        }
+    }
+}
+
+void FrameLogWriter::writePending(Source& source) {
+    entries.clear();
+    uint64_t lost = 0;
+    source.cursor = source.ring->read(source.cursor, entries, SIZE_MAX, &lost);
+    if (lost) {
+        lost_count.fetch_add(lost, std::memory_order_relaxed);
+    }
+    if (entries.empty()) {
+        return;
+    }
+
+    // One block: header, then each field as a contiguous column
+    const size_t count = entries.size();
+    block.resize(sizeof(FrameLogBlockHeader) + columnBytes(count));
+    FrameLogBlockHeader header{kBlockMagic, (uint32_t)count, INT64_MAX, INT64_MIN};
+    char* column = block.data() + sizeof(header);
+    auto writeColumn = [&](auto field) {
+        using T = std::remove_reference_t<decltype(entries[0].*field)>;
+        T* values = reinterpret_cast<T*>(column);
+        for (size_t i = 0; i < count; ++i) {
+            values[i] = entries[i].*field;
+        }
+        column += count * sizeof(T);
+    };
+    writeColumn(&FrameLog::timestamp_ns);
+    writeColumn(&FrameLog::frame_number);
+    writeColumn(&FrameLog::person_count);
+    writeColumn(&FrameLog::unique_persons);
+    writeColumn(&FrameLog::latency_us);
+    for (const auto& entry : entries) {
+        header.min_timestamp_ns = std::min(header.min_timestamp_ns, entry.timestamp_ns);
+        header.max_timestamp_ns = std::max(header.max_timestamp_ns, entry.timestamp_ns);
+    }
+    std::memcpy(block.data(), &header, sizeof(header));
+
+    if (source.file && source.file_bytes + block.size() > options.rotate_bytes) {
+        closeFile(source);
+    }
+    if (!source.file && !openFile(source)) {
+        lost_count.fetch_add(count, std::memory_order_relaxed);
+        return;
+    }
+    // Flushed every block: after a crash the file ends at the last whole block
+    if (std::fwrite(block.data(), 1, block.size(), source.file) != block.size() ||
+        std::fflush(source.file) != 0) {
+        std::cerr << "Failed to write frame log of camera " << source.camera_index << std::endl;
+        lost_count.fetch_add(count, std::memory_order_relaxed);
+        closeFile(source);
+        return;
+    }
+    source.file_bytes += block.size();
+}
+
+bool FrameLogWriter::openFile(Source& source) {
+    std::string path = logFileName(options.dir, source.camera_index);
+    source.file = std::fopen(path.c_str(), "wb");
+    if (!source.file) {
+        std::cerr << "Failed to create frame log " << path << std::endl;
+        return false;
+    }
+
+    FrameLogFileHeader header{};
+    std::memcpy(header.magic, kFileMagic, sizeof(header.magic));
+    header.version = kVersion;
+    header.header_bytes = sizeof(header);
+    header.camera_index = source.camera_index;
+    header.created_ns = epochNanoseconds(std::chrono::system_clock::now());
+    std::fwrite(&header, sizeof(header), 1, source.file);
+    source.file_bytes = sizeof(header);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    source.paths.push_back(path);
+    // Retention: drop this camera's oldest files beyond keep_files
+    while (options.keep_files > 0 && source.paths.size() > (size_t)options.keep_files) {
+        std::error_code ec;
+        fs::remove(source.paths.front(), ec);
+        source.paths.erase(source.paths.begin());
+    }
+    return true;
+}
+
+void FrameLogWriter::closeFile(Source& source) {
+    if (source.file) {
+        std::fclose(source.file);
+        source.file = nullptr;
+        source.file_bytes = 0;
+    }
+}
+
+FrameLogFile::~FrameLogFile() {
+    close();
+}
+
+bool FrameLogFile::open(const std::string& path, std::string& error) {
+    close();
+#ifdef _WIN32
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        error = "Cannot open " + path;
+        return false;
+    }
+    buffer.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    data = buffer.data();
+    length = buffer.size();
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    struct stat st{};
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+        error = "Cannot open " + path;
+        return false;
+    }
+    length = (size_t)st.st_size;
+    if (length > 0) {
+        void* mapped = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped == MAP_FAILED) {
+            ::close(fd);
+            length = 0;
+            error = "Cannot map " + path;
+            return false;
+        }
+        data = static_cast<const char*>(mapped);
+    }
+    ::close(fd);
+#endif
+
+    if (length < sizeof(header)) {
+        error = path + " is not a frame log";
+        close();
+        return false;
+    }
+    std::memcpy(&header, data, sizeof(header));
+    if (std::memcmp(header.magic, kFileMagic, sizeof(kFileMagic)) != 0 ||
+        header.header_bytes < sizeof(header) || header.header_bytes % 8 != 0) {
+        error = path + " is not a frame log";
+        close();
+        return false;
+    }
+    if (header.version != kVersion) {
+        error = path + ": unsupported frame log version " + std::to_string(header.version);
+        close();
+        return false;
+    }
+
+    // Index the blocks; anything after the last whole block is a torn write
+    size_t offset = header.header_bytes;
+    while (offset + sizeof(FrameLogBlockHeader) <= length) {
+        FrameLogBlockHeader block_header;
+        std::memcpy(&block_header, data + offset, sizeof(block_header));
+        size_t end = offset + sizeof(block_header) + columnBytes(block_header.count);
+        if (block_header.magic != kBlockMagic || block_header.count == 0 || end > length) {
+            break;
+        }
+        Block block;
+        block.columns = data + offset + sizeof(block_header);
+        block.count = block_header.count;
+        block.min_timestamp_ns = block_header.min_timestamp_ns;
+        block.max_timestamp_ns = block_header.max_timestamp_ns;
+        blocks.push_back(block);
+        record_count += block.count;
+        offset = end;
+    }
+    return true;
+}
+
+void FrameLogFile::close() {
+#ifndef _WIN32
+    if (data && buffer.empty()) {
+        munmap(const_cast<char*>(data), length);
+    }
+#endif
+    buffer.clear();
+    data = nullptr;
+    length = 0;
+    blocks.clear();
+    record_count = 0;
+    header = FrameLogFileHeader{};
+}
+
+size_t FrameLogFile::query(int64_t from_ns, int64_t to_ns, std::vector<FrameLog>& out) const {
+    size_t added = 0;
+    for (const auto& block : blocks) {
+        if (block.max_timestamp_ns < from_ns || block.min_timestamp_ns >= to_ns) {
+            continue;
+        }
+        const size_t count = block.count;
+        const int64_t* timestamps = reinterpret_cast<const int64_t*>(block.columns);
+        const int32_t* frame_numbers = reinterpret_cast<const int32_t*>(timestamps + count);
+        const int32_t* person_counts = frame_numbers + count;
+        const int32_t* unique_persons = person_counts + count;
+        const int32_t* latencies = unique_persons + count;
+        for (size_t i = 0; i < count; ++i) {
+            if (timestamps[i] < from_ns || timestamps[i] >= to_ns) {
+                continue;
+            }
+            FrameLog log;
+            log.timestamp_ns = timestamps[i];
+            log.frame_number = frame_numbers[i];
+            log.person_count = person_counts[i];
+            log.unique_persons = unique_persons[i];
+            log.latency_us = latencies[i];
+            out.push_back(log);
+            ++added;
+        }
+    }
+    return added;
+}
+
+bool convertFrameLogsToCsv(const std::vector<std::string>& paths, std::ostream& out,
+                           std::string& error, int64_t from_ns, int64_t to_ns) {
+    writeFrameLogCsvHeader(out);
+    FrameLogFile file;
+    std::vector<FrameLog> records;
+    for (const auto& path : paths) {
+        if (!file.open(path, error)) {
+            return false;
+        }
+        records.clear();
+        file.query(from_ns, to_ns, records);
+        for (const auto& record : records) {
+            writeFrameLogCsvRow(out, record);
+        }
+    }
+    return true;
+}
@@ -0,0 +1,35 @@
+#include "frame_pool.h"
+
+namespace {
+
+// True if the pool's header is the only reference to the buffer. Other
+// threads drop their references concurrently, so read the count atomically.
+bool isFree(cv::Mat& buffer) {
+    return buffer.u && CV_XADD(&buffer.u->refcount, 0) == 1;
+}
+
+} // namespace
+
+cv::Mat FramePool::acquire(const cv::Size& size, int type) {
+    cv::Mat* spare = nullptr;
+    for (auto& buffer : buffers) {
+        if (!isFree(buffer)) {
+            continue;
+        }
+        if (buffer.size() == size && buffer.type() == type) {
+            return buffer;
+        }
+        spare = &buffer;
+    }
+
+    // A free buffer of another size is replaced rather than kept around
+    if (spare) {
+        spare->create(size, type);
+        return *spare;
+    }
+    if (buffers.size() < max_buffers) {
+        buffers.emplace_back(size, type);
+        return buffers.back();
+    }
+    return cv::Mat(size, type);
+}
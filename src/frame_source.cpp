@@ -0,0 +1,618 @@
+#include "frame_source.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define USE_MMAP 1
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr char kRawMagic[8] = {'W', 'X', 'R', 'A', 'W', 'F', 'R', 'M'};
+constexpr uint32_t kRawVersion = 1;
+constexpr size_t kRawAlignment = 64;
+
+struct RawFileHeader {
+    char magic[8];
+    uint32_t version;
+    int32_t width;
+    int32_t height;
+    int32_t type;          // cv::Mat type, e.g. CV_8UC3
+    uint32_t record_size;  // bytes per frame record
+    uint8_t reserved[36];
+};
+static_assert(sizeof(RawFileHeader) == kRawAlignment, "raw frame header is one cache line");
+
+size_t rawRecordSize(const cv::Size& size, int type) {
+    size_t pixels = (size_t)size.area() * CV_ELEM_SIZE(type);
+    return (kRawAlignment + pixels + kRawAlignment - 1) / kRawAlignment * kRawAlignment;
+}
+
+bool isImageFile(const fs::path& path) {
+    std::string ext = path.extension().string();
+    std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+    return ext == ".jpg" || ext == ".jpeg" || ext == ".png" || ext == ".bmp";
+}
+
+std::chrono::steady_clock::duration fromMs(double ms) {
+    return std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double, std::milli>(ms));
+}
+
+// A camera; frames are stamped with the driver's capture time where the
+// backend reports one
+class DeviceSource : public FrameSource {
+public:
+    DeviceSource(const std::string& device, const FrameSourceOptions& options) : device(device) {
+        bool is_index = !device.empty() && std::all_of(device.begin(), device.end(), ::isdigit);
+        if (is_index) {
+            cap.open(std::stoi(device));
+        } else {
+            cap.open(device);
+        }
+        if (cap.isOpened()) {
+            cap.set(cv::CAP_PROP_FRAME_WIDTH, options.size.width);
+            cap.set(cv::CAP_PROP_FRAME_HEIGHT, options.size.height);
+            cap.set(cv::CAP_PROP_FPS, options.fps);
+            cap.set(cv::CAP_PROP_BUFFERSIZE, 1);
+        }
+    }
+
+    bool isOpened() const { return cap.isOpened(); }
+
+    bool read(cv::Mat& frame, FrameTime& time) override {
+        if (!cap.read(frame)) {
+            return false;
+        }
+        // V4L2 reports the buffer timestamp on CLOCK_MONOTONIC, which is the
+        // steady clock on Linux; other backends report 0 or a stream
+        // position, so only a plausible value is trusted
+        auto now = std::chrono::steady_clock::now();
+        double driver_ms = cap.get(cv::CAP_PROP_POS_MSEC);
+        std::chrono::steady_clock::time_point stamped(fromMs(driver_ms));
+        bool plausible = driver_ms > 0 && stamped <= now && now - stamped < std::chrono::seconds(1);
+        time.capture = plausible ? stamped : now;
+        if (!started) {
+            started = true;
+            first = time.capture;
+        }
+        time.media_ms = std::chrono::duration<double, std::milli>(time.capture - first).count();
+        return true;
+    }
+
+    bool skip() override { return cap.grab(); }
+    std::string describe() const override { return "camera " + device; }
+
+private:
+    std::string device;
+    cv::VideoCapture cap;
+    bool started = false;
+    std::chrono::steady_clock::time_point first;
+};
+
+// Recorded sources: paces frames by their media time and loops
+class RecordedSource : public FrameSource {
+public:
+    explicit RecordedSource(const FrameSourceOptions& options) : options(options) {}
+
+    bool read(cv::Mat& frame, FrameTime& time) override {
+        double media_ms = 0.0;
+        if (!next(frame, media_ms)) {
+            // Continue the clock across the loop, one frame after the last
+            if (!options.loop || !rewind() || !next(frame, media_ms)) {
+                ended = true;
+                return false;
+            }
+            loop_offset_ms = last_ms + frameIntervalMs();
+        }
+        media_ms += loop_offset_ms;
+        last_ms = media_ms;
+        time.media_ms = media_ms;
+
+        auto now = std::chrono::steady_clock::now();
+        if (options.pacing == Pacing::Max) {
+            time.capture = now;
+            return true;
+        }
+        auto due = clock_start + fromMs(media_ms);
+        // First frame, or a jump in the recording: restart the clock
+        if (!started || due > now + std::chrono::seconds(1) || due < now - std::chrono::seconds(1)) {
+            started = true;
+            clock_start = now - fromMs(media_ms);
+            due = now;
+        }
+        if (due > now) {
+            std::this_thread::sleep_until(due);
+        }
+        time.capture = std::max(due, now);
+        return true;
+    }
+
+    bool atEnd() const override { return ended; }
+
+protected:
+    // Next frame and its position, without pacing
+    virtual bool next(cv::Mat& frame, double& media_ms) = 0;
+    // Back to the first frame
+    virtual bool rewind() = 0;
+
+    double frameIntervalMs() const { return 1000.0 / std::max(1.0, options.fps); }
+
+    FrameSourceOptions options;
+
+private:
+    bool started = false;
+    bool ended = false;
+    std::chrono::steady_clock::time_point clock_start;
+    double loop_offset_ms = 0.0;
+    double last_ms = 0.0;
+};
+
+class VideoFileSource : public RecordedSource {
+public:
+    VideoFileSource(const std::string& path, const FrameSourceOptions& options)
+        : RecordedSource(options), path(path), index(0) {
+        cap.open(path);
+        double file_fps = cap.isOpened() ? cap.get(cv::CAP_PROP_FPS) : 0.0;
+        if (file_fps > 0) {
+            this->options.fps = file_fps;
+        }
+    }
+
+    bool isOpened() const { return cap.isOpened(); }
+
+    bool skip() override {
+        index++;
+        return cap.grab();
+    }
+    std::string describe() const override { return path; }
+
+protected:
+    bool next(cv::Mat& frame, double& media_ms) override {
+        if (!cap.read(frame)) {
+            return false;
+        }
+        // Some containers report no position; fall back to the frame rate
+        double position = cap.get(cv::CAP_PROP_POS_MSEC);
+        media_ms = position > 0 || index == 0 ? position : index * frameIntervalMs();
+        index++;
+        return true;
+    }
+
+    bool rewind() override {
+        index = 0;
+        return cap.set(cv::CAP_PROP_POS_FRAMES, 0);
+    }
+
+private:
+    std::string path;
+    cv::VideoCapture cap;
+    size_t index;
+};
+
+// "frames/%04d.png": one %d or %0Nd conversion, %% for a literal percent
+// sign. The spec is never handed to printf, so it cannot smuggle in other
+// conversions.
+struct SequencePattern {
+    std::string prefix;
+    std::string suffix;
+    int width = 0;  // zero-padded to this many digits
+
+    std::string path(int number) const {
+        std::string digits = std::to_string(number);
+        if ((int)digits.size() < width) {
+            digits.insert(0, width - digits.size(), '0');
+        }
+        return prefix + digits + suffix;
+    }
+};
+
+bool parseSequencePattern(const std::string& spec, SequencePattern& pattern) {
+    bool have_number = false;
+    std::string* out = &pattern.prefix;
+    pattern = SequencePattern();
+    for (size_t i = 0; i < spec.size(); ++i) {
+        if (spec[i] != '%') {
+            out->push_back(spec[i]);
+            continue;
+        }
+        if (i + 1 < spec.size() && spec[i + 1] == '%') {
+            out->push_back('%');
+            ++i;
+            continue;
+        }
+        if (have_number) {
+            return false;
+        }
+        size_t j = i + 1;
+        if (j < spec.size() && spec[j] == '0') {
+            size_t digits = ++j;
+            while (j < spec.size() && std::isdigit((unsigned char)spec[j])) {
+                ++j;
+            }
+            if (j == digits || j - digits > 2) {
+                return false;
+            }
+            pattern.width = std::stoi(spec.substr(digits, j - digits));
+        }
+        if (j >= spec.size() || spec[j] != 'd') {
+            return false;
+        }
+        have_number = true;
+        out = &pattern.suffix;
+        i = j;
+    }
+    return have_number;
+}
+
+// A directory of images in name order, or a numbered pattern starting at 0 or 1
+class ImageSequenceSource : public RecordedSource {
+public:
+    ImageSequenceSource(const std::string& spec, const FrameSourceOptions& options)
+        : RecordedSource(options), spec(spec), index(0) {
+        std::error_code ec;
+        if (fs::is_directory(spec, ec)) {
+            for (const auto& entry : fs::directory_iterator(spec, ec)) {
+                if (entry.is_regular_file() && isImageFile(entry.path())) {
+                    images.push_back(entry.path().string());
+                }
+            }
+            std::sort(images.begin(), images.end());
+            return;
+        }
+        SequencePattern pattern;
+        if (!parseSequencePattern(spec, pattern)) {
+            return;
+        }
+        std::string previous;
+        for (int number = 0; number < std::numeric_limits<int>::max(); ++number) {
+            std::string path = pattern.path(number);
+            if (path == previous) {
+                break;
+            }
+            if (fs::is_regular_file(path, ec)) {
+                images.push_back(path);
+            } else if (number > 0 || !images.empty()) {
+                break;
+            }
+            previous = std::move(path);
+        }
+    }
+
+    bool isOpened() const { return !images.empty(); }
+
+    bool skip() override { return index++ < images.size(); }
+    std::string describe() const override { return spec + " (" + std::to_string(images.size()) + " images)"; }
+
+protected:
+    bool next(cv::Mat& frame, double& media_ms) override {
+        while (index < images.size()) {
+            media_ms = index * frameIntervalMs();
+            frame = cv::imread(images[index++]);
+            if (!frame.empty()) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool rewind() override {
+        index = 0;
+        return true;
+    }
+
+private:
+    std::string spec;
+    std::vector<std::string> images;
+    size_t index;
+};
+
+// Tall boxes drifting over a gradient, so motion gating, detection and
+// tracking all have something to do without a camera
+class SyntheticSource : public RecordedSource {
+public:
+    explicit SyntheticSource(const FrameSourceOptions& options)
+        : RecordedSource(options), background(options.size, CV_8UC3), index(0) {
+        for (int y = 0; y < background.rows; ++y) {
+            double shade = 40.0 + 120.0 * y / std::max(1, background.rows - 1);
+            background.row(y).setTo(cv::Scalar(shade, shade * 0.8, shade * 0.6));
+        }
+    }
+
+    std::string describe() const override {
+        std::ostringstream out;
+        out << "synthetic " << background.cols << "x" << background.rows << "@" << options.fps;
+        return out.str();
+    }
+
+protected:
+    bool next(cv::Mat& frame, double& media_ms) override {
+        // Into the caller's buffer unless it was moved away
+        background.copyTo(frame);
+        const int width = std::max(8, frame.cols / 12);
+        const int height = std::max(16, frame.rows / 3);
+        for (int i = 0; i < 3; ++i) {
+            double phase = index * 0.02 * (i + 1) + i * 2.1;
+            int x = (int)((0.5 + 0.4 * std::sin(phase)) * (frame.cols - width));
+            int y = (int)((0.3 + 0.2 * i) * (frame.rows - height));
+            cv::rectangle(frame, cv::Rect(x, y, width, height), cv::Scalar(60, 60 + 60 * i, 200), cv::FILLED);
+        }
+        cv::putText(frame, std::to_string(index), cv::Point(10, frame.rows - 10),
+                    cv::FONT_HERSHEY_SIMPLEX, 0.6, cv::Scalar(255, 255, 255), 1);
+        media_ms = index * frameIntervalMs();
+        index++;
+        return true;
+    }
+
+    bool rewind() override {
+        index = 0;
+        return true;
+    }
+
+private:
+    cv::Mat background;
+    uint64_t index;
+};
+
+// Frames straight out of a memory-mapped RawFrameWriter file; nothing is
+// decoded or copied, the page cache is the frame buffer
+class RawFileSource : public RecordedSource {
+public:
+    RawFileSource(const std::string& path, const FrameSourceOptions& options)
+        : RecordedSource(options), path(path), base(nullptr), length(0), frame_count(0), index(0) {
+    }
+
+    ~RawFileSource() override {
+#ifdef USE_MMAP
+        if (base) {
+            munmap(base, length);
+        }
+#endif
+    }
+
+    bool open(std::string& error) {
+#ifdef USE_MMAP
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            error = "Cannot open " + path;
+            return false;
+        }
+        struct stat info;
+        if (fstat(fd, &info) == 0 && info.st_size >= (off_t)sizeof(RawFileHeader)) {
+            length = (size_t)info.st_size;
+            // Private and writable: consumers may scribble on a frame
+            // without touching the file or faulting
+            void* mapped = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+            base = mapped == MAP_FAILED ? nullptr : static_cast<uint8_t*>(mapped);
+        }
+        ::close(fd);
+        if (!base) {
+            error = "Cannot map " + path;
+            return false;
+        }
+        madvise(base, length, MADV_SEQUENTIAL);
+#else
+        std::ifstream in(path, std::ios::binary);
+        buffer.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        if (buffer.size() < sizeof(RawFileHeader)) {
+            error = "Cannot read " + path;
+            return false;
+        }
+        base = buffer.data();
+        length = buffer.size();
+#endif
+        std::memcpy(&header, base, sizeof(header));
+        if (std::memcmp(header.magic, kRawMagic, sizeof(kRawMagic)) != 0 || header.version != kRawVersion ||
+            header.width <= 0 || header.height <= 0 ||
+            header.record_size != rawRecordSize(cv::Size(header.width, header.height), header.type)) {
+            error = path + " is not a raw frame file";
+            return false;
+        }
+        frame_count = (length - sizeof(RawFileHeader)) / header.record_size;
+        if (frame_count == 0) {
+            error = path + " holds no frames";
+            return false;
+        }
+        return true;
+    }
+
+    bool skip() override { return index++ < frame_count; }
+
+    std::string describe() const override {
+        return path + " (" + std::to_string(frame_count) + " raw " + std::to_string(header.width) + "x" +
+               std::to_string(header.height) + " frames)";
+    }
+
+protected:
+    bool next(cv::Mat& frame, double& media_ms) override {
+        if (index >= frame_count) {
+            return false;
+        }
+        uint8_t* record = base + sizeof(RawFileHeader) + index * header.record_size;
+        int64_t media_ns = 0;
+        std::memcpy(&media_ns, record, sizeof(media_ns));
+        media_ms = media_ns / 1e6;
+        frame = cv::Mat(header.height, header.width, header.type, record + kRawAlignment);
+        index++;
+        return true;
+    }
+
+    bool rewind() override {
+        index = 0;
+        return true;
+    }
+
+private:
+    std::string path;
+    RawFileHeader header;
+    uint8_t* base;
+    size_t length;
+#ifndef USE_MMAP
+    std::vector<uint8_t> buffer;
+#endif
+    size_t frame_count;
+    size_t index;
+};
+
+// "640x480@15" after "synthetic:"
+bool parseSyntheticSpec(const std::string& value, FrameSourceOptions& options) {
+    int width = 0, height = 0;
+    char separator = 0;
+    std::istringstream in(value);
+    if (!(in >> width >> separator >> height) || separator != 'x' || width <= 0 || height <= 0) {
+        return false;
+    }
+    options.size = cv::Size(width, height);
+    if (in >> separator) {
+        double fps = 0.0;
+        if (separator != '@' || !(in >> fps) || fps <= 0) {
+            return false;
+        }
+        options.fps = fps;
+    }
+    return true;
+}
+
+} // namespace
+
+bool parsePacing(const std::string& name, Pacing& pacing) {
+    if (name == "realtime") {
+        pacing = Pacing::Realtime;
+    } else if (name == "max") {
+        pacing = Pacing::Max;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char* pacingName(Pacing pacing) {
+    return pacing == Pacing::Realtime ? "realtime" : "max";
+}
+
+bool FrameSource::skip() {
+    cv::Mat frame;
+    FrameTime time;
+    return read(frame, time);
+}
+
+std::unique_ptr<FrameSource> openFrameSource(const std::string& spec, const FrameSourceOptions& options,
+                                             std::string& error) {
+    std::error_code ec;
+    bool is_index = !spec.empty() && std::all_of(spec.begin(), spec.end(), ::isdigit);
+    if (is_index || spec.rfind("/dev/video", 0) == 0) {
+        auto source = std::make_unique<DeviceSource>(spec, options);
+        if (!source->isOpened()) {
+            error = "Cannot open camera " + spec;
+            return nullptr;
+        }
+        return source;
+    }
+    if (spec.rfind("synthetic", 0) == 0) {
+        FrameSourceOptions synthetic = options;
+        if (spec != "synthetic" && (spec[9] != ':' || !parseSyntheticSpec(spec.substr(10), synthetic))) {
+            error = "Expected synthetic[:WxH[@FPS]], got " + spec;
+            return nullptr;
+        }
+        return std::make_unique<SyntheticSource>(synthetic);
+    }
+    if (fs::path(spec).extension() == ".raw") {
+        auto source = std::make_unique<RawFileSource>(spec, options);
+        if (!source->open(error)) {
+            return nullptr;
+        }
+        return source;
+    }
+    if (fs::is_directory(spec, ec) || spec.find('%') != std::string::npos) {
+        SequencePattern pattern;
+        if (!fs::is_directory(spec, ec) && !parseSequencePattern(spec, pattern)) {
+            error = "Expected one %d or %0Nd in image pattern " + spec;
+            return nullptr;
+        }
+        auto source = std::make_unique<ImageSequenceSource>(spec, options);
+        if (!source->isOpened()) {
+            error = "No images in " + spec;
+            return nullptr;
+        }
+        return source;
+    }
+    auto source = std::make_unique<VideoFileSource>(spec, options);
+    if (!source->isOpened()) {
+        error = "Cannot open " + spec;
+        return nullptr;
+    }
+    return source;
+}
+
+RawFrameWriter::RawFrameWriter() : type(0), record_size(0), frames(0) {
+}
+
+RawFrameWriter::~RawFrameWriter() {
+    close();
+}
+
+bool RawFrameWriter::open(const std::string& path, const cv::Size& frame_size, int frame_type,
+                          std::string& error) {
+    close();
+    out.open(path, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+        error = "Cannot create " + path;
+        return false;
+    }
+    size = frame_size;
+    type = frame_type;
+    record_size = rawRecordSize(size, type);
+    frames = 0;
+
+    RawFileHeader header = {};
+    std::memcpy(header.magic, kRawMagic, sizeof(kRawMagic));
+    header.version = kRawVersion;
+    header.width = size.width;
+    header.height = size.height;
+    header.type = type;
+    header.record_size = (uint32_t)record_size;
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    return out.good();
+}
+
+bool RawFrameWriter::write(const cv::Mat& frame, double media_ms) {
+    if (!out.is_open() || frame.size() != size || frame.type() != type) {
+        return false;
+    }
+    char prefix[kRawAlignment] = {};
+    int64_t media_ns = (int64_t)(media_ms * 1e6);
+    std::memcpy(prefix, &media_ns, sizeof(media_ns));
+    out.write(prefix, sizeof(prefix));
+
+    // Row by row, so ROIs and padded Mats are written densely
+    const size_t row_bytes = (size_t)frame.cols * frame.elemSize();
+    for (int y = 0; y < frame.rows; ++y) {
+        out.write(reinterpret_cast<const char*>(frame.ptr(y)), row_bytes);
+    }
+    static const char padding[kRawAlignment] = {};
+    size_t used = kRawAlignment + row_bytes * frame.rows;
+    out.write(padding, record_size - used);
+    frames++;
+    return out.good();
+}
+
+void RawFrameWriter::close() {
+    if (out.is_open()) {
+        out.close();
+    }
+}
@@ -0,0 +1,186 @@
+#include "latency_histogram.h"
+#include <cstdio>
+
+namespace {
+
+int highestBit(uint64_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+    return 63 - __builtin_clzll(value);
+#else
+    int bit = 0;
+    while (value >>= 1) {
+        ++bit;
+    }
+    return bit;
+#endif
+}
+
+} // namespace
+
+LatencyHistogram::LatencyHistogram() {
+    reset();
+}
+
+int LatencyHistogram::bucketIndex(uint64_t micros) {
+    if (micros < (uint64_t)kSubBuckets) {
+        return (int)micros;
+    }
+    int exponent = highestBit(micros);
+    if (exponent > kMaxExponent) {
+        return kBucketCount - 1;
+    }
+    int sub = (int)((micros >> (exponent - kSubBits)) & (kSubBuckets - 1));
+    return kSubBuckets + (exponent - kSubBits) * kSubBuckets + sub;
+}
+
+uint64_t LatencyHistogram::bucketLowerBound(int index) {
+    if (index < kSubBuckets) {
+        return (uint64_t)index;
+    }
+    int exponent = (index - kSubBuckets) / kSubBuckets + kSubBits;
+    int sub = (index - kSubBuckets) % kSubBuckets;
+    return (1ULL << exponent) + ((uint64_t)sub << (exponent - kSubBits));
+}
+
+uint64_t LatencyHistogram::bucketUpperBound(int index) {
+    if (index < kSubBuckets) {
+        return (uint64_t)index;
+    }
+    int exponent = (index - kSubBuckets) / kSubBuckets + kSubBits;
+    return bucketLowerBound(index) + (1ULL << (exponent - kSubBits)) - 1;
+}
+
+void LatencyHistogram::record(uint64_t micros) {
+    buckets[bucketIndex(micros)].fetch_add(1, std::memory_order_relaxed);
+    total.fetch_add(1, std::memory_order_relaxed);
+    sum.fetch_add(micros, std::memory_order_relaxed);
+
+    uint64_t current = max.load(std::memory_order_relaxed);
+    while (micros > current &&
+           !max.compare_exchange_weak(current, micros, std::memory_order_relaxed)) {
+    }
+}
+
+void LatencyHistogram::reset() {
+    for (auto& bucket : buckets) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    total.store(0, std::memory_order_relaxed);
+    sum.store(0, std::memory_order_relaxed);
+    max.store(0, std::memory_order_relaxed);
+}
+
+double LatencyHistogram::percentileMs(double p) const {
+    // Concurrent records may land mid-scan; the result is still a valid estimate
+    uint64_t count = total.load(std::memory_order_relaxed);
+    if (count == 0) {
+        return 0.0;
+    }
+    uint64_t rank = (uint64_t)(p / 100.0 * count);
+    if (rank >= count) {
+        rank = count - 1;
+    }
+
+    uint64_t seen = 0;
+    for (int i = 0; i < kBucketCount; ++i) {
+        seen += buckets[i].load(std::memory_order_relaxed);
+        if (seen > rank) {
+            // Midpoint of the bucket, capped by the exact maximum
+            uint64_t mid = (bucketLowerBound(i) + bucketUpperBound(i)) / 2;
+            uint64_t peak = max.load(std::memory_order_relaxed);
+            return (mid < peak ? mid : peak) / 1000.0;
+        }
+    }
+    return max.load(std::memory_order_relaxed) / 1000.0;
+}
+
+LatencyHistogram::Summary LatencyHistogram::summary() const {
+    Summary s;
+    s.count = total.load(std::memory_order_relaxed);
+    if (s.count == 0) {
+        return s;
+    }
+    s.mean_ms = sum.load(std::memory_order_relaxed) / 1000.0 / s.count;
+    s.p50_ms = percentileMs(50);
+    s.p95_ms = percentileMs(95);
+    s.p99_ms = percentileMs(99);
+    s.max_ms = max.load(std::memory_order_relaxed) / 1000.0;
+    return s;
+}
+
+const char* stageName(Stage stage) {
+    switch (stage) {
+        case Stage::Capture: return "capture";
+        case Stage::Resize: return "resize";
+        case Stage::Motion: return "motion";
+        case Stage::Preprocess: return "preprocess";
+        case Stage::Forward: return "forward";
+        case Stage::Decode: return "decode";
+        case Stage::Nms: return "nms";
+        case Stage::Track: return "track";
+        case Stage::Draw: return "draw";
+        case Stage::Convert: return "convert";
+        case Stage::Bitmap: return "bitmap";
+        case Stage::Display: return "display";
+        case Stage::EndToEnd: return "end_to_end";
+        case Stage::Count: break;
+    }
+    return "unknown";
+}
+
+void StageLatencies::reset() {
+    for (auto& histogram : histograms) {
+        histogram.reset();
+    }
+}
+
+std::string StageLatencies::formatTable() const {
+    std::string table = "Latency (ms)   p50    p95    p99    max\n";
+    char line[96];
+    for (int i = 0; i < kStageCount; ++i) {
+        LatencyHistogram::Summary s = histograms[i].summary();
+        if (s.count == 0) {
+            continue;
+        }
+        std::snprintf(line, sizeof(line), "%-11s %6.1f %6.1f %6.1f %6.1f\n",
+                      stageName((Stage)i), s.p50_ms, s.p95_ms, s.p99_ms, s.max_ms);
+        table += line;
+    }
+    return table;
+}
+
+std::string StageLatencies::formatOverlay() const {
+    // Name the stage with the worst p95 so the overlay says what to blame
+    int slowest = -1;
+    double slowest_p95 = 0.0;
+    for (int i = 0; i < kStageCount; ++i) {
+        if ((Stage)i == Stage::EndToEnd) {
+            continue;
+        }
+        double p95 = histograms[i].percentileMs(95);
+        if (histograms[i].count() > 0 && p95 > slowest_p95) {
+            slowest = i;
+            slowest_p95 = p95;
+        }
+    }
+
+    const LatencyHistogram& e2e = histograms[(int)Stage::EndToEnd];
+    const LatencyHistogram& forward = histograms[(int)Stage::Forward];
+    char text[160];
+    std::snprintf(text, sizeof(text),
+                  "Latency p50/p99: e2e %.0f/%.0f ms, forward %.0f/%.0f ms\n"
+                  "Slowest: %s (p95 %.1f ms)",
+                  e2e.percentileMs(50), e2e.percentileMs(99),
+                  forward.percentileMs(50), forward.percentileMs(99),
+                  slowest >= 0 ? stageName((Stage)slowest) : "-", slowest_p95);
+    return text;
+}
+
+void StageLatencies::writeCsv(std::ostream& out) const {
+    out << "Stage,Count,Mean_ms,P50_ms,P95_ms,P99_ms,Max_ms\n";
+    for (int i = 0; i < kStageCount; ++i) {
+        LatencyHistogram::Summary s = histograms[i].summary();
+        out << stageName((Stage)i) << "," << s.count << "," << s.mean_ms << ","
+            << s.p50_ms << "," << s.p95_ms << "," << s.p99_ms << "," << s.max_ms << "\n";
+    }
+}
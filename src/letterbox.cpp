@@ -0,0 +1,63 @@
+#include "letterbox.h"
+#include <algorithm>
+#include <cmath>
+
+LetterboxPreprocessor::LetterboxPreprocessor(int width, int height, bool keep_aspect)
+    : width(width), height(height), keep_aspect(keep_aspect),
+      canvas(height, width, CV_8UC3) {
+    for (auto& plane : planes) {
+        plane.create(height, width, CV_8UC1);
+    }
+}
+
+void LetterboxPreprocessor::updateGeometry(const cv::Size& frame_size) {
+    last_frame_size = frame_size;
+
+    if (!keep_aspect) {
+        info.scale_x = width / (float)frame_size.width;
+        info.scale_y = height / (float)frame_size.height;
+        info.pad_x = 0.0f;
+        info.pad_y = 0.0f;
+        content = cv::Rect(0, 0, width, height);
+        return;
+    }
+
+    float scale = std::min(width / (float)frame_size.width, height / (float)frame_size.height);
+    int resized_width = std::max(1, (int)std::round(frame_size.width * scale));
+    int resized_height = std::max(1, (int)std::round(frame_size.height * scale));
+    int pad_x = (width - resized_width) / 2;
+    int pad_y = (height - resized_height) / 2;
+
+    info.scale_x = resized_width / (float)frame_size.width;
+    info.scale_y = resized_height / (float)frame_size.height;
+    info.pad_x = (float)pad_x;
+    info.pad_y = (float)pad_y;
+    content = cv::Rect(pad_x, pad_y, resized_width, resized_height);
+
+    // Standard YOLO letterbox gray; the border never changes until the frame size does
+    canvas.setTo(cv::Scalar(114, 114, 114));
+}
+
+LetterboxInfo LetterboxPreprocessor::run(const cv::Mat& frame, float* dst) {
+    if (frame.size() != last_frame_size) {
+        updateGeometry(frame.size());
+    }
+
+    // Resize into the canvas ROI; the header already has the right size, so no allocation
+    cv::Mat roi = canvas(content);
+    if (frame.size() == content.size()) {
+        frame.copyTo(roi);
+    } else {
+        cv::resize(frame, roi, content.size(), 0, 0, cv::INTER_LINEAR);
+    }
+
+    // Split BGR and scale each plane into its RGB slot of the CHW tensor
+    cv::split(canvas, planes);
+    const size_t plane_size = (size_t)width * height;
+    for (int c = 0; c < 3; ++c) {
+        cv::Mat dst_plane(height, width, CV_32FC1, dst + (2 - c) * plane_size);
+        planes[c].convertTo(dst_plane, CV_32F, 1.0 / 255.0);
+    }
+
+    return info;
+}
@@ -0,0 +1,129 @@
+// Frame log converter: turns the .flog files the GUI writes into the Export
+// Log CSV, optionally limited to a time range, or summarizes them.
+#include "frame_log_store.h"
+#include "timestamp.h"
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct LogOptions {
+    std::vector<std::string> inputs;
+    std::string output;          // empty = stdout
+    int64_t from_ns = INT64_MIN;
+    int64_t to_ns = INT64_MAX;
+    bool info = false;
+};
+
+void printUsage() {
+    std::cout << "Usage: wxapp_log [options] FILE.flog...\n"
+                 "  --output=FILE       CSV destination (default stdout)\n"
+                 "  --from=TIME         first timestamp kept, \"YYYY-MM-DD HH:MM:SS\" local time\n"
+                 "  --to=TIME           end of the range (exclusive)\n"
+                 "  --info              print camera, record count and time span per file\n";
+}
+
+// "2026-01-20 01:30:45" in local time
+bool parseLocalTime(const std::string& value, int64_t& epoch_ns) {
+    std::tm local_tm{};
+    std::istringstream in(value);
+    in >> std::get_time(&local_tm, "%Y-%m-%d %H:%M:%S");
+    if (in.fail()) {
+        return false;
+    }
+    local_tm.tm_isdst = -1;
+    std::time_t seconds = std::mktime(&local_tm);
+    if (seconds == (std::time_t)-1) {
+        return false;
+    }
+    epoch_ns = (int64_t)seconds * 1000000000;
+    return true;
+}
+
+bool parseLogOptions(int argc, char** argv, LogOptions& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--help" || arg == "-h") {
+            return false;
+        } else if (arg.rfind("--output=", 0) == 0) {
+            options.output = arg.substr(9);
+        } else if (arg.rfind("--from=", 0) == 0) {
+            if (!parseLocalTime(arg.substr(7), options.from_ns)) {
+                std::cerr << "Invalid time in " << arg << std::endl;
+                return false;
+            }
+        } else if (arg.rfind("--to=", 0) == 0) {
+            if (!parseLocalTime(arg.substr(5), options.to_ns)) {
+                std::cerr << "Invalid time in " << arg << std::endl;
+                return false;
+            }
+        } else if (arg == "--info") {
+            options.info = true;
+        } else if (arg.rfind("--", 0) == 0) {
+            std::cerr << "Unknown option " << arg << std::endl;
+            return false;
+        } else {
+            options.inputs.push_back(arg);
+        }
+    }
+    return !options.inputs.empty();
+}
+
+int printInfo(const std::vector<std::string>& inputs) {
+    FrameLogFile file;
+    std::vector<FrameLog> records;
+    int failures = 0;
+    for (const auto& path : inputs) {
+        std::string error;
+        if (!file.open(path, error)) {
+            std::cerr << error << std::endl;
+            failures++;
+            continue;
+        }
+        records.clear();
+        file.readAll(records);
+        std::cout << path << ": camera " << file.cameraIndex() << ", " << records.size()
+                  << " records";
+        if (!records.empty()) {
+            std::cout << ", " << formatTimestamp(records.front().timestamp_ns) << " to "
+                      << formatTimestamp(records.back().timestamp_ns);
+        }
+        std::cout << std::endl;
+    }
+    return failures == 0 ? 0 : 2;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    LogOptions options;
+    if (!parseLogOptions(argc, argv, options)) {
+        printUsage();
+        return 1;
+    }
+    if (options.info) {
+        return printInfo(options.inputs);
+    }
+
+    std::ofstream file;
+    if (!options.output.empty()) {
+        file.open(options.output);
+        if (!file.is_open()) {
+            std::cerr << "Failed to create " << options.output << std::endl;
+            return 2;
+        }
+    }
+    std::ostream& out = options.output.empty() ? std::cout : file;
+
+    std::string error;
+    if (!convertFrameLogsToCsv(options.inputs, out, error, options.from_ns, options.to_ns)) {
+        std::cerr << error << std::endl;
+        return 2;
+    }
+    return 0;
+}
@@ -1,5 +1,6 @@
 #include <wx/wx.h>
 #include "frame.h"
+#include <iostream>
 
 class MyApp : public wxApp {
 public:
@@ -9,7 +10,24 @@ public:
 wxIMPLEMENT_APP(MyApp);
 
 bool MyApp::OnInit() {
-    MyFrame* frame = new MyFrame("wxWidgets Application");
+    AppConfig config;
+    std::vector<std::string> args;
+    for (int i = 1; i < argc; ++i) {
+        args.push_back(argv[i].ToStdString());
+    }
+    
+    std::string error;
+    if (!parseAppConfig(args, config, error)) {
+        std::cerr << error << "\n\n" << appConfigUsage();
+        return false;
+    }
+    
+    // Before any other thread starts, so they all begin from this layout
+    ThreadLayout layout = applyThreadLayout(config);
+    std::cout << formatThreadLayout(layout) << std::flush;
+    pinCurrentThread(layout.gui_cpus);
+    
+    MyFrame* frame = new MyFrame("wxWidgets Application", config);
     frame->Show(true);
     return true;
 }
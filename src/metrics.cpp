@@ -0,0 +1,333 @@
+#include "metrics.h"
+#include "latency_histogram.h"
+#include "pipeline.h"
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+#ifndef _WIN32
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// Histogram bucket bounds in seconds; each is summed from the log-linear
+// buckets that lie entirely below it
+const double kLatencyBounds[] = {0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1.0, 2.5, 5.0};
+
+std::string escapeLabel(const std::string& value) {
+    std::string escaped;
+    for (char c : value) {
+        if (c == '\\' || c == '"') {
+            escaped += '\\';
+            escaped += c;
+        } else if (c == '\n') {
+            escaped += "\\n";
+        } else {
+            escaped += c;
+        }
+    }
+    return escaped;
+}
+
+void appendHeader(std::string& out, const char* name, const char* type, const char* help) {
+    out += "# HELP ";
+    out += name;
+    out += ' ';
+    out += help;
+    out += "\n# TYPE ";
+    out += name;
+    out += ' ';
+    out += type;
+    out += '\n';
+}
+
+void appendSample(std::string& out, const char* name, const std::string& labels, double value) {
+    char number[32];
+    std::snprintf(number, sizeof(number), "%.17g", value);
+    out += name;
+    if (!labels.empty()) {
+        out += '{';
+        out += labels;
+        out += '}';
+    }
+    out += ' ';
+    out += number;
+    out += '\n';
+}
+
+std::string cameraLabel(const FramePipeline& pipeline, int stream_id) {
+    return "camera=\"" + std::to_string(pipeline.cameraIndex(stream_id)) + "\"";
+}
+
+// Per-stream series of one metric family
+template <typename Value>
+void appendPerStream(std::string& out, const FramePipeline& pipeline, const char* name, const char* type,
+                     const char* help, Value value) {
+    appendHeader(out, name, type, help);
+    for (int i = 0; i < pipeline.streamCount(); ++i) {
+        appendSample(out, name, cameraLabel(pipeline, i), value(i));
+    }
+}
+
+} // namespace
+
+PipelineMetrics::PipelineMetrics() : model_load_ms(-1.0), pipeline(nullptr) {}
+
+void PipelineMetrics::attach(const FramePipeline* attached) {
+    std::lock_guard<std::mutex> lock(attach_mutex);
+    pipeline = attached;
+}
+
+void PipelineMetrics::detach() {
+    std::lock_guard<std::mutex> lock(attach_mutex);
+    pipeline = nullptr;
+    for (auto& stream : counters) {
+        stream.persons.store(0, std::memory_order_relaxed);
+        stream.person_sum.store(0, std::memory_order_relaxed);
+        stream.results.store(0, std::memory_order_relaxed);
+    }
+}
+
+void PipelineMetrics::observeResult(int stream_id, int person_count) {
+    if (stream_id < 0 || stream_id >= kMaxStreams) {
+        return;
+    }
+    StreamCounters& stream = counters[stream_id];
+    stream.persons.store(person_count, std::memory_order_relaxed);
+    stream.person_sum.fetch_add((uint64_t)std::max(0, person_count), std::memory_order_relaxed);
+    stream.results.fetch_add(1, std::memory_order_relaxed);
+}
+
+void PipelineMetrics::setModelLoadMs(double ms) {
+    model_load_ms.store(ms, std::memory_order_relaxed);
+}
+
+std::string PipelineMetrics::render() const {
+    std::string out;
+    out.reserve(64 * 1024);
+
+    double load_ms = model_load_ms.load(std::memory_order_relaxed);
+    if (load_ms >= 0) {
+        appendHeader(out, "wxapp_model_load_seconds", "gauge", "Detector model load and warm-up time.");
+        appendSample(out, "wxapp_model_load_seconds", "", load_ms / 1000.0);
+    }
+
+    std::lock_guard<std::mutex> lock(attach_mutex);
+    appendHeader(out, "wxapp_streaming", "gauge", "1 while the pipeline is streaming.");
+    appendSample(out, "wxapp_streaming", "", pipeline ? 1.0 : 0.0);
+    if (!pipeline) {
+        return out;
+    }
+    const FramePipeline& p = *pipeline;
+
+    appendHeader(out, "wxapp_stream_info", "gauge", "Source of each camera stream.");
+    for (int i = 0; i < p.streamCount(); ++i) {
+        appendSample(out, "wxapp_stream_info",
+                     cameraLabel(p, i) + ",source=\"" + escapeLabel(p.sourceName(i)) + "\"", 1.0);
+    }
+    appendHeader(out, "wxapp_inference_workers", "gauge", "Inference worker threads.");
+    appendSample(out, "wxapp_inference_workers", "", p.workerCount());
+    appendHeader(out, "wxapp_inference_batch_size", "gauge", "Average frames per forward pass since start.");
+    appendSample(out, "wxapp_inference_batch_size", "", p.averageBatchSize());
+
+    appendPerStream(out, p, "wxapp_frames_captured_total", "counter", "Frames read from the source.",
+                    [&](int i) { return (double)p.stats(i).captured; });
+    appendPerStream(out, p, "wxapp_frames_dropped_total", "counter", "Frames dropped by the capture queue.",
+                    [&](int i) { return (double)p.stats(i).dropped; });
+    appendPerStream(out, p, "wxapp_frames_processed_total", "counter", "Frames through the inference stage.",
+                    [&](int i) { return (double)p.stats(i).processed; });
+    appendPerStream(out, p, "wxapp_detections_run_total", "counter", "Frames that went through the detector.",
+                    [&](int i) { return (double)p.stats(i).detections_run; });
+    appendPerStream(out, p, "wxapp_detections_skipped_total", "counter",
+                    "Frames motion-gated or tracked without the detector.",
+                    [&](int i) { return (double)p.stats(i).detections_skipped; });
+    appendPerStream(out, p, "wxapp_queue_depth", "gauge", "Frames waiting in the capture queue.",
+                    [&](int i) { return (double)p.stats(i).queue_depth; });
+    appendPerStream(out, p, "wxapp_queue_capacity", "gauge", "Capture queue capacity.",
+                    [&](int i) { return (double)p.stats(i).queue_capacity; });
+    appendPerStream(out, p, "wxapp_persons", "gauge", "Persons in the newest processed frame.",
+                    [&](int i) {
+                        return i < kMaxStreams ? (double)counters[i].persons.load(std::memory_order_relaxed) : 0.0;
+                    });
+    appendPerStream(out, p, "wxapp_persons_average", "gauge", "Average persons per processed frame since start.",
+                    [&](int i) {
+                        if (i >= kMaxStreams) {
+                            return 0.0;
+                        }
+                        uint64_t results = counters[i].results.load(std::memory_order_relaxed);
+                        return results ? (double)counters[i].person_sum.load(std::memory_order_relaxed) / results
+                                       : 0.0;
+                    });
+
+    // Buckets are read one by one while workers keep recording, so _count is
+    // taken from the same reads to keep the series consistent
+    const char* name = "wxapp_stage_latency_seconds";
+    appendHeader(out, name, "histogram",
+                 "Per-stage latency; stage=\"forward\" is inference, \"end_to_end\" capture to screen.");
+    std::string bucket_name = std::string(name) + "_bucket";
+    std::string sum_name = std::string(name) + "_sum";
+    std::string count_name = std::string(name) + "_count";
+    for (int i = 0; i < p.streamCount(); ++i) {
+        std::string camera = cameraLabel(p, i);
+        for (int s = 0; s < kStageCount; ++s) {
+            const LatencyHistogram& histogram = p.latencies(i).get((Stage)s);
+            std::string labels = camera + ",stage=\"" + stageName((Stage)s) + "\"";
+            uint64_t cumulative = 0;
+            int bucket = 0;
+            for (double bound : kLatencyBounds) {
+                uint64_t bound_us = (uint64_t)std::llround(bound * 1e6);
+                while (bucket < LatencyHistogram::kBucketCount &&
+                       LatencyHistogram::bucketUpperBound(bucket) <= bound_us) {
+                    cumulative += histogram.bucketCount(bucket++);
+                }
+                char le[32];
+                std::snprintf(le, sizeof(le), ",le=\"%g\"", bound);
+                appendSample(out, bucket_name.c_str(), labels + le, (double)cumulative);
+            }
+            while (bucket < LatencyHistogram::kBucketCount) {
+                cumulative += histogram.bucketCount(bucket++);
+            }
+            appendSample(out, bucket_name.c_str(), labels + ",le=\"+Inf\"", (double)cumulative);
+            appendSample(out, sum_name.c_str(), labels, histogram.sumMicros() / 1e6);
+            appendSample(out, count_name.c_str(), labels, (double)cumulative);
+        }
+    }
+    return out;
+}
+
+MetricsServer::MetricsServer(RenderFn render)
+    : render(std::move(render)), listen_fd(-1), bound_port(0), running(false) {}
+
+MetricsServer::~MetricsServer() {
+    stop();
+}
+
+#ifndef _WIN32
+
+bool MetricsServer::start(const std::string& address, int port, std::string& error) {
+    if (running) {
+        return true;
+    }
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((uint16_t)port);
+    if (inet_pton(AF_INET, address.c_str(), &addr.sin_addr) != 1) {
+        error = "Invalid metrics address " + address;
+        return false;
+    }
+    listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (listen_fd < 0) {
+        error = std::string("Failed to create metrics socket: ") + std::strerror(errno);
+        return false;
+    }
+    int reuse = 1;
+    setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    if (bind(listen_fd, (sockaddr*)&addr, sizeof(addr)) != 0 || listen(listen_fd, 8) != 0) {
+        error = "Failed to listen on " + address + ":" + std::to_string(port) + ": " + std::strerror(errno);
+        close(listen_fd);
+        listen_fd = -1;
+        return false;
+    }
+    socklen_t length = sizeof(addr);
+    getsockname(listen_fd, (sockaddr*)&addr, &length);
+    bound_port = ntohs(addr.sin_port);
+
+    running = true;
+    thread = std::thread(&MetricsServer::serve, this);
+    return true;
+}
+
+void MetricsServer::stop() {
+    if (!running.exchange(false)) {
+        return;
+    }
+    thread.join();
+    close(listen_fd);
+    listen_fd = -1;
+}
+
+void MetricsServer::serve() {
+    // Wakes up regularly to notice stop()
+    pollfd listener{listen_fd, POLLIN, 0};
+    while (running) {
+        if (poll(&listener, 1, 200) <= 0 || !(listener.revents & POLLIN)) {
+            continue;
+        }
+        int client = accept(listen_fd, nullptr, nullptr);
+        if (client < 0) {
+            continue;
+        }
+        answer(client);
+        close(client);
+    }
+}
+
+void MetricsServer::answer(int client) {
+    // A slow or silent client cannot hold the thread for long
+    timeval timeout{2, 0};
+    setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+    std::string request;
+    char chunk[1024];
+    while (request.find("\r\n\r\n") == std::string::npos && request.find("\n\n") == std::string::npos &&
+           request.size() < 8192) {
+        ssize_t received = recv(client, chunk, sizeof(chunk), 0);
+        if (received <= 0) {
+            break;
+        }
+        request.append(chunk, (size_t)received);
+    }
+
+    std::string status = "200 OK";
+    std::string type = "text/plain; version=0.0.4; charset=utf-8";
+    std::string body;
+    std::string line = request.substr(0, request.find_first_of("\r\n"));
+    if (line.rfind("GET /metrics ", 0) == 0 || line == "GET /metrics" || line.rfind("GET /metrics?", 0) == 0) {
+        body = render();
+    } else if (line.rfind("GET ", 0) == 0) {
+        status = "404 Not Found";
+        type = "text/plain";
+        body = "Only /metrics is served\n";
+    } else {
+        status = "405 Method Not Allowed";
+        type = "text/plain";
+        body = "Only GET is supported\n";
+    }
+
+    std::string response = "HTTP/1.0 " + status + "\r\nContent-Type: " + type + "\r\nContent-Length: " +
+                           std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n" + body;
+    size_t sent = 0;
+    while (sent < response.size()) {
+#ifdef MSG_NOSIGNAL
+        ssize_t n = send(client, response.data() + sent, response.size() - sent, MSG_NOSIGNAL);
+#else
+        ssize_t n = send(client, response.data() + sent, response.size() - sent, 0);
+#endif
+        if (n <= 0) {
+            break;
+        }
+        sent += (size_t)n;
+    }
+}
+
+#else
+
+bool MetricsServer::start(const std::string&, int, std::string& error) {
+    error = "The metrics endpoint is not available on Windows";
+    return false;
+}
+
+void MetricsServer::stop() {}
+void MetricsServer::serve() {}
+void MetricsServer::answer(int) {}
+
+#endif
@@ -0,0 +1,59 @@
+#include "motion_gate.h"
+#include "simd.h"
+#include <algorithm>
+
+MotionGate::MotionGate(const MotionGateOptions& options)
+    : options(options), frames_since_run(0), changed_percent(100.0f) {
+}
+
+void MotionGate::reset() {
+    reference.release();
+    frames_since_run = 0;
+    changed_percent = 100.0f;
+}
+
+bool MotionGate::shouldDetect(const cv::Mat& frame) {
+    if (!options.enabled || frame.empty()) {
+        return true;
+    }
+
+    // Shrink first so the color conversion touches a few thousand pixels only
+    cv::resize(frame, small, cv::Size(options.width, options.height), 0, 0, cv::INTER_AREA);
+    if (small.channels() == 3) {
+        cv::cvtColor(small, gray, cv::COLOR_BGR2GRAY);
+    } else {
+        small.copyTo(gray);
+    }
+
+    bool run = reference.empty() || ++frames_since_run >= options.refresh_interval;
+    if (!run) {
+        size_t total = gray.total();
+        size_t changed = countChangedPixels(gray.ptr<uint8_t>(), reference.ptr<uint8_t>(), total,
+                                            (uint8_t)std::min(255, std::max(0, options.pixel_threshold)));
+        changed_percent = 100.0f * changed / total;
+        run = changed_percent >= options.min_changed_percent;
+    } else {
+        changed_percent = 100.0f;
+    }
+
+    if (run) {
+        gray.copyTo(reference);
+        frames_since_run = 0;
+    }
+    return run;
+}
+
+size_t countChangedPixels(const uint8_t* a, const uint8_t* b, size_t count, uint8_t threshold) {
+    const simd::VecU8 limit = simd::set1U8(threshold);
+    size_t changed = 0;
+    size_t i = 0;
+    for (; i + simd::kByteWidth <= count; i += simd::kByteWidth) {
+        simd::VecU8 diff = simd::absdiffU8(simd::loadU8(a + i), simd::loadU8(b + i));
+        changed += simd::countGtU8(diff, limit);
+    }
+    for (; i < count; ++i) {
+        int diff = a[i] > b[i] ? a[i] - b[i] : b[i] - a[i];
+        changed += diff > threshold ? 1 : 0;
+    }
+    return changed;
+}
@@ -0,0 +1,203 @@
+#include "nms.h"
+#include "simd.h"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace {
+
+// Intersection of the box (bx1, by1, bx2, by2) with kWidth boxes starting at j
+inline simd::VecF intersection(simd::VecF bx1, simd::VecF by1, simd::VecF bx2, simd::VecF by2,
+                               const float* x1, const float* y1, const float* x2, const float* y2,
+                               size_t j) {
+    const simd::VecF zero = simd::set1(0.0f);
+    simd::VecF w = simd::sub(simd::min(bx2, simd::load(x2 + j)), simd::max(bx1, simd::load(x1 + j)));
+    simd::VecF h = simd::sub(simd::min(by2, simd::load(y2 + j)), simd::max(by1, simd::load(y1 + j)));
+    return simd::mul(simd::max(w, zero), simd::max(h, zero));
+}
+
+} // namespace
+
+NonMaxSuppressor::NonMaxSuppressor(const NmsOptions& options) : options(options) {
+}
+
+size_t NonMaxSuppressor::selectTopK(size_t count) {
+    order.resize(count);
+    std::iota(order.begin(), order.end(), 0);
+    auto better = [this](int a, int b) {
+        return keys[a] > keys[b] || (keys[a] == keys[b] && a < b);
+    };
+
+    // nth_element is linear, so only the survivors pay for the sort
+    if (options.top_k > 0 && count > (size_t)options.top_k) {
+        std::nth_element(order.begin(), order.begin() + options.top_k, order.end(), better);
+        order.resize(options.top_k);
+    }
+    std::sort(order.begin(), order.end(), better);
+    return order.size();
+}
+
+void NonMaxSuppressor::resizeBoxes(size_t count) {
+    // Padding lanes are empty boxes: zero intersection, never suppressed, never kept
+    const size_t padded = count + simd::kWidth;
+    for (auto* array : {&x1, &y1, &x2, &y2, &area, &score, &alive, &overlap}) {
+        array->assign(padded, 0.0f);
+    }
+    class_ids.resize(count);
+}
+
+void NonMaxSuppressor::setBox(size_t slot, float x, float y, float width, float height,
+                              float box_score, int class_id) {
+    x1[slot] = x;
+    y1[slot] = y;
+    x2[slot] = x + width;
+    y2[slot] = y + height;
+    area[slot] = std::max(0.0f, width) * std::max(0.0f, height);
+    score[slot] = box_score;
+    alive[slot] = 1.0f;
+    class_ids[slot] = class_id;
+}
+
+void NonMaxSuppressor::separateClasses(size_t count) {
+    if (!options.class_aware || count == 0) {
+        return;
+    }
+    // Shift each class past the extent of all boxes so classes never overlap
+    float min_x = x1[0], max_x = x2[0];
+    for (size_t i = 1; i < count; ++i) {
+        min_x = std::min(min_x, x1[i]);
+        max_x = std::max(max_x, x2[i]);
+    }
+    const float span = max_x - min_x + 1.0f;
+    for (size_t i = 0; i < count; ++i) {
+        float shift = class_ids[i] * span;
+        x1[i] += shift;
+        x2[i] += shift;
+    }
+}
+
+void NonMaxSuppressor::runHard(size_t count) {
+    const simd::VecF iou_threshold = simd::set1(options.iou_threshold);
+    const simd::VecF containment = simd::set1(options.containment_threshold);
+    const simd::VecF zero = simd::set1(0.0f);
+    const bool check_containment = options.containment_threshold > 0.0f;
+
+    for (size_t i = 0; i < count; ++i) {
+        if (alive[i] == 0.0f) {
+            continue;
+        }
+        kept.push_back((int)i);
+        kept_scores.push_back(score[i]);
+        if (options.max_detections > 0 && kept.size() >= (size_t)options.max_detections) {
+            break;
+        }
+
+        const simd::VecF bx1 = simd::set1(x1[i]), by1 = simd::set1(y1[i]);
+        const simd::VecF bx2 = simd::set1(x2[i]), by2 = simd::set1(y2[i]);
+        const simd::VecF barea = simd::set1(area[i]);
+        for (size_t j = i + 1; j < count; j += simd::kWidth) {
+            simd::VecF inter = intersection(bx1, by1, bx2, by2, x1.data(), y1.data(),
+                                            x2.data(), y2.data(), j);
+            simd::VecF other = simd::load(area.data() + j);
+            // IoU > t  <=>  inter > t * union, without the division
+            simd::VecF uni = simd::sub(simd::add(barea, other), inter);
+            simd::VecF mask = simd::gt(inter, simd::mul(iou_threshold, uni));
+            if (check_containment) {
+                simd::VecF inside = simd::gt(inter, simd::mul(containment, simd::min(barea, other)));
+                mask = simd::select(inside, inside, mask);  // mask | inside
+            }
+            if (simd::movemask(mask)) {
+                simd::store(alive.data() + j, simd::select(mask, zero, simd::load(alive.data() + j)));
+            }
+        }
+    }
+}
+
+void NonMaxSuppressor::runSoft(size_t count) {
+    const float sigma = std::max(1e-3f, options.soft_sigma);
+    while (options.max_detections <= 0 || kept.size() < (size_t)options.max_detections) {
+        // Decayed scores reorder the boxes, so every round picks the best again
+        size_t best = count;
+        float best_score = options.score_threshold;
+        for (size_t j = 0; j < count; ++j) {
+            if (alive[j] != 0.0f && score[j] > best_score) {
+                best = j;
+                best_score = score[j];
+            }
+        }
+        if (best == count) {
+            break;
+        }
+        kept.push_back((int)best);
+        kept_scores.push_back(best_score);
+        alive[best] = 0.0f;
+
+        const simd::VecF bx1 = simd::set1(x1[best]), by1 = simd::set1(y1[best]);
+        const simd::VecF bx2 = simd::set1(x2[best]), by2 = simd::set1(y2[best]);
+        const simd::VecF barea = simd::set1(area[best]);
+        for (size_t j = 0; j < count; j += simd::kWidth) {
+            simd::VecF inter = intersection(bx1, by1, bx2, by2, x1.data(), y1.data(),
+                                            x2.data(), y2.data(), j);
+            simd::VecF uni = simd::sub(simd::add(barea, simd::load(area.data() + j)), inter);
+            simd::VecF safe = simd::max(uni, simd::set1(1e-6f));
+            simd::store(overlap.data() + j, simd::div(inter, safe));
+        }
+        for (size_t j = 0; j < count; ++j) {
+            if (alive[j] != 0.0f && overlap[j] > 0.0f) {
+                score[j] *= std::exp(-(overlap[j] * overlap[j]) / sigma);
+            }
+        }
+    }
+}
+
+void NonMaxSuppressor::run(size_t count) {
+    kept.clear();
+    kept_scores.clear();
+    separateClasses(count);
+    if (options.soft) {
+        runSoft(count);
+    } else {
+        runHard(count);
+    }
+}
+
+void NonMaxSuppressor::suppress(const std::vector<YoloCandidate>& candidates,
+                                std::vector<Detection>& out) {
+    keys.resize(candidates.size());
+    for (size_t i = 0; i < candidates.size(); ++i) {
+        keys[i] = candidates[i].confidence;
+    }
+    const size_t count = selectTopK(candidates.size());
+    resizeBoxes(count);
+    for (size_t slot = 0; slot < count; ++slot) {
+        const YoloCandidate& c = candidates[order[slot]];
+        setBox(slot, c.x, c.y, c.width, c.height, c.confidence, c.class_id);
+    }
+    run(count);
+
+    for (size_t k = 0; k < kept.size(); ++k) {
+        const YoloCandidate& c = candidates[order[kept[k]]];
+        out.push_back({c.x, c.y, c.width, c.height, kept_scores[k], c.class_id});
+    }
+}
+
+void NonMaxSuppressor::suppress(const std::vector<Detection>& boxes, std::vector<Detection>& out,
+                                const std::vector<float>* ranks) {
+    keys.resize(boxes.size());
+    for (size_t i = 0; i < boxes.size(); ++i) {
+        keys[i] = ranks ? (*ranks)[i] : boxes[i].confidence;
+    }
+    const size_t count = selectTopK(boxes.size());
+    resizeBoxes(count);
+    for (size_t slot = 0; slot < count; ++slot) {
+        const Detection& d = boxes[order[slot]];
+        setBox(slot, d.x, d.y, d.width, d.height, d.confidence, d.class_id);
+    }
+    run(count);
+
+    for (size_t k = 0; k < kept.size(); ++k) {
+        Detection det = boxes[order[kept[k]]];
+        det.confidence = kept_scores[k];
+        out.push_back(det);
+    }
+}
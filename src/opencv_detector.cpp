@@ -0,0 +1,139 @@
+#include "opencv_detector.h"
+#include "latency_histogram.h"
+#include "yolo_decoder.h"
+#include <algorithm>
+#include <iostream>
+
+OpenCVDetector::OpenCVDetector(const std::string& model_path, const DetectorConfig& config)
+    : config(config), initialized(false), max_batch(std::max(1, config.max_batch)) {
+    NmsOptions nms = config.nms;
+    nms.score_threshold = config.confidence_threshold;
+    suppressor = NonMaxSuppressor(nms);
+    
+    try {
+        net = cv::dnn::readNetFromONNX(model_path);
+        if (net.empty()) {
+            std::cerr << "Failed to load network from " << model_path << std::endl;
+            return;
+        }
+        
+        net.setPreferableBackend(cv::dnn::DNN_BACKEND_DEFAULT);
+        net.setPreferableTarget(cv::dnn::DNN_TARGET_CPU);
+        out_names = net.getUnconnectedOutLayersNames();
+        
+        int blob_shape[] = {max_batch, 3, 640, 640};
+        blob.create(4, blob_shape, CV_32F);
+        geometries.resize(max_batch);
+        preprocessor = std::make_unique<LetterboxPreprocessor>(640, 640, config.letterbox);
+        
+        initialized = true;
+        std::cout << "✓ YOLO model loaded successfully from: " << model_path << std::endl;
+    } catch (const cv::Exception& e) {
+        // The importer upcasts FP16 weights and maps QuantizeLinear/DequantizeLinear
+        // pairs to int8 layers, but older OpenCV releases reject quantized graphs
+        std::cerr << "OpenCV error loading " << model_path << ": " << e.what() << std::endl;
+        if (config.precision != "fp32") {
+            std::cerr << "Quantized and FP16 models need OpenCV 4.7 or newer; "
+                      << "--backend=onnxruntime runs them natively" << std::endl;
+        }
+    }
+}
+
+std::vector<Detection> OpenCVDetector::detect(const cv::Mat& frame) {
+    std::vector<Detection> detections;
+    
+    if (!initialized || frame.empty()) {
+        return detections;
+    }
+    
+    timings = DetectTimings();
+    runBatch(&frame, 1, &detections);
+    return detections;
+}
+
+void OpenCVDetector::detectBatch(const std::vector<cv::Mat>& frames,
+                                 std::vector<std::vector<Detection>>& results) {
+    results.resize(frames.size());
+    timings = DetectTimings();
+    if (!initialized) {
+        return;
+    }
+    
+    for (size_t start = 0; start < frames.size();) {
+        int count = (int)std::min(frames.size() - start, (size_t)max_batch);
+        if (!runBatch(&frames[start], count, &results[start]) && count > 1) {
+            // Models exported with a fixed batch of 1 reject larger inputs
+            std::cerr << "Model rejected a batch of " << count
+                      << " frames; falling back to single-frame inference" << std::endl;
+            max_batch = 1;
+            continue;
+        }
+        start += count;
+    }
+}
+
+bool OpenCVDetector::runBatch(const cv::Mat* frames, int count, std::vector<Detection>* results) {
+    for (int b = 0; b < count; ++b) {
+        results[b].clear();
+    }
+    
+    try {
+        StageTimer timer;
+        
+        // Letterbox each frame straight into its slice of the persistent input blob
+        const size_t plane_size = (size_t)3 * 640 * 640;
+        for (int b = 0; b < count; ++b) {
+            if (!frames[b].empty()) {
+                geometries[b] = preprocessor->run(frames[b], blob.ptr<float>() + b * plane_size);
+            }
+        }
+        timings.preprocess_us += timer.lap();
+        
+        // Set input: a header over the first count slices, no copy
+        int input_shape[] = {count, 3, 640, 640};
+        net.setInput(cv::Mat(4, input_shape, CV_32F, blob.ptr<float>()));
+        
+        // Forward pass
+        net.forward(outs, out_names);
+        timings.forward_us += timer.lap();
+        
+        // Decode and suppress each frame's detections in frame coordinates
+        for (int b = 0; b < count; ++b) {
+            if (frames[b].empty()) {
+                continue;
+            }
+            YoloDecodeParams params;
+            params.confidence_threshold = config.confidence_threshold;
+            params.person_only = config.person_only;
+            params.scale_x = geometries[b].scale_x;
+            params.scale_y = geometries[b].scale_y;
+            params.pad_x = geometries[b].pad_x;
+            params.pad_y = geometries[b].pad_y;
+            params.frame_width = frames[b].cols;
+            params.frame_height = frames[b].rows;
+            
+            candidates.clear();
+            for (const auto& out : outs) {
+                // outs are N-dimensional (e.g. Bx84x8400), so rows/cols are not meaningful
+                std::vector<int64_t> shape(out.size.p, out.size.p + out.dims);
+                YoloOutputLayout layout;
+                if (out.type() != CV_32F || !out.isContinuous() ||
+                    !inferYoloLayout(shape, 80, layout) || layout.batch != count) {
+                    continue;
+                }
+                decodeYoloOutput(out.ptr<float>(), layout, params, candidates, b);
+            }
+            
+            timings.decode_us += timer.lap();
+            
+            // Overlapping boxes of one person would otherwise all be counted
+            suppressor.suppress(candidates, results[b]);
+            timings.nms_us += timer.lap();
+        }
+    } catch (const cv::Exception& e) {
+        std::cerr << "Detection error: " << e.what() << std::endl;
+        return false;
+    }
+    
+    return true;
+}
@@ -0,0 +1,544 @@
+#include "pipeline.h"
+#include "detector.h"
+#include "thread_layout.h"
+#include "timestamp.h"
+#include <algorithm>
+#include <iostream>
+
+namespace {
+
+// Maps boxes found on the full-resolution frame onto the display frame
+void scaleDetections(std::vector<Detection>& detections, const cv::Size& from, const cv::Size& to) {
+    float sx = to.width / (float)from.width;
+    float sy = to.height / (float)from.height;
+    for (auto& det : detections) {
+        det.x *= sx;
+        det.y *= sy;
+        det.width *= sx;
+        det.height *= sy;
+    }
+}
+
+} // namespace
+
+// One camera: its capture thread, queue, counters, FPS and latency state
+struct FramePipeline::Stream {
+    Stream(int id, int camera_index, const PipelineOptions& options)
+        : id(id), camera_index(camera_index), running(false),
+          queue(options.queue_capacity, options.queue_policy),
+          frame_pool(options.queue_capacity + (size_t)std::max(1, options.max_batch) + 4),
+          processed_count(0),
+          detections_run(0), detections_skipped(0), detection_interval(0),
+          gate(options.motion), tracker(options.tracking),
+          in_flight(false), fps_counter(0), fps(0.0f),
+          fps_time(std::chrono::steady_clock::now()) {
+    }
+
+    int id;
+    int camera_index;
+    std::unique_ptr<FrameSource> source;
+    std::string source_name;  // kept after stop() releases the source
+    std::thread capture_thread;
+    std::atomic<bool> running;
+
+    // Lock-free handoff between this camera's capture thread and the pool
+    FrameQueue<CapturedFrame> queue;
+    // Display frames, written by the capture thread and recycled once the
+    // GUI has painted them; sized for the queue, a batch and the GUI's frames
+    FramePool frame_pool;
+    std::atomic<uint64_t> processed_count;
+    std::atomic<uint64_t> detections_run;
+    std::atomic<uint64_t> detections_skipped;
+    std::atomic<int> detection_interval;
+    StageLatencies stage_latencies;
+
+    // Motion gating and tracking, owned by whichever worker holds the stream
+    MotionGate gate;
+    MultiObjectTracker tracker;
+    std::vector<Detection> last_detections;
+
+    // Guarded by schedule_mutex; set while a worker holds this camera,
+    // which keeps its frames in order
+    bool in_flight;
+
+    // FPS bookkeeping, owned by whichever worker holds the stream
+    int fps_counter;
+    float fps;
+    std::chrono::steady_clock::time_point fps_time;
+    std::string hud_text;  // latency overlay, refreshed with the FPS
+};
+
+// Frames one worker runs through a single forward pass; reused across batches
+struct FramePipeline::Batch {
+    std::vector<CapturedFrame> frames;
+    std::vector<Stream*> owners;  // camera of each frame
+    std::vector<Stream*> held;    // cameras claimed by this batch
+    std::vector<bool> detect;     // false = static scene, reuse the last detections
+    std::vector<cv::Mat> images;  // frames that go through the detector
+    std::vector<std::vector<Detection>> results;
+
+    void clear() {
+        frames.clear();
+        owners.clear();
+        held.clear();
+    }
+};
+
+FramePipeline::FramePipeline(DetectorFactory make_detector, ResultFn on_result, ErrorFn on_error,
+                             const PipelineOptions& options)
+    : make_detector(std::move(make_detector)), on_result(std::move(on_result)),
+      on_error(std::move(on_error)), options(options), running(false), next_stream(0),
+      batch_count(0), batched_frames(0), detecting_workers(0) {
+}
+
+FramePipeline::~FramePipeline() {
+    stop();
+}
+
+bool FramePipeline::start(const std::vector<int>& camera_indices, std::vector<int>* failed) {
+    std::vector<StreamSource> sources;
+    for (int camera_index : camera_indices) {
+        sources.push_back({camera_index, std::to_string(camera_index)});
+    }
+    return start(sources, failed);
+}
+
+bool FramePipeline::start(const std::vector<StreamSource>& sources, std::vector<int>* failed) {
+    if (running.load()) {
+        return true;
+    }
+
+    FrameSourceOptions source_options;
+    source_options.size = options.capture_size;
+    source_options.pacing = options.replay_pacing;
+    source_options.loop = options.replay_loop;
+
+    // The previous session's streams stay until a new one opened, so stream
+    // ids the caller still holds remain valid when nothing could be opened
+    std::vector<std::unique_ptr<Stream>> opened;
+    for (const auto& source : sources) {
+        auto stream = std::make_unique<Stream>((int)opened.size(), source.id, options);
+        std::string error;
+        stream->source = openFrameSource(source.spec, source_options, error);
+        if (!stream->source) {
+            std::cerr << error << std::endl;
+            if (failed) {
+                failed->push_back(source.id);
+            }
+            continue;
+        }
+        stream->source_name = stream->source->describe();
+        opened.push_back(std::move(stream));
+    }
+    if (opened.empty()) {
+        return false;
+    }
+    streams.swap(opened);
+
+    // A camera never has more than one frame in flight, so workers beyond
+    // the camera count would only idle
+    int hardware_threads = std::max(1u, std::thread::hardware_concurrency());
+    int worker_count = options.inference_workers > 0 ? options.inference_workers : hardware_threads;
+    worker_count = std::min(worker_count, (int)streams.size());
+
+    // One slot per worker; each worker fills its own on its own thread
+    if ((int)detectors.size() < worker_count) {
+        detectors.resize(worker_count);
+    }
+
+    // Unless the thread layout fixed it, give each worker an equal share of
+    // OpenCV's internal threads
+    int cores = options.inference_cpus.empty() ? hardware_threads : (int)options.inference_cpus.size();
+    cv::setNumThreads(options.opencv_threads > 0 ? options.opencv_threads
+                                                 : std::max(1, cores / worker_count));
+
+    next_stream = 0;
+    batch_count = 0;
+    batched_frames = 0;
+    detecting_workers = 0;
+    running = true;
+    for (int w = 0; w < worker_count; ++w) {
+        workers.emplace_back(&FramePipeline::workerLoop, this, w);
+    }
+    for (auto& stream : streams) {
+        stream->running = true;
+        stream->capture_thread = std::thread(&FramePipeline::captureLoop, this, stream.get());
+    }
+
+    std::cout << "Pipeline started: " << streams.size() << " source(s), " << worker_count
+              << " inference worker(s) (queue: " << queuePolicyName(options.queue_policy)
+              << ", capacity " << streams.front()->queue.getCapacity() << ", max batch "
+              << options.max_batch << ")" << std::endl;
+    return true;
+}
+
+void FramePipeline::stop() {
+    running = false;
+    for (auto& stream : streams) {
+        stream->running = false;
+        stream->queue.close();
+    }
+    work_available.notify_all();
+
+    for (auto& stream : streams) {
+        if (stream->capture_thread.joinable()) {
+            stream->capture_thread.join();
+        }
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    workers.clear();
+
+    // Releases cameras and unmaps raw files; no frame of theirs is in flight
+    for (auto& stream : streams) {
+        stream->source.reset();
+    }
+}
+
+int FramePipeline::cameraIndex(int stream_id) const {
+    return streams[stream_id]->camera_index;
+}
+
+std::string FramePipeline::sourceName(int stream_id) const {
+    return streams[stream_id]->source_name;
+}
+
+bool FramePipeline::isStreamRunning(int stream_id) const {
+    return streams[stream_id]->running.load();
+}
+
+void FramePipeline::captureLoop(Stream* stream) {
+    pinCurrentThread(options.capture_cpus);
+    int frame_number = 0;
+    cv::Mat frame;
+    FrameTime time;
+
+    while (stream->running.load()) {
+        StageTimer timer;
+        if (!stream->source->read(frame, time)) {
+            if (stream->running.load()) {
+                on_error(stream->id, stream->source->atEnd()
+                                         ? "Finished " + stream->source->describe() + "."
+                                         : "Failed to read frame from " + stream->source->describe() + "!");
+            }
+            stream->running = false;
+            stream->queue.close();
+            break;
+        }
+        stream->stage_latencies.record(Stage::Capture, timer.lap());
+
+        // Preprocess while the pool is busy with earlier frames. The display
+        // copy is always 640x480; detection may keep the camera resolution.
+        CapturedFrame captured;
+        captured.capture_time = time.capture;
+        captured.media_ms = time.media_ms;
+        captured.frame_number = ++frame_number;
+        captured.image = stream->frame_pool.acquire(cv::Size(640, 480), frame.type());
+        cv::resize(frame, captured.image, captured.image.size());
+        if (options.detect_full_frame) {
+            // Moved out, so the next read decodes into a fresh buffer
+            // (raw files hand out views of their mapping either way)
+            captured.full = std::move(frame);
+        }
+        stream->stage_latencies.record(Stage::Resize, timer.lap());
+
+        // Counts the frame as dropped if the policy evicts it before detection
+        stream->queue.push(std::move(captured));
+        work_available.notify_one();
+    }
+}
+
+bool FramePipeline::claimBatch(Batch& batch, int limit) {
+    batch.clear();
+    const auto timeout = std::chrono::milliseconds(options.batch_timeout_ms);
+    std::chrono::steady_clock::time_point deadline;
+
+    std::unique_lock<std::mutex> lock(schedule_mutex);
+    while (running.load()) {
+        // One round takes at most one frame per camera, starting after the
+        // camera served last so every camera gets its turn
+        size_t first = next_stream;
+        bool took = false;
+        for (size_t k = 0; k < streams.size() && (int)batch.frames.size() < limit; ++k) {
+            size_t i = (first + k) % streams.size();
+            Stream* stream = streams[i].get();
+            bool held = std::find(batch.held.begin(), batch.held.end(), stream) != batch.held.end();
+            if (stream->in_flight && !held) {
+                continue;
+            }
+            batch.frames.emplace_back();
+            if (!stream->queue.tryPop(batch.frames.back())) {
+                batch.frames.pop_back();
+                continue;
+            }
+            if (!held) {
+                stream->in_flight = true;
+                batch.held.push_back(stream);
+            }
+            batch.owners.push_back(stream);
+            next_stream = i + 1;
+            took = true;
+        }
+
+        if (batch.frames.empty()) {
+            // Pushes notify without the lock; the timeout covers a missed wakeup
+            work_available.wait_for(lock, std::chrono::milliseconds(5));
+            continue;
+        }
+        if ((int)batch.frames.size() >= limit) {
+            return true;
+        }
+
+        // Partial batch: keep collecting until the deadline of its first frame
+        auto now = std::chrono::steady_clock::now();
+        if (deadline == std::chrono::steady_clock::time_point()) {
+            deadline = now + timeout;
+        }
+        if (took) {
+            continue;
+        }
+        if (now >= deadline) {
+            return true;
+        }
+        work_available.wait_until(lock, std::min(deadline, now + std::chrono::milliseconds(5)));
+    }
+
+    // Stopping: hand back the cameras without processing
+    for (Stream* stream : batch.held) {
+        stream->in_flight = false;
+    }
+    batch.clear();
+    return false;
+}
+
+void FramePipeline::releaseBatch(Batch& batch) {
+    {
+        std::lock_guard<std::mutex> lock(schedule_mutex);
+        for (Stream* stream : batch.held) {
+            stream->in_flight = false;
+        }
+    }
+    // These cameras may have queued more frames meanwhile
+    work_available.notify_all();
+}
+
+void FramePipeline::workerLoop(int slot) {
+    pinCurrentThread(options.inference_cpus);
+    // Loading a model takes seconds, so a worker builds its detector here,
+    // before its first frame, rather than stalling start() and the thread
+    // that called it. Until then the other workers serve every camera.
+    if (!detectors[slot] && make_detector) {
+        try {
+            detectors[slot] = make_detector();
+        } catch (const std::exception& e) {
+            std::cerr << "Inference worker " << slot << ": no detector: " << e.what() << std::endl;
+        }
+    }
+    Detector* detector = detectors[slot].get();
+    bool can_detect = detector && detector->isInitialized();
+    if (can_detect) {
+        detecting_workers.fetch_add(1, std::memory_order_release);
+    }
+    int limit = can_detect ? std::max(1, std::min(options.max_batch, detector->maxBatchSize())) : 1;
+    Batch batch;
+    static const std::vector<Detection> no_detections;
+
+    // A worker without a detector only stands in while no worker has one;
+    // after that it leaves the frames to the workers that can detect
+    while ((can_detect || detecting_workers.load(std::memory_order_acquire) == 0) &&
+           claimBatch(batch, limit)) {
+        const size_t count = batch.frames.size();
+
+        // The tracker picks every k-th frame, then the motion gate drops the
+        // ones that did not change (unless they are due a refresh)
+        batch.detect.assign(count, false);
+        batch.images.clear();
+        for (size_t j = 0; j < count; ++j) {
+            Stream* stream = batch.owners[j];
+            batch.detect[j] = can_detect;
+            if (can_detect && stream->tracker.getOptions().enabled) {
+                batch.detect[j] = stream->tracker.shouldDetect();
+            }
+            if (batch.detect[j] && stream->gate.getOptions().enabled) {
+                StageTimer timer;
+                batch.detect[j] = stream->gate.shouldDetect(batch.frames[j].image);
+                stream->stage_latencies.record(Stage::Motion, timer.lap());
+            }
+            if (batch.detect[j]) {
+                const CapturedFrame& frame = batch.frames[j];
+                batch.images.push_back(frame.full.empty() ? frame.image : frame.full);
+            }
+        }
+
+        batch.results.resize(batch.images.size());
+        if (!batch.images.empty()) {
+            detector->detectBatch(batch.images, batch.results);
+
+            // Every detected frame of the batch waited for the whole pass
+            const DetectTimings& timings = detector->lastTimings();
+            for (size_t j = 0; j < count; ++j) {
+                if (!batch.detect[j]) {
+                    continue;
+                }
+                StageLatencies& latencies = batch.owners[j]->stage_latencies;
+                latencies.record(Stage::Preprocess, timings.preprocess_us);
+                latencies.record(Stage::Forward, timings.forward_us);
+                latencies.record(Stage::Decode, timings.decode_us);
+                latencies.record(Stage::Nms, timings.nms_us);
+            }
+            batch_count.fetch_add(1, std::memory_order_relaxed);
+            batched_frames.fetch_add(batch.images.size(), std::memory_order_relaxed);
+        }
+
+        // Results go out in claim order, so each camera's frames stay in order
+        // and a skipped frame reuses (or, tracking, predicts from) what the
+        // frame before it found
+        size_t next_result = 0;
+        for (size_t j = 0; j < count; ++j) {
+            Stream* stream = batch.owners[j];
+            if (batch.detect[j]) {
+                const CapturedFrame& frame = batch.frames[j];
+                if (!frame.full.empty()) {
+                    scaleDetections(batch.results[next_result], frame.full.size(), frame.image.size());
+                }
+                stream->last_detections.swap(batch.results[next_result++]);
+                stream->detections_run.fetch_add(1, std::memory_order_relaxed);
+            } else {
+                stream->detections_skipped.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            MultiObjectTracker& tracker = stream->tracker;
+            if (can_detect && tracker.getOptions().enabled) {
+                StageTimer timer;
+                if (batch.detect[j]) {
+                    tracker.update(stream->last_detections);
+                } else {
+                    tracker.predict();
+                }
+                stream->stage_latencies.record(Stage::Track, timer.lap());
+                stream->detection_interval.store(tracker.detectionInterval(),
+                                                 std::memory_order_relaxed);
+                finishFrame(stream, batch.frames[j], tracker.tracks());
+            } else {
+                // Without a detector the frame goes out empty: the boxes another
+                // worker found earlier would pass for fresh ones
+                finishFrame(stream, batch.frames[j], can_detect ? stream->last_detections : no_detections);
+            }
+        }
+        releaseBatch(batch);
+    }
+}
+
+void FramePipeline::finishFrame(Stream* stream, CapturedFrame& captured,
+                                const std::vector<Detection>& detections) {
+    int person_count = countPersons(detections);
+
+    // Update FPS once a second; keep the last value in between
+    auto now = std::chrono::steady_clock::now();
+    stream->fps_counter++;
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        now - stream->fps_time).count();
+    if (elapsed >= 1000) {
+        stream->fps = (stream->fps_counter * 1000.0f) / elapsed;
+        stream->fps_counter = 0;
+        stream->fps_time = now;
+        stream->hud_text = stream->stage_latencies.formatOverlay();
+    }
+
+    // Handed over clean and as BGR; the video panel converts only the
+    // frames it paints and composites the overlay on top
+    ProcessedFrame processed;
+    processed.image = std::move(captured.image);
+    processed.detections = detections;
+    processed.hud = stream->hud_text;
+    processed.stream_id = stream->id;
+    processed.frame_number = captured.frame_number;
+    processed.person_count = person_count;
+    if (stream->tracker.getOptions().enabled) {
+        processed.unique_persons = stream->tracker.uniqueCount();
+    }
+    processed.fps = stream->fps;
+    processed.capture_time = captured.capture_time;
+
+    stream->processed_count.fetch_add(1, std::memory_order_relaxed);
+    on_result(std::move(processed));
+}
+
+double FramePipeline::averageBatchSize() const {
+    uint64_t batches = batch_count.load(std::memory_order_relaxed);
+    return batches ? (double)batched_frames.load(std::memory_order_relaxed) / batches : 0.0;
+}
+
+PipelineStats FramePipeline::stats(int stream_id) const {
+    const Stream& stream = *streams[stream_id];
+    PipelineStats stats;
+    stats.captured = stream.queue.pushedCount();
+    stats.dropped = stream.queue.droppedCount();
+    stats.processed = stream.processed_count.load(std::memory_order_relaxed);
+    stats.detections_run = stream.detections_run.load(std::memory_order_relaxed);
+    stats.detections_skipped = stream.detections_skipped.load(std::memory_order_relaxed);
+    stats.detection_interval = stream.detection_interval.load(std::memory_order_relaxed);
+    stats.queue_depth = stream.queue.size();
+    stats.queue_capacity = stream.queue.getCapacity();
+    stats.queue_policy = stream.queue.getPolicy();
+    return stats;
+}
+
+StageLatencies& FramePipeline::latencies(int stream_id) {
+    return streams[stream_id]->stage_latencies;
+}
+
+const StageLatencies& FramePipeline::latencies(int stream_id) const {
+    return streams[stream_id]->stage_latencies;
+}
+
+void drawFrameOverlay(cv::Mat& image, const std::vector<Detection>& detections,
+                      int frame_number, int person_count, float fps,
+                      const std::string& hud) {
+    // Draw detections
+    for (const auto& det : detections) {
+        if (det.confidence > 0.5f) {
+            int x = (int)det.x;
+            int y = (int)det.y;
+            int w = (int)det.width;
+            int h = (int)det.height;
+
+            cv::rectangle(image, cv::Point(x, y), cv::Point(x + w, y + h),
+                         cv::Scalar(0, 255, 0), 2);
+            std::string label = det.track_id >= 0 ? "Person " + std::to_string(det.track_id) : "Person";
+            cv::putText(image, label + ": " + std::to_string((int)(det.confidence * 100)) + "%",
+                       cv::Point(x, y - 5), cv::FONT_HERSHEY_SIMPLEX, 0.5,
+                       cv::Scalar(0, 255, 0), 1);
+        }
+    }
+
+    // Add timestamp and info to frame
+    std::string timestamp = formatTimestamp(std::chrono::system_clock::now());
+    cv::putText(image, "Camera Feed - " + timestamp,
+               cv::Point(10, 30), cv::FONT_HERSHEY_SIMPLEX, 0.6,
+               cv::Scalar(0, 255, 0), 2);
+
+    cv::putText(image, "Frame: " + std::to_string(frame_number) + " | Persons: " + std::to_string(person_count),
+               cv::Point(10, 60), cv::FONT_HERSHEY_SIMPLEX, 0.5,
+               cv::Scalar(0, 255, 0), 1);
+
+    cv::putText(image, "FPS: " + std::to_string((int)fps),
+               cv::Point(10, 90), cv::FONT_HERSHEY_SIMPLEX, 0.5,
+               cv::Scalar(0, 255, 0), 1);
+
+    // HUD lines below the FPS
+    int y = 110;
+    size_t begin = 0;
+    while (begin < hud.size()) {
+        size_t end = hud.find('\n', begin);
+        if (end == std::string::npos) {
+            end = hud.size();
+        }
+        cv::putText(image, hud.substr(begin, end - begin),
+                   cv::Point(10, y), cv::FONT_HERSHEY_SIMPLEX, 0.45,
+                   cv::Scalar(0, 255, 255), 1);
+        y += 18;
+        begin = end + 1;
+    }
+}
@@ -0,0 +1,581 @@
+// Soak test: replays recorded sessions through the full pipeline (capture,
+// detection, tracking, counting, frame logging and the display conversion,
+// with the GUI mocked out) for as long as asked, then checks throughput,
+// latency, drops and memory growth against SLO thresholds. Also records the
+// raw sessions it replays, so a field problem can be captured once and
+// replayed against every new build.
+#include "app_config.h"
+#include "clip_recorder.h"
+#include "detector.h"
+#include "frame_log.h"
+#include "frame_log_store.h"
+#include "frame_source.h"
+#include "latency_histogram.h"
+#include "metrics.h"
+#include "pipeline.h"
+#include "timestamp.h"
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <csignal>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <unistd.h>
+#endif
+
+namespace {
+
+struct SoakOptions {
+    std::vector<std::string> inputs;  // one stream each
+    std::string record_path;          // record --source into this .raw file instead
+    std::string record_source = "0";
+    double seconds = 0.0;             // 0 = one pass over the inputs (60 s when recording)
+    double settle_seconds = 10.0;     // left out of FPS and memory growth
+    double report_seconds = 60.0;
+    int log_every = 10;               // frame log cadence, as in the GUI
+    // SLO thresholds; negative = not checked
+    double min_fps = -1.0;            // per stream, after settling
+    double max_p99_ms = -1.0;         // end-to-end, capture to display conversion
+    double max_drop_percent = -1.0;
+    double max_rss_growth_mb = -1.0;
+};
+
+std::atomic<bool> g_interrupted(false);
+
+void onSignal(int) {
+    g_interrupted = true;
+}
+
+void printUsage() {
+    std::cout << "Usage: wxapp_soak [options] SESSION.raw|SOURCE...\n"
+                 "       wxapp_soak --record=SESSION.raw [--source=SPEC] [--seconds=S]\n"
+                 "  --seconds=S           run length; inputs loop until then (default: one pass)\n"
+                 "  --settle=S            warm-up left out of FPS and RSS growth (default 10)\n"
+                 "  --report-every=S      progress line interval (default 60)\n"
+                 "  --log-every=N         frame log cadence (default 10); logs go to --log-dir\n"
+                 "  --min-fps=F           SLO: sustained FPS of the slowest stream\n"
+                 "  --max-p99-ms=T        SLO: end-to-end p99 latency of the slowest stream\n"
+                 "  --max-drop-percent=P  SLO: frames dropped by the capture queues\n"
+                 "  --max-rss-growth-mb=M SLO: resident memory growth after settling\n"
+                 "  --record=FILE.raw     record --source (default camera 0) for --seconds (default 60)\n"
+                 "Replay defaults to --replay=max --queue-policy=block, so every frame is processed\n"
+                 "in order and the person-count digest is comparable across builds. Exit code 3 =\n"
+                 "an SLO failed.\n"
+              << appConfigUsage();
+}
+
+double residentMb() {
+#ifdef __linux__
+    std::ifstream statm("/proc/self/statm");
+    size_t pages = 0, resident = 0;
+    if (statm >> pages >> resident) {
+        return resident * (double)sysconf(_SC_PAGESIZE) / (1 << 20);
+    }
+#endif
+    return 0.0;
+}
+
+// FNV-1a over each stream's (frame, person count) sequence
+uint64_t digestStep(uint64_t digest, int frame_number, int person_count) {
+    for (int value : {frame_number, person_count}) {
+        for (int byte = 0; byte < 4; ++byte) {
+            digest ^= (uint64_t)((value >> (8 * byte)) & 0xff);
+            digest *= 1099511628211ull;
+        }
+    }
+    return digest;
+}
+
+// Counting and logging output of one stream. Workers update it while they
+// hold the stream, so only one at a time; the main thread reads the atomics.
+struct StreamOutput {
+    explicit StreamOutput(size_t log_capacity) : ring(log_capacity) {}
+    FrameLogRing ring;
+    std::atomic<uint64_t> frames{0};
+    std::atomic<uint64_t> persons{0};
+    std::atomic<int> max_persons{0};
+    uint64_t digest = 14695981039346656037ull;  // FNV-1a offset basis
+    std::atomic<bool> finished{false};
+};
+
+// Stands in for MyFrame::UpdateFrame and VideoPanel: keeps the newest result
+// of each stream on its own thread, as the GUI's event loop would, and
+// converts at most one frame per stream per display refresh into an RGB
+// tile, recording Convert and EndToEnd like a paint does
+class MockDisplay {
+public:
+    MockDisplay(FramePipeline& pipeline, int streams, const cv::Size& tile)
+        : pipeline(pipeline), tile_size(tile), running(false) {
+        for (int i = 0; i < streams; ++i) {
+            tiles.push_back(std::make_unique<Tile>());
+        }
+    }
+
+    ~MockDisplay() { stop(); }
+
+    void start() {
+        running = true;
+        thread = std::thread(&MockDisplay::run, this);
+    }
+
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            running = false;
+        }
+        wake.notify_all();
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+
+    // From the inference workers; replaces a result not taken yet
+    void post(ProcessedFrame&& frame) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            Tile& tile = *tiles[frame.stream_id];
+            tile.pending = std::move(frame);
+            tile.ready = true;
+        }
+        wake.notify_one();
+    }
+
+    uint64_t painted(int stream_id) const { return tiles[stream_id]->painted.load(std::memory_order_relaxed); }
+
+private:
+    struct Tile {
+        ProcessedFrame pending;
+        bool ready = false;
+        cv::Mat frame;                 // shown frame, held like VideoPanel holds it
+        std::chrono::steady_clock::time_point capture_time;
+        bool dirty = false;
+        cv::Mat scaled;
+        cv::Mat rgb;
+        std::chrono::steady_clock::time_point last_paint;
+        std::atomic<uint64_t> painted{0};
+    };
+
+    void run() {
+        const auto refresh = std::chrono::microseconds(16667);
+        std::unique_lock<std::mutex> lock(mutex);
+        while (running) {
+            wake.wait_for(lock, refresh);
+            for (auto& tile : tiles) {
+                if (tile->ready) {
+                    tile->ready = false;
+                    tile->frame = tile->pending.image;
+                    tile->capture_time = tile->pending.capture_time;
+                    tile->pending = ProcessedFrame();
+                    tile->dirty = true;
+                }
+            }
+            lock.unlock();
+            auto now = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < tiles.size(); ++i) {
+                Tile& tile = *tiles[i];
+                if (tile.dirty && now - tile.last_paint >= refresh) {
+                    paint((int)i, tile);
+                    tile.last_paint = now;
+                }
+            }
+            lock.lock();
+        }
+    }
+
+    void paint(int stream_id, Tile& tile) {
+        StageTimer timer;
+        tile.dirty = false;
+        cv::resize(tile.frame, tile.scaled, tile_size, 0, 0, cv::INTER_AREA);
+        cv::cvtColor(tile.scaled, tile.rgb, cv::COLOR_BGR2RGB);
+        StageLatencies& latencies = pipeline.latencies(stream_id);
+        latencies.record(Stage::Convert, timer.lap());
+        latencies.record(Stage::EndToEnd, std::chrono::steady_clock::now() - tile.capture_time);
+        tile.painted.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    FramePipeline& pipeline;
+    cv::Size tile_size;
+    std::vector<std::unique_ptr<Tile>> tiles;
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool running;
+    std::thread thread;
+};
+
+bool parseSoakOptions(int argc, char** argv, SoakOptions& options,
+                      std::vector<std::string>& config_args) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        try {
+            if (arg == "--help" || arg == "-h") {
+                return false;
+            } else if (arg.rfind("--record=", 0) == 0) {
+                options.record_path = arg.substr(9);
+            } else if (arg.rfind("--source=", 0) == 0) {
+                options.record_source = arg.substr(9);
+            } else if (arg.rfind("--seconds=", 0) == 0) {
+                options.seconds = std::max(0.0, std::stod(arg.substr(10)));
+            } else if (arg.rfind("--settle=", 0) == 0) {
+                options.settle_seconds = std::max(0.0, std::stod(arg.substr(9)));
+            } else if (arg.rfind("--report-every=", 0) == 0) {
+                options.report_seconds = std::max(1.0, std::stod(arg.substr(15)));
+            } else if (arg.rfind("--log-every=", 0) == 0) {
+                options.log_every = std::max(1, std::stoi(arg.substr(12)));
+            } else if (arg.rfind("--min-fps=", 0) == 0) {
+                options.min_fps = std::stod(arg.substr(10));
+            } else if (arg.rfind("--max-p99-ms=", 0) == 0) {
+                options.max_p99_ms = std::stod(arg.substr(13));
+            } else if (arg.rfind("--max-drop-percent=", 0) == 0) {
+                options.max_drop_percent = std::stod(arg.substr(19));
+            } else if (arg.rfind("--max-rss-growth-mb=", 0) == 0) {
+                options.max_rss_growth_mb = std::stod(arg.substr(20));
+            } else if (arg.rfind("--", 0) == 0) {
+                config_args.push_back(arg);
+            } else {
+                options.inputs.push_back(arg);
+            }
+        } catch (const std::exception&) {
+            std::cerr << "Invalid value in " << arg << std::endl;
+            return false;
+        }
+    }
+    return !options.record_path.empty() || !options.inputs.empty();
+}
+
+std::string formatElapsed(double seconds) {
+    int total = (int)seconds;
+    char text[16];
+    std::snprintf(text, sizeof(text), "%02d:%02d:%02d", total / 3600, (total / 60) % 60, total % 60);
+    return text;
+}
+
+// Frames and their capture timestamps from one source into a raw file
+int recordSession(const SoakOptions& options, const AppConfig& config) {
+    FrameSourceOptions source_options;
+    source_options.size = config.pipeline.capture_size;
+    source_options.pacing = Pacing::Realtime;
+    std::string error;
+    std::unique_ptr<FrameSource> source = openFrameSource(options.record_source, source_options, error);
+    if (!source) {
+        std::cerr << error << std::endl;
+        return 2;
+    }
+
+    const double seconds = options.seconds > 0 ? options.seconds : 60.0;
+    std::cout << "Recording " << source->describe() << " to " << options.record_path << " for "
+              << seconds << " s (Ctrl+C stops early)" << std::endl;
+
+    RawFrameWriter writer;
+    cv::Mat frame;
+    FrameTime time;
+    auto start = std::chrono::steady_clock::now();
+    while (!g_interrupted && std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() < seconds) {
+        if (!source->read(frame, time)) {
+            break;
+        }
+        if (!writer.isOpen() && !writer.open(options.record_path, frame.size(), frame.type(), error)) {
+            std::cerr << error << std::endl;
+            return 2;
+        }
+        if (!writer.write(frame, time.media_ms)) {
+            std::cerr << "Failed to write " << options.record_path << std::endl;
+            return 2;
+        }
+    }
+    writer.close();
+    std::cout << "Recorded " << writer.frameCount() << " frame(s) in "
+              << std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() << " s"
+              << std::endl;
+    return writer.frameCount() > 0 ? 0 : 2;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    SoakOptions options;
+    std::vector<std::string> config_args;
+    if (!parseSoakOptions(argc, argv, options, config_args)) {
+        printUsage();
+        return 1;
+    }
+
+    // Deterministic by default: every frame, in order, as fast as it goes
+    AppConfig config;
+    config.pipeline.replay_pacing = Pacing::Max;
+    config.pipeline.queue_policy = QueuePolicy::Block;
+    config.log.spill = LogSpill::Disk;
+    config.log.dir = "soak_logs";
+    std::string error;
+    if (!parseAppConfig(config_args, config, error)) {
+        std::cerr << error << "\n\n";
+        printUsage();
+        return 1;
+    }
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+
+    if (!options.record_path.empty()) {
+        return recordSession(options, config);
+    }
+
+    config.pipeline.replay_loop = options.seconds > 0;
+    ThreadLayout layout = applyThreadLayout(config);
+    std::cout << formatThreadLayout(layout);
+
+    const int stream_count = (int)options.inputs.size();
+    std::vector<std::unique_ptr<StreamOutput>> outputs;
+    for (int i = 0; i < stream_count; ++i) {
+        outputs.push_back(std::make_unique<StreamOutput>(config.log.capacity));
+    }
+    std::mutex done_mutex;
+    std::condition_variable done;
+    std::atomic<int> finished_streams(0);
+    MockDisplay* display = nullptr;
+    ClipRecorder clip_recorder(config.clips);
+    for (int i = 0; i < stream_count && config.clips.enabled; ++i) {
+        clip_recorder.addStream(i);
+    }
+
+    PipelineMetrics metrics;
+
+    FramePipeline pipeline(
+        [&]() {
+            auto load_start = std::chrono::steady_clock::now();
+            std::unique_ptr<Detector> detector = createDetector(config.detector);
+            if (!detector || !detector->isInitialized()) {
+                std::cerr << "Warning: no detector, person counts will be 0" << std::endl;
+            } else {
+                metrics.setModelLoadMs(std::chrono::duration<double, std::milli>(
+                    std::chrono::steady_clock::now() - load_start).count());
+            }
+            return detector;
+        },
+        [&](ProcessedFrame&& processed) {
+            // What MyFrame::OnPipelineResult does, plus the count digest
+            metrics.observeResult(processed.stream_id, processed.person_count);
+            StreamOutput& output = *outputs[processed.stream_id];
+            output.frames.fetch_add(1, std::memory_order_relaxed);
+            output.persons.fetch_add((uint64_t)processed.person_count, std::memory_order_relaxed);
+            if (processed.person_count > output.max_persons.load(std::memory_order_relaxed)) {
+                output.max_persons.store(processed.person_count, std::memory_order_relaxed);
+            }
+            output.digest = digestStep(output.digest, processed.frame_number, processed.person_count);
+            if (processed.frame_number % options.log_every == 0) {
+                FrameLog log;
+                log.timestamp_ns = epochNanoseconds(std::chrono::system_clock::now());
+                log.frame_number = processed.frame_number;
+                log.person_count = processed.person_count;
+                log.unique_persons = processed.unique_persons;
+                log.latency_us = (int32_t)std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - processed.capture_time).count();
+                output.ring.push(log);
+            }
+            clip_recorder.push(processed.stream_id, processed.image, processed.person_count,
+                               processed.capture_time);
+            display->post(std::move(processed));
+        },
+        [&](int stream_id, const std::string& message) {
+            std::cout << message << std::endl;
+            if (!outputs[stream_id]->finished.exchange(true) && ++finished_streams == stream_count) {
+                std::lock_guard<std::mutex> lock(done_mutex);
+                done.notify_all();
+            }
+        },
+        config.pipeline);
+
+    std::vector<StreamSource> sources;
+    for (int i = 0; i < stream_count; ++i) {
+        sources.push_back({i, options.inputs[i]});
+    }
+    int cols = (int)std::ceil(std::sqrt((double)stream_count));
+    MockDisplay mock(pipeline, stream_count, cv::Size(640 / cols, 480 / cols));
+    display = &mock;
+
+    FrameLogWriter log_writer(config.log);
+    for (int i = 0; i < stream_count; ++i) {
+        log_writer.addSource(i, outputs[i]->ring);
+    }
+
+    std::vector<int> failed;
+    if (!pipeline.start(sources, &failed) || !failed.empty()) {
+        std::cerr << "Failed to open every input" << std::endl;
+        return 2;
+    }
+    metrics.attach(&pipeline);
+    MetricsServer metrics_server([&]() { return metrics.render(); });
+    if (config.metrics.port > 0) {
+        if (metrics_server.start(config.metrics.address, config.metrics.port, error)) {
+            std::cout << "Metrics at http://" << config.metrics.address << ":" << metrics_server.port()
+                      << "/metrics" << std::endl;
+        } else {
+            std::cerr << error << std::endl;
+        }
+    }
+    mock.start();
+    bool logging = log_writer.start();
+    if (config.clips.enabled) {
+        clip_recorder.start();
+    }
+
+    std::cout << "Soak: " << stream_count << " stream(s), "
+              << (options.seconds > 0 ? formatElapsed(options.seconds) : std::string("one pass"))
+              << ", replay " << pacingName(config.pipeline.replay_pacing) << ", queue "
+              << queuePolicyName(config.pipeline.queue_policy) << std::endl;
+
+    // Counters at the end of the settle period; the run start until then
+    auto start = std::chrono::steady_clock::now();
+    auto settle_time = start;
+    double settle_rss = residentMb();
+    std::vector<uint64_t> settle_frames(stream_count, 0);
+    bool settled = options.settle_seconds <= 0;
+    double worst_interval_fps = -1.0;
+
+    auto last_report = start;
+    std::vector<uint64_t> report_frames(stream_count, 0);
+    auto deadline = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                std::chrono::duration<double>(options.seconds));
+    while (!g_interrupted && finished_streams.load() < stream_count &&
+           (options.seconds <= 0 || std::chrono::steady_clock::now() < deadline)) {
+        {
+            std::unique_lock<std::mutex> lock(done_mutex);
+            done.wait_for(lock, std::chrono::milliseconds(200));
+        }
+        auto now = std::chrono::steady_clock::now();
+        double elapsed = std::chrono::duration<double>(now - start).count();
+        if (!settled && elapsed >= options.settle_seconds) {
+            settled = true;
+            settle_time = now;
+            settle_rss = residentMb();
+            for (int i = 0; i < stream_count; ++i) {
+                settle_frames[i] = outputs[i]->frames.load(std::memory_order_relaxed);
+                report_frames[i] = settle_frames[i];
+            }
+            last_report = now;
+        }
+
+        double interval = std::chrono::duration<double>(now - last_report).count();
+        if (interval < options.report_seconds) {
+            continue;
+        }
+        double slowest_fps = -1.0, p50 = 0.0, p99 = 0.0;
+        uint64_t dropped = 0;
+        for (int i = 0; i < stream_count; ++i) {
+            uint64_t frames = outputs[i]->frames.load(std::memory_order_relaxed);
+            double fps = (frames - report_frames[i]) / interval;
+            report_frames[i] = frames;
+            slowest_fps = slowest_fps < 0 ? fps : std::min(slowest_fps, fps);
+            const LatencyHistogram& e2e = pipeline.latencies(i).get(Stage::EndToEnd);
+            p50 = std::max(p50, e2e.percentileMs(50));
+            p99 = std::max(p99, e2e.percentileMs(99));
+            dropped += pipeline.stats(i).dropped;
+        }
+        if (settled) {
+            worst_interval_fps = worst_interval_fps < 0 ? slowest_fps : std::min(worst_interval_fps, slowest_fps);
+        }
+        last_report = now;
+        double rss = residentMb();
+        std::printf("[%s] %.1f FPS/stream | e2e p50 %.1f p99 %.1f ms | dropped %llu | RSS %.1f MB (%+.1f)%s\n",
+                    formatElapsed(elapsed).c_str(), slowest_fps, p50, p99, (unsigned long long)dropped, rss,
+                    rss - settle_rss, settled ? "" : " settling");
+        std::fflush(stdout);
+    }
+    if (g_interrupted) {
+        std::cout << "Interrupted" << std::endl;
+    }
+
+    // Once every input ran out, let the workers finish the frames still
+    // queued: stop() discards them, and which ones are left depends on
+    // timing, so frame counts and digests would differ from run to run
+    if (finished_streams.load() == stream_count) {
+        auto drained = [&]() {
+            for (int i = 0; i < stream_count; ++i) {
+                PipelineStats stats = pipeline.stats(i);
+                if (stats.processed + stats.dropped < stats.captured) {
+                    return false;
+                }
+            }
+            return true;
+        };
+        while (!g_interrupted && !drained()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+    }
+
+    auto end = std::chrono::steady_clock::now();
+    metrics_server.stop();
+    pipeline.stop();
+    metrics.detach();
+    mock.stop();
+    if (logging) {
+        log_writer.stop();
+    }
+    clip_recorder.stop();
+    double end_rss = residentMb();
+    double run_seconds = std::chrono::duration<double>(end - start).count();
+    double measured_seconds = std::chrono::duration<double>(end - settle_time).count();
+    if (!settled) {
+        std::cout << "Run shorter than --settle; FPS and RSS growth cover the whole run" << std::endl;
+    }
+
+    std::printf("\n%-6s %-28s %9s %7s %8s %8s %8s %8s %8s %9s  %s\n", "Stream", "Source", "Frames", "FPS",
+                "Drop %", "p50 ms", "p95 ms", "p99 ms", "max ms", "Persons", "Digest");
+    double slowest_fps = -1.0, worst_p99 = 0.0, worst_drop = 0.0;
+    int slowest = 0;
+    for (int i = 0; i < stream_count; ++i) {
+        const StreamOutput& output = *outputs[i];
+        PipelineStats stats = pipeline.stats(i);
+        uint64_t frames = output.frames.load(std::memory_order_relaxed);
+        double fps = measured_seconds > 0 ? (frames - settle_frames[i]) / measured_seconds : 0.0;
+        double drop = stats.captured ? 100.0 * stats.dropped / stats.captured : 0.0;
+        LatencyHistogram::Summary e2e = pipeline.latencies(i).get(Stage::EndToEnd).summary();
+        if (slowest_fps < 0 || fps < slowest_fps) {
+            slowest_fps = fps;
+            slowest = i;
+        }
+        worst_p99 = std::max(worst_p99, e2e.p99_ms);
+        worst_drop = std::max(worst_drop, drop);
+        char persons[32];
+        std::snprintf(persons, sizeof(persons), "%.2f/%d",
+                      frames ? (double)output.persons.load() / frames : 0.0, output.max_persons.load());
+        std::printf("%-6d %-28.28s %9llu %7.1f %8.3f %8.1f %8.1f %8.1f %8.1f %9s  %016llx\n", i,
+                    pipeline.sourceName(i).c_str(), (unsigned long long)frames, fps, drop, e2e.p50_ms,
+                    e2e.p95_ms, e2e.p99_ms, e2e.max_ms, persons, (unsigned long long)output.digest);
+    }
+    std::cout << "\nStages of stream " << slowest << ":\n" << pipeline.latencies(slowest).formatTable();
+    double growth = end_rss - settle_rss;
+    std::printf("Run %s, %.1f s measured | batch %.2f | RSS %.1f -> %.1f MB (%+.1f)\n",
+                formatElapsed(run_seconds).c_str(), measured_seconds, pipeline.averageBatchSize(),
+                settle_rss, end_rss, growth);
+    if (config.clips.enabled) {
+        std::printf("Clips saved: %zu\n", clip_recorder.clips().size());
+    }
+    if (worst_interval_fps >= 0) {
+        std::printf("Slowest %.0f s interval: %.1f FPS\n", options.report_seconds, worst_interval_fps);
+    }
+
+    bool pass = true;
+    auto check = [&](const char* name, double limit, double value, bool ok) {
+        if (limit < 0) {
+            return;
+        }
+        std::printf("SLO %-18s %10.2f (limit %.2f)  %s\n", name, value, limit, ok ? "PASS" : "FAIL");
+        pass = pass && ok;
+    };
+    std::cout << "\n";
+    check("min FPS", options.min_fps, slowest_fps, slowest_fps >= options.min_fps);
+    check("max p99 ms", options.max_p99_ms, worst_p99, worst_p99 <= options.max_p99_ms);
+    check("max drop %", options.max_drop_percent, worst_drop, worst_drop <= options.max_drop_percent);
+    check("max RSS growth MB", options.max_rss_growth_mb, growth, growth <= options.max_rss_growth_mb);
+    return pass ? 0 : 3;
+}
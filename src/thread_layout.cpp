@@ -0,0 +1,300 @@
+#include "thread_layout.h"
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <thread>
+#include <utility>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+
+int readSysInt(const std::string& path, int fallback) {
+    std::ifstream in(path);
+    int value = fallback;
+    if (!(in >> value)) {
+        return fallback;
+    }
+    return value;
+}
+
+// Physical cores in order of their first CPU, each with its SMT siblings
+std::vector<std::vector<int>> groupCores(const std::vector<LogicalCpu>& cpus) {
+    std::vector<std::vector<int>> cores;
+    std::map<std::pair<int, int>, size_t> index;
+    for (const auto& cpu : cpus) {
+        auto key = std::make_pair(cpu.package, cpu.core);
+        auto it = index.find(key);
+        if (it == index.end()) {
+            index[key] = cores.size();
+            cores.push_back({cpu.id});
+        } else {
+            cores[it->second].push_back(cpu.id);
+        }
+    }
+    return cores;
+}
+
+// First sibling of every physical core cpus touch
+std::vector<int> onePerCore(const std::vector<int>& cpus, const CpuTopology& topology) {
+    std::vector<LogicalCpu> selected;
+    for (const auto& cpu : topology.cpus) {
+        if (std::find(cpus.begin(), cpus.end(), cpu.id) != cpus.end()) {
+            selected.push_back(cpu);
+        }
+    }
+    std::vector<int> compute;
+    for (const auto& core : groupCores(selected)) {
+        compute.push_back(core.front());
+    }
+    return selected.empty() ? cpus : compute;
+}
+
+std::string describeCpus(const std::vector<int>& cpus) {
+    return cpus.empty() ? "any CPU" : "CPUs " + formatCpuList(cpus);
+}
+
+} // namespace
+
+CpuTopology detectCpuTopology() {
+    CpuTopology topology;
+#ifdef __linux__
+    // Respects taskset and cgroup cpusets, not just what the machine has
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) == 0) {
+        for (int id = 0; id < CPU_SETSIZE; ++id) {
+            if (!CPU_ISSET(id, &allowed)) {
+                continue;
+            }
+            std::string base = "/sys/devices/system/cpu/cpu" + std::to_string(id) + "/topology/";
+            LogicalCpu cpu;
+            cpu.id = id;
+            cpu.core = readSysInt(base + "core_id", id);
+            cpu.package = readSysInt(base + "physical_package_id", 0);
+            topology.cpus.push_back(cpu);
+        }
+    }
+
+    std::error_code ec;
+    int nodes = 0;
+    for (fs::directory_iterator it("/sys/devices/system/node", ec), end; !ec && it != end; it.increment(ec)) {
+        std::string name = it->path().filename().string();
+        if (name.rfind("node", 0) != 0 || name.size() == 4 ||
+            !std::all_of(name.begin() + 4, name.end(), ::isdigit)) {
+            continue;
+        }
+        int node = std::stoi(name.substr(4));
+        std::ifstream in(it->path() / "cpulist");
+        std::string list;
+        std::vector<int> node_cpus;
+        if (!std::getline(in, list) || !parseCpuList(list, node_cpus)) {
+            continue;
+        }
+        nodes++;
+        for (auto& cpu : topology.cpus) {
+            if (std::binary_search(node_cpus.begin(), node_cpus.end(), cpu.id)) {
+                cpu.node = node;
+            }
+        }
+    }
+    topology.numa_nodes = std::max(1, nodes);
+#endif
+    if (topology.cpus.empty()) {
+        int hardware_threads = std::max(1u, std::thread::hardware_concurrency());
+        for (int id = 0; id < hardware_threads; ++id) {
+            LogicalCpu cpu;
+            cpu.id = id;
+            cpu.core = id;
+            topology.cpus.push_back(cpu);
+        }
+    }
+    return topology;
+}
+
+ThreadLayout planThreadLayout(const ThreadingOptions& options, const CpuTopology& topology,
+                              bool onnxruntime) {
+    ThreadLayout layout;
+    layout.logical_cpus = (int)topology.cpus.size();
+    layout.physical_cores = (int)groupCores(topology.cpus).size();
+    layout.numa_nodes = topology.numa_nodes;
+    layout.onnxruntime = onnxruntime;
+
+    // Stay on one node: the one asked for, else the first CPU's
+    std::vector<LogicalCpu> cpus = topology.cpus;
+    int node = options.numa_node;
+    if (node < 0 && options.affinity && topology.numa_nodes > 1 && !cpus.empty()) {
+        node = cpus.front().node;
+    }
+    if (node >= 0) {
+        std::vector<LogicalCpu> local;
+        for (const auto& cpu : cpus) {
+            if (cpu.node == node) {
+                local.push_back(cpu);
+            }
+        }
+        if (local.empty()) {
+            std::cerr << "NUMA node " << node << " has none of our CPUs, not pinning to it" << std::endl;
+            node = -1;
+        } else {
+            cpus.swap(local);
+        }
+    }
+    layout.numa_node = node;
+
+    std::vector<std::vector<int>> cores = groupCores(cpus);
+    if (options.affinity && cores.size() >= 4) {
+        size_t reserved = std::max<size_t>(1, cores.size() / 8);
+        for (size_t c = 0; c < cores.size(); ++c) {
+            std::vector<int>& stage = c < reserved ? layout.gui_cpus : layout.inference_cpus;
+            stage.insert(stage.end(), cores[c].begin(), cores[c].end());
+            if (c >= reserved) {
+                layout.compute_cpus.push_back(cores[c].front());
+            }
+        }
+        layout.capture_cpus = layout.gui_cpus;
+    } else if (options.affinity && node >= 0) {
+        // Too few cores to split, but still node-local
+        for (const auto& core : cores) {
+            layout.inference_cpus.insert(layout.inference_cpus.end(), core.begin(), core.end());
+            layout.compute_cpus.push_back(core.front());
+        }
+        layout.gui_cpus = layout.capture_cpus = layout.inference_cpus;
+    }
+
+    if (!options.gui_cpus.empty()) {
+        layout.gui_cpus = options.gui_cpus;
+    }
+    if (!options.capture_cpus.empty()) {
+        layout.capture_cpus = options.capture_cpus;
+    }
+    if (!options.inference_cpus.empty()) {
+        layout.inference_cpus = options.inference_cpus;
+        layout.compute_cpus = onePerCore(options.inference_cpus, topology);
+    }
+    for (auto* stage : {&layout.gui_cpus, &layout.capture_cpus, &layout.inference_cpus}) {
+        std::sort(stage->begin(), stage->end());
+    }
+    std::sort(layout.compute_cpus.begin(), layout.compute_cpus.end());
+
+    int compute_cores = layout.compute_cpus.empty() ? (int)cores.size() : (int)layout.compute_cpus.size();
+    layout.ort_intra_threads = options.ort_intra_threads > 0 ? options.ort_intra_threads : std::max(1, compute_cores);
+    // The graph runs sequentially; inter-op threads would only idle
+    layout.ort_inter_threads = options.ort_inter_threads > 0 ? options.ort_inter_threads : 1;
+    layout.ort_spinning = options.ort_spinning;
+    // ORT does the heavy lifting on its own pool; OpenCV only resizes, and
+    // a second pool of the same size would fight it for the cores
+    layout.opencv_threads = options.opencv_threads > 0 ? options.opencv_threads : layout.onnxruntime ? 1 : 0;
+    return layout;
+}
+
+std::string formatThreadLayout(const ThreadLayout& layout) {
+    std::ostringstream out;
+    out << "Threads: " << layout.logical_cpus << " CPU(s), " << layout.physical_cores
+        << " physical core(s), " << layout.numa_nodes << " NUMA node(s)";
+    if (layout.numa_node >= 0) {
+        out << ", using node " << layout.numa_node;
+    }
+    out << "\n  GUI:       " << describeCpus(layout.gui_cpus)
+        << "\n  capture:   " << describeCpus(layout.capture_cpus)
+        << "\n  inference: " << describeCpus(layout.inference_cpus);
+    if (layout.onnxruntime) {
+        out << "\n  ONNX Runtime: " << layout.ort_intra_threads << " intra-op thread(s)";
+        if (!layout.compute_cpus.empty()) {
+            out << " on CPUs " << formatCpuList(layout.compute_cpus);
+        }
+        out << ", " << layout.ort_inter_threads << " inter-op, spinning "
+            << (layout.ort_spinning ? "on" : "off");
+    }
+    out << "\n  OpenCV: ";
+    if (layout.opencv_threads > 0) {
+        out << layout.opencv_threads << " thread(s)";
+    } else {
+        out << "an equal share of the inference cores per worker";
+    }
+    out << "\n";
+    return out.str();
+}
+
+bool pinCurrentThread(const std::vector<int>& cpus) {
+    if (cpus.empty()) {
+        return true;
+    }
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus) {
+        if (cpu >= 0 && cpu < CPU_SETSIZE) {
+            CPU_SET(cpu, &set);
+        }
+    }
+    int rc = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    if (rc != 0) {
+        std::cerr << "Failed to pin thread to CPUs " << formatCpuList(cpus) << " (error " << rc << ")" << std::endl;
+        return false;
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool parseCpuList(const std::string& value, std::vector<int>& cpus) {
+    cpus.clear();
+    std::istringstream list(value);
+    std::string item;
+    try {
+        while (std::getline(list, item, ',')) {
+            size_t dash = item.find('-');
+            size_t used = 0;
+            int first = std::stoi(item.substr(0, dash), &used);
+            if (used != item.substr(0, dash).size()) {
+                return false;
+            }
+            int last = first;
+            if (dash != std::string::npos) {
+                std::string end = item.substr(dash + 1);
+                last = std::stoi(end, &used);
+                if (used != end.size()) {
+                    return false;
+                }
+            }
+            if (first < 0 || last < first) {
+                return false;
+            }
+            for (int cpu = first; cpu <= last; ++cpu) {
+                cpus.push_back(cpu);
+            }
+        }
+    } catch (const std::exception&) {
+        return false;
+    }
+    std::sort(cpus.begin(), cpus.end());
+    cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+    return !cpus.empty();
+}
+
+std::string formatCpuList(const std::vector<int>& cpus) {
+    std::string list;
+    for (size_t i = 0; i < cpus.size();) {
+        size_t j = i;
+        while (j + 1 < cpus.size() && cpus[j + 1] == cpus[j] + 1) {
+            ++j;
+        }
+        list += (list.empty() ? "" : ",") + std::to_string(cpus[i]);
+        if (j > i) {
+            list += "-" + std::to_string(cpus[j]);
+        }
+        i = j + 1;
+    }
+    return list;
+}
@@ -0,0 +1,133 @@
+#include "tiled_detector.h"
+#include "latency_histogram.h"
+#include <algorithm>
+
+TiledDetector::TiledDetector(std::vector<std::unique_ptr<Detector>> detectors,
+                             const TilingOptions& options, const NmsOptions& nms)
+    : detectors(std::move(detectors)), options(options), suppressor(tileMergeOptions(nms)) {
+    shares.resize(this->detectors.size());
+    for (size_t w = 1; w < this->detectors.size(); ++w) {
+        share_threads.emplace_back(&TiledDetector::shareLoop, this, w);
+    }
+}
+
+TiledDetector::~TiledDetector() {
+    {
+        std::lock_guard<std::mutex> lock(share_mutex);
+        stopping = true;
+    }
+    share_start.notify_all();
+    for (auto& thread : share_threads) {
+        thread.join();
+    }
+}
+
+void TiledDetector::runShare(size_t w) {
+    detectors[w]->detectBatch(shares[w].views, shares[w].results);
+    shares[w].timings = detectors[w]->lastTimings();
+}
+
+// Waits for each frame's round and runs share w if the frame has that many
+void TiledDetector::shareLoop(size_t w) {
+    uint64_t seen = 0;
+    std::unique_lock<std::mutex> lock(share_mutex);
+    while (true) {
+        share_start.wait(lock, [&]() { return stopping || share_round != seen; });
+        if (stopping) {
+            return;
+        }
+        seen = share_round;
+        if (w >= share_count) {
+            continue;
+        }
+        lock.unlock();
+        runShare(w);
+        lock.lock();
+        if (--shares_pending == 0) {
+            share_done.notify_one();
+        }
+    }
+}
+
+bool TiledDetector::isInitialized() const {
+    for (const auto& detector : detectors) {
+        if (!detector || !detector->isInitialized()) {
+            return false;
+        }
+    }
+    return !detectors.empty();
+}
+
+std::string TiledDetector::name() const {
+    return detectors.empty() ? "tiled" : detectors.front()->name() + "+tiles";
+}
+
+std::vector<Detection> TiledDetector::detect(const cv::Mat& frame) {
+    timings = DetectTimings();
+    if (frame.empty() || !isInitialized()) {
+        return {};
+    }
+
+    if (frame.size() != tiled_size) {
+        tiled_size = frame.size();
+        tiles = computeTiles(tiled_size, options);
+    }
+
+    // Views are ROI headers into the frame, the last one the whole frame for
+    // people too large for a single tile
+    const cv::Rect whole(0, 0, frame.cols, frame.rows);
+    const bool overview = options.overview &&
+                          !(tiles.size() == 1 && tiles[0].area() == whole.area());
+    const size_t view_count = tiles.size() + (overview ? 1 : 0);
+    const size_t used_shares = std::min(shares.size(), view_count);
+
+    for (size_t w = 0; w < used_shares; ++w) {
+        Share& share = shares[w];
+        share.views.clear();
+        for (size_t v = view_count * w / used_shares; v < view_count * (w + 1) / used_shares; ++v) {
+            share.views.push_back(v < tiles.size() ? frame(tiles[v]) : frame);
+        }
+    }
+
+    if (used_shares > 1) {
+        {
+            std::lock_guard<std::mutex> lock(share_mutex);
+            share_count = used_shares;
+            shares_pending = used_shares - 1;
+            ++share_round;
+        }
+        share_start.notify_all();
+    }
+    runShare(0);
+    if (used_shares > 1) {
+        std::unique_lock<std::mutex> lock(share_mutex);
+        share_done.wait(lock, [this]() { return shares_pending == 0; });
+    }
+
+    // Shares ran side by side, so the slowest one is the wall time of each stage
+    StageTimer timer;
+    tile_detections.resize(view_count);
+    size_t v = 0;
+    for (size_t w = 0; w < used_shares; ++w) {
+        const Share& share = shares[w];
+        timings.preprocess_us = std::max(timings.preprocess_us, share.timings.preprocess_us);
+        timings.forward_us = std::max(timings.forward_us, share.timings.forward_us);
+        timings.decode_us = std::max(timings.decode_us, share.timings.decode_us);
+        timings.nms_us = std::max(timings.nms_us, share.timings.nms_us);
+
+        for (size_t i = 0; i < share.results.size(); ++i, ++v) {
+            TileDetections& tile = tile_detections[v];
+            tile.overview = v >= tiles.size();
+            tile.tile = tile.overview ? whole : tiles[v];
+            tile.detections = share.results[i];
+            for (auto& det : tile.detections) {
+                det.x += tile.tile.x;
+                det.y += tile.tile.y;
+            }
+        }
+    }
+    std::vector<Detection> detections = mergeTileDetections(tile_detections, frame.size(),
+                                                            suppressor);
+    timings.nms_us += timer.lap();
+    return detections;
+}
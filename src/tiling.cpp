@@ -0,0 +1,84 @@
+#include "tiling.h"
+#include <algorithm>
+
+namespace {
+
+// Evenly spread tile origins along one axis of [start, start + length)
+std::vector<int> tileOrigins(int start, int length, int tile, float overlap) {
+    if (length <= tile) {
+        return {start};
+    }
+    int stride = std::max(1, (int)(tile * (1.0f - overlap)));
+    int count = (length - tile + stride - 1) / stride + 1;
+    std::vector<int> origins(count);
+    for (int i = 0; i < count; ++i) {
+        origins[i] = start + (int)((int64_t)i * (length - tile) / (count - 1));
+    }
+    return origins;
+}
+
+// True if the box touches a tile edge that lies inside the frame
+bool cutByTileEdge(const Detection& det, const cv::Rect& tile, const cv::Size& frame_size) {
+    const float margin = 2.0f;
+    return (tile.x > 0 && det.x <= tile.x + margin) ||
+           (tile.y > 0 && det.y <= tile.y + margin) ||
+           (tile.x + tile.width < frame_size.width &&
+            det.x + det.width >= tile.x + tile.width - margin) ||
+           (tile.y + tile.height < frame_size.height &&
+            det.y + det.height >= tile.y + tile.height - margin);
+}
+
+} // namespace
+
+std::vector<cv::Rect> computeTiles(const cv::Size& frame_size, const TilingOptions& options) {
+    const cv::Rect frame(0, 0, frame_size.width, frame_size.height);
+    const int tile = std::max(32, options.tile_size);
+    const float overlap = std::min(0.9f, std::max(0.0f, options.overlap));
+
+    std::vector<cv::Rect> areas;
+    for (const auto& region : options.regions) {
+        cv::Rect clipped = region & frame;
+        if (!clipped.empty()) {
+            areas.push_back(clipped);
+        }
+    }
+    if (areas.empty()) {
+        areas.push_back(frame);
+    }
+
+    std::vector<cv::Rect> tiles;
+    for (const auto& area : areas) {
+        for (int y : tileOrigins(area.y, area.height, tile, overlap)) {
+            for (int x : tileOrigins(area.x, area.width, tile, overlap)) {
+                tiles.emplace_back(x, y, std::min(tile, area.width), std::min(tile, area.height));
+            }
+        }
+    }
+    return tiles;
+}
+
+std::vector<Detection> mergeTileDetections(const std::vector<TileDetections>& tiles,
+                                           const cv::Size& frame_size,
+                                           NonMaxSuppressor& suppressor) {
+    std::vector<Detection> boxes;
+    std::vector<float> ranks;
+    for (const auto& tile : tiles) {
+        for (const auto& det : tile.detections) {
+            // Confidences are at most 1, so every whole box outranks every cut one
+            bool cut = !tile.overview && cutByTileEdge(det, tile.tile, frame_size);
+            boxes.push_back(det);
+            ranks.push_back(det.confidence + (cut ? 0.0f : 2.0f));
+        }
+    }
+
+    std::vector<Detection> kept;
+    suppressor.suppress(boxes, kept, &ranks);
+    return kept;
+}
+
+NmsOptions tileMergeOptions(const NmsOptions& nms) {
+    NmsOptions merge = nms;
+    merge.soft = false;
+    merge.containment_threshold = 0.7f;
+    return merge;
+}
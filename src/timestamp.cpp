@@ -0,0 +1,37 @@
+#include "timestamp.h"
+#include <cstdio>
+#include <ctime>
+
+std::string formatTimestamp(std::chrono::system_clock::time_point time) {
+    return formatTimestamp(epochNanoseconds(time));
+}
+
+std::string formatTimestamp(int64_t epoch_ns) {
+    int64_t total_ms = epoch_ns / 1000000 - (epoch_ns % 1000000 < 0 ? 1 : 0);
+    std::time_t seconds = (std::time_t)(total_ms / 1000 - (total_ms % 1000 < 0 ? 1 : 0));
+    int ms = (int)(total_ms - (int64_t)seconds * 1000);
+
+    // Local time conversion is the slow part and an export formats many entries
+    // of the same second, so each thread keeps its last one. localtime()
+    // shares a static buffer; the pipeline threads format timestamps too.
+    thread_local std::time_t cached_seconds = 0;
+    thread_local char cached[24] = "";
+    if (seconds != cached_seconds || cached[0] == '\0') {
+        std::tm local_tm{};
+#ifdef _WIN32
+        localtime_s(&local_tm, &seconds);
+#else
+        localtime_r(&seconds, &local_tm);
+#endif
+        std::strftime(cached, sizeof(cached), "%Y-%m-%d %H:%M:%S", &local_tm);
+        cached_seconds = seconds;
+    }
+
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%s.%03d", cached, ms);
+    return buffer;
+}
+
+int64_t epochNanoseconds(std::chrono::system_clock::time_point time) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+}
@@ -0,0 +1,297 @@
+#include "tracker.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+// Noise levels of the original SORT filter, in pixels (area in pixels^2)
+constexpr float kPositionNoise = 1.0f;
+constexpr float kVelocityNoise = 0.01f;
+constexpr float kAreaVelocityNoise = 0.0001f;
+constexpr float kPositionMeasurementNoise = 1.0f;
+constexpr float kShapeMeasurementNoise = 10.0f;
+constexpr float kInitialVariance = 10.0f;
+constexpr float kInitialVelocityVariance = 10000.0f;
+
+} // namespace
+
+void KalmanAxis::init(float measured, float value_variance, float velocity_variance) {
+    value = measured;
+    velocity = 0.0f;
+    p00 = value_variance;
+    p01 = 0.0f;
+    p11 = velocity_variance;
+}
+
+void KalmanAxis::predict(float value_noise, float velocity_noise) {
+    value += velocity;
+    p00 += 2.0f * p01 + p11 + value_noise;
+    p01 += p11;
+    p11 += velocity_noise;
+}
+
+void KalmanAxis::correct(float measured, float measurement_noise) {
+    float residual = measured - value;
+    float s = p00 + measurement_noise;
+    float k0 = p00 / s;
+    float k1 = p01 / s;
+    value += k0 * residual;
+    velocity += k1 * residual;
+    p11 -= k1 * p01;
+    p00 -= k0 * p00;
+    p01 -= k0 * p01;
+}
+
+float boxIoU(const Detection& a, const Detection& b) {
+    float x1 = std::max(a.x, b.x);
+    float y1 = std::max(a.y, b.y);
+    float x2 = std::min(a.x + a.width, b.x + b.width);
+    float y2 = std::min(a.y + a.height, b.y + b.height);
+    float inter = std::max(0.0f, x2 - x1) * std::max(0.0f, y2 - y1);
+    float uni = a.width * a.height + b.width * b.height - inter;
+    return uni > 0.0f ? inter / uni : 0.0f;
+}
+
+std::vector<int> solveAssignment(const std::vector<float>& cost, int rows, int cols) {
+    std::vector<int> result(rows, -1);
+    if (rows == 0 || cols == 0) {
+        return result;
+    }
+
+    // The potentials method needs n <= m; solve the transpose otherwise
+    const bool transposed = rows > cols;
+    const int n = transposed ? cols : rows;
+    const int m = transposed ? rows : cols;
+    auto at = [&](int i, int j) {
+        return (double)(transposed ? cost[j * cols + i] : cost[i * cols + j]);
+    };
+
+    const double inf = std::numeric_limits<double>::infinity();
+    std::vector<double> u(n + 1, 0.0), v(m + 1, 0.0), min_slack(m + 1);
+    std::vector<int> match(m + 1, 0), way(m + 1, 0);  // match[j] = row of column j, 1-based
+    std::vector<char> used(m + 1);
+
+    for (int i = 1; i <= n; ++i) {
+        match[0] = i;
+        int j0 = 0;
+        std::fill(min_slack.begin(), min_slack.end(), inf);
+        std::fill(used.begin(), used.end(), 0);
+        do {
+            used[j0] = 1;
+            int i0 = match[j0], j1 = 0;
+            double delta = inf;
+            for (int j = 1; j <= m; ++j) {
+                if (used[j]) {
+                    continue;
+                }
+                double slack = at(i0 - 1, j - 1) - u[i0] - v[j];
+                if (slack < min_slack[j]) {
+                    min_slack[j] = slack;
+                    way[j] = j0;
+                }
+                if (min_slack[j] < delta) {
+                    delta = min_slack[j];
+                    j1 = j;
+                }
+            }
+            for (int j = 0; j <= m; ++j) {
+                if (used[j]) {
+                    u[match[j]] += delta;
+                    v[j] -= delta;
+                } else {
+                    min_slack[j] -= delta;
+                }
+            }
+            j0 = j1;
+        } while (match[j0] != 0);
+
+        // Flip the augmenting path
+        do {
+            int j1 = way[j0];
+            match[j0] = match[j1];
+            j0 = j1;
+        } while (j0 != 0);
+    }
+
+    for (int j = 1; j <= m; ++j) {
+        if (match[j] == 0) {
+            continue;
+        }
+        if (transposed) {
+            result[j - 1] = match[j] - 1;
+        } else {
+            result[match[j] - 1] = j - 1;
+        }
+    }
+    return result;
+}
+
+MultiObjectTracker::MultiObjectTracker(const TrackerOptions& options)
+    : options(options), next_id(1), unique_count(0), interval(1),
+      frames_since_detection(0) {
+    reset();
+}
+
+void MultiObjectTracker::reset() {
+    active.clear();
+    output.clear();
+    next_id = 1;
+    unique_count = 0;
+    interval = std::max(1, options.min_interval);
+    // The first frame always goes to the detector
+    frames_since_detection = std::max(interval, options.max_interval);
+}
+
+bool MultiObjectTracker::shouldDetect() {
+    if (++frames_since_detection >= interval) {
+        frames_since_detection = 0;
+        return true;
+    }
+    return false;
+}
+
+Detection MultiObjectTracker::predictedBox(const Track& track) const {
+    float area = std::max(track.area.value, 1.0f);
+    float aspect = std::max(track.aspect.value, 0.01f);
+    float width = std::sqrt(area * aspect);
+    float height = area / width;
+
+    Detection box = track.last;
+    box.x = track.cx.value - width / 2;
+    box.y = track.cy.value - height / 2;
+    box.width = width;
+    box.height = height;
+    box.track_id = track.id;
+    return box;
+}
+
+void MultiObjectTracker::predictTracks() {
+    for (auto& track : active) {
+        // A shrinking box must not predict a negative area
+        if (track.area.value + track.area.velocity <= 0.0f) {
+            track.area.velocity = 0.0f;
+        }
+        track.cx.predict(kPositionNoise, kVelocityNoise);
+        track.cy.predict(kPositionNoise, kVelocityNoise);
+        track.area.predict(kPositionNoise, kAreaVelocityNoise);
+        track.aspect.predict(kPositionNoise, 0.0f);
+    }
+}
+
+void MultiObjectTracker::predict() {
+    predictTracks();
+    publish();
+}
+
+void MultiObjectTracker::update(const std::vector<Detection>& detections) {
+    predictTracks();
+
+    candidates.clear();
+    for (const auto& det : detections) {
+        if (det.class_id == 0 && det.confidence > options.min_confidence &&
+            det.width > 0 && det.height > 0) {
+            candidates.push_back(det);
+        }
+    }
+
+    // Match detections to the predicted boxes by IoU
+    const int rows = (int)active.size();
+    const int cols = (int)candidates.size();
+    cost.resize((size_t)rows * cols);
+    for (int t = 0; t < rows; ++t) {
+        Detection predicted = predictedBox(active[t]);
+        for (int c = 0; c < cols; ++c) {
+            cost[t * cols + c] = 1.0f - boxIoU(predicted, candidates[c]);
+        }
+    }
+    assignment = solveAssignment(cost, rows, cols);
+
+    std::vector<char> matched(cols, 0);
+    for (int t = 0; t < rows; ++t) {
+        Track& track = active[t];
+        int c = assignment[t];
+        if (c < 0 || 1.0f - cost[t * cols + c] < options.iou_threshold) {
+            track.misses++;
+            continue;
+        }
+        matched[c] = 1;
+
+        const Detection& det = candidates[c];
+        track.cx.correct(det.x + det.width / 2, kPositionMeasurementNoise);
+        track.cy.correct(det.y + det.height / 2, kPositionMeasurementNoise);
+        track.area.correct(det.width * det.height, kShapeMeasurementNoise);
+        track.aspect.correct(det.width / det.height, kShapeMeasurementNoise);
+        track.last = det;
+        track.hits++;
+        track.misses = 0;
+        if (track.id < 0 && track.hits >= options.min_hits) {
+            track.id = next_id++;
+            unique_count++;
+        }
+    }
+
+    // Tentative tracks die on their first miss, which filters one-frame flicker
+    active.erase(std::remove_if(active.begin(), active.end(), [&](const Track& track) {
+        return (track.id < 0 && track.misses > 0) || track.misses > options.max_misses;
+    }), active.end());
+
+    for (int c = 0; c < cols; ++c) {
+        if (matched[c]) {
+            continue;
+        }
+        const Detection& det = candidates[c];
+        Track track;
+        track.cx.init(det.x + det.width / 2, kInitialVariance, kInitialVelocityVariance);
+        track.cy.init(det.y + det.height / 2, kInitialVariance, kInitialVelocityVariance);
+        track.area.init(det.width * det.height, kInitialVariance, kInitialVelocityVariance);
+        track.aspect.init(det.width / det.height, kInitialVariance, 0.0f);
+        track.last = det;
+        track.hits = 1;
+        if (options.min_hits <= 1) {
+            track.id = next_id++;
+            unique_count++;
+        }
+        active.push_back(track);
+    }
+
+    adaptInterval();
+    publish();
+}
+
+void MultiObjectTracker::adaptInterval() {
+    // Detect often while tracks are being confirmed or reacquired; otherwise
+    // as rarely as the fastest track allows before drifting max_drift widths
+    bool settling = false;
+    bool confirmed = false;
+    float fastest = 0.0f;
+    for (const auto& track : active) {
+        if (track.id < 0 || track.misses > 0) {
+            settling = true;
+            continue;
+        }
+        confirmed = true;
+        float width = std::sqrt(std::max(track.area.value * track.aspect.value, 1.0f));
+        float speed = std::hypot(track.cx.velocity, track.cy.velocity) / width;
+        fastest = std::max(fastest, speed);
+    }
+
+    const int lowest = std::max(1, options.min_interval);
+    const int highest = std::max(lowest, options.max_interval);
+    int next = highest;
+    if (settling) {
+        next = lowest;
+    } else if (confirmed && fastest > 0.0f) {
+        next = (int)std::min<float>((float)highest, options.max_drift / fastest);
+    }
+    interval = std::max(lowest, std::min(highest, next));
+}
+
+void MultiObjectTracker::publish() {
+    output.clear();
+    for (const auto& track : active) {
+        if (track.id >= 0) {
+            output.push_back(predictedBox(track));
+        }
+    }
+}
@@ -0,0 +1,159 @@
+#include "video_overlay.h"
+#include "timestamp.h"
+#include <chrono>
+
+namespace {
+
+constexpr int kTextPadding = 2;       // plate around each text bitmap
+constexpr int kHudMargin = 6;
+constexpr size_t kMaxCachedTexts = 128;
+
+const wxColour kGreen(0, 255, 0);
+const wxColour kYellow(255, 255, 0);
+const wxColour kPlate(0, 0, 0);
+
+bool sameDetections(const std::vector<Detection>& a, const std::vector<Detection>& b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (a[i].x != b[i].x || a[i].y != b[i].y || a[i].width != b[i].width ||
+            a[i].height != b[i].height || a[i].confidence != b[i].confidence ||
+            a[i].track_id != b[i].track_id) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+VideoOverlay::VideoOverlay()
+    : m_frame_number(-1), m_person_count(-1), m_fps(-1), m_hud_dirty(true), m_hud_second(0),
+      m_title_font(10, wxFONTFAMILY_DEFAULT, wxFONTSTYLE_NORMAL, wxFONTWEIGHT_BOLD),
+      m_font(9, wxFONTFAMILY_DEFAULT, wxFONTSTYLE_NORMAL, wxFONTWEIGHT_NORMAL),
+      m_measure_bitmap(1, 1), m_draw_count(0) {
+}
+
+void VideoOverlay::Update(const std::vector<Detection>& detections, int frame_number,
+                          int person_count, float fps, const std::string& hud) {
+    // Same threshold the burned-in overlay used
+    std::vector<Detection> shown;
+    shown.reserve(detections.size());
+    for (const auto& det : detections) {
+        if (det.confidence > 0.5f) {
+            shown.push_back(det);
+        }
+    }
+    if (!sameDetections(shown, m_detections)) {
+        m_detections.swap(shown);
+        m_labels.clear();
+        for (const auto& det : m_detections) {
+            std::string label = det.track_id >= 0 ? "Person " + std::to_string(det.track_id) : "Person";
+            m_labels.push_back(label + ": " + std::to_string((int)(det.confidence * 100)) + "%");
+        }
+    }
+
+    if (frame_number != m_frame_number || person_count != m_person_count ||
+        (int)fps != m_fps || hud != m_hud) {
+        m_frame_number = frame_number;
+        m_person_count = person_count;
+        m_fps = (int)fps;
+        m_hud = hud;
+        m_hud_dirty = true;
+    }
+}
+
+void VideoOverlay::RebuildHud(std::time_t second) {
+    m_hud_dirty = false;
+    m_hud_second = second;
+    m_hud_lines.clear();
+
+    // "YYYY-MM-DD HH:MM:SS"; milliseconds would change the line every paint
+    std::string timestamp = formatTimestamp(std::chrono::system_clock::from_time_t(second));
+    m_hud_lines.push_back({Title, "Camera Feed - " + timestamp.substr(0, 19)});
+    m_hud_lines.push_back({Info, "Frame: " + std::to_string(m_frame_number) +
+                                 " | Persons: " + std::to_string(m_person_count)});
+    m_hud_lines.push_back({Info, "FPS: " + std::to_string(m_fps)});
+
+    size_t begin = 0;
+    while (begin < m_hud.size()) {
+        size_t end = m_hud.find('\n', begin);
+        if (end == std::string::npos) {
+            end = m_hud.size();
+        }
+        m_hud_lines.push_back({Latency, m_hud.substr(begin, end - begin)});
+        begin = end + 1;
+    }
+}
+
+void VideoOverlay::Draw(wxDC& dc, const wxPoint& offset, double scale) {
+    ++m_draw_count;
+
+    std::time_t second = std::time(nullptr);
+    if (m_hud_dirty || second != m_hud_second) {
+        RebuildHud(second);
+    }
+
+    // Boxes follow the frame's scale; text keeps its size
+    dc.SetPen(wxPen(kGreen, 2));
+    dc.SetBrush(*wxTRANSPARENT_BRUSH);
+    for (size_t i = 0; i < m_detections.size(); ++i) {
+        const Detection& det = m_detections[i];
+        int x = offset.x + (int)(det.x * scale);
+        int y = offset.y + (int)(det.y * scale);
+        dc.DrawRectangle(x, y, (int)(det.width * scale), (int)(det.height * scale));
+
+        const wxBitmap& label = RenderText(Label, m_labels[i]);
+        int label_y = y - label.GetHeight();
+        dc.DrawBitmap(label, x, label_y < offset.y ? y : label_y, false);
+    }
+
+    int y = offset.y + kHudMargin;
+    for (const auto& line : m_hud_lines) {
+        const wxBitmap& text = RenderText(line.first, line.second);
+        dc.DrawBitmap(text, offset.x + kHudMargin, y, false);
+        y += text.GetHeight() + 1;
+    }
+
+    EvictUnused();
+}
+
+// Text on a dark plate, rendered on first use and reused while it is shown
+const wxBitmap& VideoOverlay::RenderText(TextStyle style, const std::string& text) {
+    CachedText& cached = m_cache[std::string(1, (char)style) + text];
+    cached.used = m_draw_count;
+    if (cached.bitmap.IsOk()) {
+        return cached.bitmap;
+    }
+
+    const wxFont& font = style == Title ? m_title_font : m_font;
+    wxMemoryDC dc(m_measure_bitmap);
+    dc.SetFont(font);
+    wxSize extent = dc.GetTextExtent(text);
+
+    cached.bitmap = wxBitmap(extent.GetWidth() + 2 * kTextPadding, extent.GetHeight() + 2 * kTextPadding);
+    dc.SelectObject(cached.bitmap);
+    dc.SetBackground(wxBrush(kPlate));
+    dc.Clear();
+    dc.SetFont(font);
+    dc.SetTextForeground(style == Latency ? kYellow : kGreen);
+    dc.DrawText(text, kTextPadding, kTextPadding);
+    dc.SelectObject(wxNullBitmap);
+    return cached.bitmap;
+}
+
+// Frame counters and confidences keep producing new strings; drop the
+// ones the last Draw did not show once the cache grows
+void VideoOverlay::EvictUnused() {
+    if (m_cache.size() <= kMaxCachedTexts) {
+        return;
+    }
+    for (auto it = m_cache.begin(); it != m_cache.end();) {
+        if (it->second.used != m_draw_count) {
+            it = m_cache.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
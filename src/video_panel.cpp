@@ -0,0 +1,115 @@
+#include "video_panel.h"
+#include <wx/dcbuffer.h>
+#include <wx/display.h>
+#include <algorithm>
+
+VideoPanel::VideoPanel(wxWindow* parent, const wxSize& min_size)
+    : wxWindow(parent, wxID_ANY, wxDefaultPosition, min_size, wxBORDER_NONE | wxFULL_REPAINT_ON_RESIZE),
+      m_frame_dirty(false), m_latencies(nullptr), m_scale(1.0), m_refresh_timer(this), m_refresh_pending(false) {
+    // OnPaint covers every pixel; skipping the erase avoids flicker
+    SetBackgroundStyle(wxBG_STYLE_PAINT);
+    SetMinSize(min_size);
+
+    int refresh_hz = 0;
+    int display = wxDisplay::GetFromWindow(parent);
+    if (display != wxNOT_FOUND) {
+        refresh_hz = wxDisplay((unsigned)display).GetCurrentMode().GetRefresh();
+    }
+    m_refresh_interval = std::chrono::microseconds(1000000 / (refresh_hz > 0 ? refresh_hz : 60));
+
+    Bind(wxEVT_PAINT, &VideoPanel::OnPaint, this);
+    Bind(wxEVT_TIMER, &VideoPanel::OnTimer, this);
+}
+
+void VideoPanel::SetFrame(const cv::Mat& frame, std::chrono::steady_clock::time_point capture_time) {
+    // The previous frame goes back to the pool, converted or not
+    m_frame = frame;
+    m_capture_time = capture_time;
+    m_frame_dirty = true;
+    ScheduleRefresh();
+}
+
+// At most one repaint per display refresh: the first frame after a paint
+// waits for the rest of the interval, later ones just replace it
+void VideoPanel::ScheduleRefresh() {
+    if (m_refresh_pending) {
+        return;
+    }
+    m_refresh_pending = true;
+    auto wait = m_last_paint + m_refresh_interval - std::chrono::steady_clock::now();
+    if (wait <= std::chrono::steady_clock::duration::zero()) {
+        Refresh(false);
+    } else {
+        int ms = (int)std::chrono::duration_cast<std::chrono::milliseconds>(wait).count();
+        m_refresh_timer.Start(std::max(1, ms), wxTIMER_ONE_SHOT);
+    }
+}
+
+void VideoPanel::OnTimer(wxTimerEvent& event) {
+    Refresh(false);
+}
+
+void VideoPanel::OnPaint(wxPaintEvent& event) {
+    wxAutoBufferedPaintDC dc(this);
+    StageTimer timer;
+    m_refresh_pending = false;
+    m_last_paint = std::chrono::steady_clock::now();
+
+    bool new_frame = m_frame_dirty;
+    wxSize size = GetClientSize();
+    if (!m_frame.empty() && (m_frame_dirty || size != m_bitmap_window)) {
+        RenderBitmap(size);
+        timer.lap();
+    }
+
+    dc.SetBackground(*wxBLACK_BRUSH);
+    dc.Clear();
+    if (m_bitmap.IsOk()) {
+        dc.DrawBitmap(m_bitmap, m_offset.x, m_offset.y, false);
+    }
+    uint64_t display_us = timer.lap();
+
+    if (m_bitmap.IsOk()) {
+        m_overlay.Draw(dc, m_offset, m_scale);
+    }
+
+    if (m_latencies && new_frame) {
+        m_latencies->record(Stage::Display, display_us);
+        m_latencies->record(Stage::Draw, timer.lap());
+        m_latencies->record(Stage::EndToEnd, std::chrono::steady_clock::now() - m_capture_time);
+    }
+}
+
+void VideoPanel::RenderBitmap(const wxSize& size) {
+    StageTimer timer;
+    m_frame_dirty = false;
+    m_bitmap_window = size;
+
+    // Largest size with the frame's aspect ratio that fits the window
+    double scale = std::min(size.GetWidth() / (double)m_frame.cols,
+                            size.GetHeight() / (double)m_frame.rows);
+    cv::Size target(std::max(1, (int)(m_frame.cols * scale)), std::max(1, (int)(m_frame.rows * scale)));
+    m_scale = target.width / (double)m_frame.cols;
+    m_offset = wxPoint((size.GetWidth() - target.width) / 2, (size.GetHeight() - target.height) / 2);
+
+    const cv::Mat* source = &m_frame;
+    if (target != m_frame.size()) {
+        int interpolation = target.width < m_frame.cols ? cv::INTER_AREA : cv::INTER_LINEAR;
+        cv::resize(m_frame, m_scaled, target, 0, 0, interpolation);
+        source = &m_scaled;
+    }
+
+    // Convert straight into the wxImage's pixels; its buffer is kept while the size holds
+    if (!m_image.IsOk() || m_image.GetWidth() != target.width || m_image.GetHeight() != target.height) {
+        m_image = wxImage(target.width, target.height, false);
+    }
+    cv::Mat rgb(target.height, target.width, CV_8UC3, m_image.GetData());
+    cv::cvtColor(*source, rgb, source->channels() == 1 ? cv::COLOR_GRAY2RGB : cv::COLOR_BGR2RGB);
+    uint64_t convert_us = timer.lap();
+
+    m_bitmap = wxBitmap(m_image);
+    if (m_latencies) {
+        m_latencies->record(Stage::Convert, convert_us);
+        m_latencies->record(Stage::Bitmap, timer.lap());
+    }
+}
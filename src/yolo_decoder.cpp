@@ -0,0 +1,250 @@
+#include "yolo_decoder.h"
+#include "simd.h"
+#include <algorithm>
+
+bool inferYoloLayout(const std::vector<int64_t>& shape, int num_classes,
+                     YoloOutputLayout& layout) {
+    // Accept [C, N], [B, C, N] and [1, 1, C, N] style shapes
+    std::vector<int64_t> dims(shape.begin(), shape.end());
+    while (dims.size() > 3 && dims.front() == 1) {
+        dims.erase(dims.begin());
+    }
+    if (dims.size() == 2) {
+        dims.insert(dims.begin(), 1);
+    }
+    if (dims.size() != 3 || dims[0] <= 0 || dims[1] <= 0 || dims[2] <= 0) {
+        return false;
+    }
+
+    int64_t a = dims[1];
+    int64_t b = dims[2];
+    int64_t channels = 0;
+
+    if (num_classes > 0) {
+        auto is_head = [num_classes](int64_t c) {
+            return c == num_classes + 4 || c == num_classes + 5;
+        };
+        if (is_head(a) && !is_head(b)) {
+            layout.channel_major = true;
+        } else if (is_head(b) && !is_head(a)) {
+            layout.channel_major = false;
+        } else {
+            layout.channel_major = a < b;
+        }
+        channels = layout.channel_major ? a : b;
+        layout.has_objectness = channels == num_classes + 5;
+        if (!is_head(channels)) {
+            return false;
+        }
+    } else {
+        // The detection head is always much narrower than the candidate count
+        layout.channel_major = a < b;
+        channels = layout.channel_major ? a : b;
+        layout.has_objectness = !layout.channel_major;
+    }
+
+    layout.batch = (int)dims[0];
+    layout.num_channels = (int)channels;
+    layout.num_candidates = (int)(layout.channel_major ? b : a);
+    layout.num_classes = layout.num_channels - 4 - (layout.has_objectness ? 1 : 0);
+    return layout.num_classes > 0;
+}
+
+namespace {
+
+inline void emitCandidate(float cx, float cy, float w, float h, float score, int class_id,
+                          const YoloDecodeParams& params, std::vector<YoloCandidate>& out) {
+    float x = (cx - w * 0.5f - params.pad_x) / params.scale_x;
+    float y = (cy - h * 0.5f - params.pad_y) / params.scale_y;
+    float width = w / params.scale_x;
+    float height = h / params.scale_y;
+
+    // Clamp to frame boundaries
+    if (params.frame_width > 0) {
+        float x1 = std::min(std::max(x, 0.0f), (float)params.frame_width);
+        float x2 = std::min(std::max(x + width, 0.0f), (float)params.frame_width);
+        x = x1;
+        width = x2 - x1;
+    }
+    if (params.frame_height > 0) {
+        float y1 = std::min(std::max(y, 0.0f), (float)params.frame_height);
+        float y2 = std::min(std::max(y + height, 0.0f), (float)params.frame_height);
+        y = y1;
+        height = y2 - y1;
+    }
+
+    out.push_back({x, y, width, height, score, class_id});
+}
+
+// YOLOv8 style [C, N]: every channel is a contiguous row, so vectorize
+// across candidates and run the class argmax lane-wise.
+void decodeChannelMajor(const float* data, const YoloOutputLayout& layout,
+                        const YoloDecodeParams& params, std::vector<YoloCandidate>& out) {
+    const int n = layout.num_candidates;
+    const float* cx = data;
+    const float* cy = data + n;
+    const float* bw = data + 2 * (size_t)n;
+    const float* bh = data + 3 * (size_t)n;
+    const float* obj = layout.has_objectness ? data + 4 * (size_t)n : nullptr;
+    const float* cls = data + (size_t)(layout.has_objectness ? 5 : 4) * n;
+    const int num_classes = params.person_only ? 1 : layout.num_classes;
+    const float threshold = params.confidence_threshold;
+
+    const simd::VecF thr = simd::set1(threshold);
+    float best_scores[simd::kWidth];
+    float best_classes[simd::kWidth];
+
+    int i = 0;
+    for (; i + simd::kWidth <= n; i += simd::kWidth) {
+        simd::VecF objectness = simd::set1(1.0f);
+        if (obj) {
+            // score = obj * cls <= obj, so rejected objectness skips the argmax
+            objectness = simd::load(obj + i);
+            if (simd::movemask(simd::gt(objectness, thr)) == 0) {
+                continue;
+            }
+        }
+
+        simd::VecF best = simd::load(cls + i);
+        simd::VecF best_class = simd::set1(0.0f);
+        for (int c = 1; c < num_classes; ++c) {
+            simd::VecF score = simd::load(cls + (size_t)c * n + i);
+            simd::VecF better = simd::gt(score, best);
+            best = simd::max(best, score);
+            best_class = simd::select(better, simd::set1((float)c), best_class);
+        }
+        if (obj) {
+            best = simd::mul(best, objectness);
+        }
+
+        int mask = simd::movemask(simd::gt(best, thr));
+        if (mask == 0) {
+            continue;
+        }
+
+        simd::store(best_scores, best);
+        simd::store(best_classes, best_class);
+        for (int lane = 0; lane < simd::kWidth; ++lane) {
+            if (mask & (1 << lane)) {
+                int k = i + lane;
+                emitCandidate(cx[k], cy[k], bw[k], bh[k], best_scores[lane],
+                              (int)best_classes[lane], params, out);
+            }
+        }
+    }
+
+    // Scalar tail
+    for (; i < n; ++i) {
+        float objectness = obj ? obj[i] : 1.0f;
+        if (objectness <= threshold) {
+            continue;
+        }
+        float best = cls[i];
+        int best_class = 0;
+        for (int c = 1; c < num_classes; ++c) {
+            float score = cls[(size_t)c * n + i];
+            if (score > best) {
+                best = score;
+                best_class = c;
+            }
+        }
+        best *= objectness;
+        if (best > threshold) {
+            emitCandidate(cx[i], cy[i], bw[i], bh[i], best, best_class, params, out);
+        }
+    }
+}
+
+// Lane-wise argmax over one contiguous row of class scores
+inline int argmaxRow(const float* scores, int count, float& best_score) {
+    static const float kLaneIndex[8] = {0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f};
+
+    int j = 0;
+    int best_class = 0;
+    best_score = scores[0];
+
+    if (count >= simd::kWidth) {
+        simd::VecF best = simd::load(scores);
+        simd::VecF best_index = simd::load(kLaneIndex);
+        for (j = simd::kWidth; j + simd::kWidth <= count; j += simd::kWidth) {
+            simd::VecF score = simd::load(scores + j);
+            simd::VecF better = simd::gt(score, best);
+            best = simd::max(best, score);
+            best_index = simd::select(better,
+                                      simd::add(simd::load(kLaneIndex), simd::set1((float)j)),
+                                      best_index);
+        }
+
+        float lane_scores[simd::kWidth];
+        float lane_index[simd::kWidth];
+        simd::store(lane_scores, best);
+        simd::store(lane_index, best_index);
+        best_score = lane_scores[0];
+        best_class = (int)lane_index[0];
+        for (int lane = 1; lane < simd::kWidth; ++lane) {
+            int index = (int)lane_index[lane];
+            // Ties resolve to the lowest class index, like the scalar loop
+            if (lane_scores[lane] > best_score ||
+                (lane_scores[lane] == best_score && index < best_class)) {
+                best_score = lane_scores[lane];
+                best_class = index;
+            }
+        }
+    }
+
+    for (; j < count; ++j) {
+        if (scores[j] > best_score) {
+            best_score = scores[j];
+            best_class = j;
+        }
+    }
+    return best_class;
+}
+
+// YOLOv5 style [N, C]: one contiguous row per candidate
+void decodeRowMajor(const float* data, const YoloOutputLayout& layout,
+                    const YoloDecodeParams& params, std::vector<YoloCandidate>& out) {
+    const int stride = layout.num_channels;
+    const int class_offset = layout.has_objectness ? 5 : 4;
+    const float threshold = params.confidence_threshold;
+
+    for (int i = 0; i < layout.num_candidates; ++i) {
+        const float* row = data + (size_t)i * stride;
+
+        float objectness = layout.has_objectness ? row[4] : 1.0f;
+        if (objectness <= threshold) {
+            continue;
+        }
+
+        float score = 0.0f;
+        int class_id = 0;
+        if (params.person_only) {
+            score = row[class_offset];
+        } else {
+            class_id = argmaxRow(row + class_offset, layout.num_classes, score);
+        }
+        score *= objectness;
+
+        if (score > threshold) {
+            emitCandidate(row[0], row[1], row[2], row[3], score, class_id, params, out);
+        }
+    }
+}
+
+} // namespace
+
+void decodeYoloOutput(const float* data, const YoloOutputLayout& layout,
+                      const YoloDecodeParams& params, std::vector<YoloCandidate>& out,
+                      int batch_index) {
+    if (!data || layout.num_candidates <= 0 || layout.num_classes <= 0 ||
+        batch_index < 0 || batch_index >= layout.batch) {
+        return;
+    }
+
+    const float* item = data + (size_t)batch_index * layout.num_candidates * layout.num_channels;
+    if (layout.channel_major) {
+        decodeChannelMajor(item, layout, params, out);
+    } else {
+        decodeRowMajor(item, layout, params, out);
+    }
+}
@@ -1,27 +1,171 @@
 #include "yolo_detector.h"
+#include "latency_histogram.h"
+#include "yolo_decoder.h"
 #include <iostream>
 #include <fstream>
 #include <sstream>
 #include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
 
-YOLODetector::YOLODetector(const std::string& model_path)
-    : initialized(false), input_width(640), input_height(640),
-      confidence_threshold(0.45f), nms_threshold(0.45f) {
+namespace fs = std::filesystem;
+
+namespace {
+
+// ORT_ENABLE_ALL adds layout transforms and kernels picked for the CPU's
+// instruction set, so an optimized graph only fits CPUs like this one:
+// vendor, model and ISA flags of the first CPU in /proc/cpuinfo
+std::string cpuSignature() {
+    std::string signature;
+#ifdef __linux__
+    std::ifstream cpuinfo("/proc/cpuinfo");
+    std::string line;
+    while (std::getline(cpuinfo, line) && !line.empty()) {
+        size_t colon = line.find(':');
+        if (colon == std::string::npos) {
+            continue;
+        }
+        std::string key = line.substr(0, colon);
+        key.erase(key.find_last_not_of(" \t") + 1);
+        if (key == "vendor_id" || key == "model name" || key == "flags" ||
+            key == "CPU implementer" || key == "CPU part" || key == "Features") {
+            signature += line.substr(colon + 1) + "|";
+        }
+    }
+#endif
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    if (signature.empty()) {
+        __builtin_cpu_init();
+        signature += __builtin_cpu_supports("avx") ? "avx|" : "";
+        signature += __builtin_cpu_supports("avx2") ? "avx2|" : "";
+        signature += __builtin_cpu_supports("fma") ? "fma|" : "";
+        signature += __builtin_cpu_supports("avx512f") ? "avx512f|" : "";
+    }
+#endif
+    return signature;
+}
+
+// 64-bit FNV-1a; unlike std::hash the same on every build, so cache names stay put
+uint64_t fnv1a(const std::string& text) {
+    uint64_t hash = 14695981039346656037ull;
+    for (unsigned char c : text) {
+        hash = (hash ^ c) * 1099511628211ull;
+    }
+    return hash;
+}
+
+// "model_cache/yolov8s-1a2b3c4d5e6f7a8b.ort". The key covers everything
+// that invalidates an optimized graph: the model file itself (path, size,
+// modification time), the runtime that optimized it and the CPU it was
+// optimized for, so a cache directory shared between hosts stays correct.
+std::string optimizedModelPath(const std::string& model_path, const std::string& cache_dir) {
+    std::error_code ec;
+    fs::path model = fs::absolute(model_path, ec);
+    uintmax_t size = fs::file_size(model, ec);
+    auto modified = fs::last_write_time(model, ec).time_since_epoch().count();
+    std::string key = model.string() + "|" + std::to_string(size) + "|" +
+                      std::to_string((long long)modified) + "|ort" + std::to_string(ORT_API_VERSION) +
+                      "|" + cpuSignature();
+    char hash[24];
+    std::snprintf(hash, sizeof(hash), "%016llx", (unsigned long long)fnv1a(key));
+    return (fs::path(cache_dir) / (model.stem().string() + "-" + hash + ".ort")).string();
+}
+
+const char* elementTypeName(ONNXTensorElementDataType type) {
+    switch (type) {
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT: return "float32";
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT16: return "float16";
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT8: return "uint8";
+        default: return "unsupported";
+    }
+}
+
+size_t elementSize(ONNXTensorElementDataType type) {
+    switch (type) {
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT16: return 2;
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT8: return 1;
+        default: return 4;
+    }
+}
+
+// float32 <-> the model's element type, count values; uint8 inputs take
+// raw 0-255 pixels, i.e. the [0, 1] preprocessing output times 255
+void convertElements(const void* src, int src_depth, void* dst, int dst_depth, size_t count,
+                     double scale = 1.0) {
+    cv::Mat from(1, (int)count, src_depth, const_cast<void*>(src));
+    cv::Mat to(1, (int)count, dst_depth, dst);
+    from.convertTo(to, dst_depth, scale);
+}
+
+int elementDepth(ONNXTensorElementDataType type) {
+    return type == ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT16 ? CV_16F :
+           type == ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT8 ? CV_8U : CV_32F;
+}
+
+// One environment per process. With threads.intra_threads set it owns the
+// global pools every session runs on; the first detector decides.
+Ort::Env& sharedEnvironment(const OrtThreading& threads, bool& global_pools) {
+    static std::once_flag once;
+    static std::unique_ptr<Ort::Env> env;
+    static bool has_global_pools = false;
+    std::call_once(once, [&]() {
+        if (threads.intra_threads <= 0) {
+            env = std::make_unique<Ort::Env>(ORT_LOGGING_LEVEL_WARNING, "YOLODetector");
+            return;
+        }
+        Ort::ThreadingOptions pools;
+        pools.SetGlobalIntraOpNumThreads(threads.intra_threads);
+        pools.SetGlobalInterOpNumThreads(std::max(1, threads.inter_threads));
+        pools.SetGlobalSpinControl(threads.spinning ? 1 : 0);
+#if ORT_API_VERSION >= 14
+        if (!threads.intra_cpus.empty()) {
+            // One entry per pool thread after the calling one; ORT numbers CPUs from 1
+            std::string affinity;
+            for (int t = 1; t < threads.intra_threads; ++t) {
+                int cpu = threads.intra_cpus[t % threads.intra_cpus.size()];
+                affinity += (affinity.empty() ? "" : ";") + std::to_string(cpu + 1);
+            }
+            if (!affinity.empty()) {
+                Ort::ThrowOnError(Ort::GetApi().SetGlobalIntraOpThreadAffinity(pools, affinity.c_str()));
+            }
+        }
+#endif
+        env = std::make_unique<Ort::Env>(pools, ORT_LOGGING_LEVEL_WARNING, "YOLODetector");
+        has_global_pools = true;
+    });
+    global_pools = has_global_pools;
+    return *env;
+}
+
+} // namespace
+
+YOLODetector::YOLODetector(const std::string& model_path, const DetectorConfig& config)
+    : env(nullptr), global_pools(false), initialized(false), input_width(640), input_height(640),
+      confidence_threshold(config.confidence_threshold), person_only(config.person_only),
+      input_type(ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT), output_type(ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT),
+      memory_info(Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeDefault)),
+      max_batch(std::max(1, config.max_batch)), letterbox(config.letterbox) {
+    NmsOptions nms = config.nms;
+    nms.score_threshold = config.confidence_threshold;
+    suppressor = NonMaxSuppressor(nms);
     
     try {
-        // Create ONNX Runtime environment
-        env = std::make_unique<Ort::Env>(ORT_LOGGING_LEVEL_WARNING, "YOLODetector");
+        env = &sharedEnvironment(config.threads, global_pools);
         
-        // Create session options
-        Ort::SessionOptions session_options;
-        session_options.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_ENABLE_ALL);
-        
-        // Create session
-        session = std::make_unique<Ort::Session>(*env, model_path.c_str(), session_options);
-        
-        std::cout << "YOLO ONNX model loaded successfully!" << std::endl;
+        auto start = std::chrono::steady_clock::now();
+        createSession(model_path, config);
+        std::cout << "YOLO ONNX model loaded in "
+                  << std::chrono::duration_cast<std::chrono::milliseconds>(
+                         std::chrono::steady_clock::now() - start).count()
+                  << " ms" << std::endl;
         
         loadClassNames();
+        bindTensors();
         initialized = true;
         
     } catch (const Ort::Exception& e) {
@@ -34,8 +178,156 @@ YOLODetector::YOLODetector(const std::string& model_path)
 }
 
 YOLODetector::~YOLODetector() {
+    // The bindings refer to the session and the tensors to our buffers
+    bindings.clear();
     session.reset();
-    env.reset();
+}
+
+void YOLODetector::createSession(const std::string& model_path, const DetectorConfig& config) {
+    std::string cached;
+    if (!config.model_cache_dir.empty()) {
+        cached = optimizedModelPath(model_path, config.model_cache_dir);
+        std::error_code ec;
+        if (fs::is_regular_file(cached, ec)) {
+            try {
+                // Already optimized for this machine; loading it skips the graph passes
+                Ort::SessionOptions session_options;
+                session_options.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_DISABLE_ALL);
+                if (global_pools) {
+                    session_options.DisablePerSessionThreads();
+                }
+                session = std::make_unique<Ort::Session>(*env, cached.c_str(), session_options);
+                std::cout << "Using optimized model " << cached << std::endl;
+                return;
+            } catch (const Ort::Exception& e) {
+                std::cerr << "Discarding optimized model " << cached << ": " << e.what() << std::endl;
+                fs::remove(cached, ec);
+            }
+        }
+    }
+    
+    Ort::SessionOptions session_options;
+    session_options.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_ENABLE_ALL);
+    if (global_pools) {
+        session_options.DisablePerSessionThreads();
+    }
+    
+    // Saved under a per-thread name and renamed into place, so detectors
+    // created in parallel and crashes never leave a half-written cache entry
+    std::string temp;
+    if (!cached.empty()) {
+        std::error_code ec;
+        fs::create_directories(config.model_cache_dir, ec);
+        if (!ec) {
+            temp = cached + "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+            session_options.SetOptimizedModelFilePath(temp.c_str());
+            session_options.AddConfigEntry("session.save_model_format", "ORT");
+        }
+    }
+    
+    session = std::make_unique<Ort::Session>(*env, model_path.c_str(), session_options);
+    
+    if (!temp.empty()) {
+        std::error_code ec;
+        fs::rename(temp, cached, ec);
+        if (ec) {
+            std::cerr << "Failed to cache optimized model " << cached << ": " << ec.message() << std::endl;
+            fs::remove(temp, ec);
+        } else {
+            std::cout << "Saved optimized model " << cached << std::endl;
+        }
+    }
+}
+
+void YOLODetector::bindTensors() {
+    Ort::AllocatorWithDefaultOptions allocator;
+    input_name = session->GetInputNameAllocated(0, allocator).get();
+    output_name = session->GetOutputNameAllocated(0, allocator).get();
+    
+    // A static model input size wins over the 640x640 default
+    Ort::TypeInfo input_info = session->GetInputTypeInfo(0);
+    std::vector<int64_t> input_dims = input_info.GetTensorTypeAndShapeInfo().GetShape();
+    input_type = input_info.GetTensorTypeAndShapeInfo().GetElementType();
+    if (input_type != ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT &&
+        input_type != ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT16 &&
+        input_type != ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT8) {
+        throw std::runtime_error("unsupported model input type " + std::to_string((int)input_type));
+    }
+    if (input_dims.size() == 4) {
+        if (input_dims[2] > 0) input_height = (int)input_dims[2];
+        if (input_dims[3] > 0) input_width = (int)input_dims[3];
+    }
+    // Only a dynamic batch dimension takes more than one frame per Run()
+    if (input_dims.empty() || input_dims[0] > 0) {
+        max_batch = 1;
+    }
+    
+    const size_t input_item_size = (size_t)3 * input_width * input_height;
+    input_buffer.assign(max_batch * input_item_size, 0.0f);
+    if (input_type != ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT) {
+        input_storage.assign(max_batch * input_item_size * elementSize(input_type), 0);
+    }
+    geometries.resize(max_batch);
+    preprocessor = std::make_unique<LetterboxPreprocessor>(input_width, input_height, letterbox);
+    
+    Ort::TypeInfo output_info = session->GetOutputTypeInfo(0);
+    output_shape = output_info.GetTensorTypeAndShapeInfo().GetShape();
+    output_type = output_info.GetTensorTypeAndShapeInfo().GetElementType();
+    if (output_type != ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT &&
+        output_type != ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT16) {
+        throw std::runtime_error("unsupported model output type " + std::to_string((int)output_type));
+    }
+    size_t output_item_size = output_shape.empty() ? 0 : 1;
+    for (size_t d = 1; d < output_shape.size(); ++d) {
+        output_item_size = output_shape[d] > 0 ? output_item_size * output_shape[d] : 0;
+    }
+    if (output_item_size > 0) {
+        output_buffer.assign(max_batch * output_item_size, 0.0f);
+        if (output_type != ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT) {
+            output_storage.assign(max_batch * output_item_size * elementSize(output_type), 0);
+        }
+    }
+    
+    bindings.resize(max_batch);
+    for (int n = 1; n <= max_batch; ++n) {
+        BatchBinding& batch = bindings[n - 1];
+        std::vector<int64_t> input_shape = {n, 3, input_height, input_width};
+        if (input_type == ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT) {
+            batch.input_tensor = Ort::Value::CreateTensor<float>(
+                memory_info, input_buffer.data(), n * input_item_size,
+                input_shape.data(), input_shape.size());
+        } else {
+            batch.input_tensor = Ort::Value::CreateTensor(
+                memory_info, input_storage.data(), n * input_item_size * elementSize(input_type),
+                input_shape.data(), input_shape.size(), input_type);
+        }
+        batch.binding = std::make_unique<Ort::IoBinding>(*session);
+        batch.binding->BindInput(input_name.c_str(), batch.input_tensor);
+        
+        if (output_item_size > 0) {
+            std::vector<int64_t> shape = output_shape;
+            shape[0] = n;
+            if (output_type == ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT) {
+                batch.output_tensor = Ort::Value::CreateTensor<float>(
+                    memory_info, output_buffer.data(), n * output_item_size,
+                    shape.data(), shape.size());
+            } else {
+                batch.output_tensor = Ort::Value::CreateTensor(
+                    memory_info, output_storage.data(), n * output_item_size * elementSize(output_type),
+                    shape.data(), shape.size(), output_type);
+            }
+            batch.binding->BindOutput(output_name.c_str(), batch.output_tensor);
+        } else {
+            // Dynamic head size: ORT allocates the output, still decoded in place
+            batch.binding->BindOutput(output_name.c_str(), memory_info);
+        }
+    }
+    
+    std::cout << "YOLO input " << input_width << "x" << input_height << " "
+              << elementTypeName(input_type) << (letterbox ? " (letterbox)" : " (stretch)")
+              << ", output " << elementTypeName(output_type) << " "
+              << (output_buffer.empty() ? "dynamic" : "preallocated")
+              << ", max batch " << max_batch << std::endl;
 }
 
 void YOLODetector::loadClassNames() {
@@ -67,133 +359,132 @@ std::vector<Detection> YOLODetector::detect(const cv::Mat& frame) {
         return detections;
     }
     
+    timings = DetectTimings();
+    runBatch(&frame, 1, &detections);
+    return detections;
+}
+
+void YOLODetector::detectBatch(const std::vector<cv::Mat>& frames,
+                               std::vector<std::vector<Detection>>& results) {
+    results.resize(frames.size());
+    timings = DetectTimings();
+    if (!initialized) {
+        return;
+    }
+    
+    for (size_t start = 0; start < frames.size();) {
+        int count = (int)std::min(frames.size() - start, (size_t)max_batch);
+        runBatch(&frames[start], count, &results[start]);
+        start += count;
+    }
+}
+
+bool YOLODetector::runBatch(const cv::Mat* frames, int count, std::vector<Detection>* results) {
+    for (int b = 0; b < count; ++b) {
+        results[b].clear();
+    }
+    
     try {
-        // Prepare blob for network
-        cv::Mat blob = cv::dnn::blobFromImage(frame, 1.0 / 255.0, 
-                                               cv::Size(input_width, input_height), 
-                                               cv::Scalar(0, 0, 0), true, false);
+        StageTimer timer;
         
-        // Create input tensor
-        std::vector<int64_t> input_shape = {1, 3, input_height, input_width};
-        std::vector<float> input_data(blob.total());
-        
-        float* p_data = blob.ptr<float>();
-        std::copy(p_data, p_data + blob.total(), input_data.begin());
-        
-        Ort::MemoryInfo memory_info = Ort::MemoryInfo::CreateCpu(
-            OrtAllocatorType::OrtArenaAllocator, OrtMemType::OrtMemTypeDefault);
-        
-        Ort::Value input_tensor = Ort::Value::CreateTensor<float>(
-            memory_info, input_data.data(), input_data.size(),
-            input_shape.data(), input_shape.size());
-        
-        // Standard YOLO ONNX input/output names
-        const char* input_names[] = {"images"};
-        const char* output_names[] = {"output0"};
+        // Preprocess each frame straight into its slice of the bound input tensor
+        const size_t input_item_size = (size_t)3 * input_width * input_height;
+        for (int b = 0; b < count; ++b) {
+            if (!frames[b].empty()) {
+                geometries[b] = preprocessor->run(frames[b], input_buffer.data() + b * input_item_size);
+            }
+        }
+        if (input_type != ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT) {
+            convertElements(input_buffer.data(), CV_32F, input_storage.data(), elementDepth(input_type),
+                            count * input_item_size,
+                            input_type == ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT8 ? 255.0 : 1.0);
+        }
+        timings.preprocess_us += timer.lap();
         
         // Run inference
-        auto output_tensors = session->Run(
-            Ort::RunOptions{nullptr},
-            input_names, &input_tensor, 1,
-            output_names, 1);
+        Ort::IoBinding& binding = *bindings[count - 1].binding;
+        session->Run(Ort::RunOptions{nullptr}, binding);
+        timings.forward_us += timer.lap();
         
-        // Parse output
-        if (output_tensors.size() > 0) {
-            auto& output = output_tensors.at(0);
-            std::vector<int64_t> output_shape = output.GetTensorTypeAndShapeInfo().GetShape();
-            float* output_data = output.GetTensorMutableData<float>();
-            
-            size_t output_size = 1;
-            for (auto dim : output_shape) {
-                output_size *= dim;
+        // Parse output in place
+        const float* output = nullptr;
+        std::vector<Ort::Value> outputs;
+        if (!output_buffer.empty()) {
+            output_shape[0] = count;
+            output = output_buffer.data();
+            if (output_type != ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT) {
+                convertElements(output_storage.data(), elementDepth(output_type), output_buffer.data(),
+                                CV_32F, output_buffer.size() / max_batch * count);
+            }
+        } else {
+            outputs = binding.GetOutputValues();
+            if (outputs.empty()) {
+                return false;
+            }
+            Ort::TensorTypeAndShapeInfo info = outputs[0].GetTensorTypeAndShapeInfo();
+            output_shape = info.GetShape();
+            if (output_type == ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT) {
+                output = outputs[0].GetTensorData<float>();
+            } else {
+                // Widened into a scratch buffer that only grows
+                size_t elements = info.GetElementCount();
+                if (widened_output.size() < elements) {
+                    widened_output.resize(elements);
+                }
+                convertElements(outputs[0].GetTensorData<uint8_t>(), elementDepth(output_type),
+                                widened_output.data(), CV_32F, elements);
+                output = widened_output.data();
+            }
+        }
+        for (int b = 0; b < count; ++b) {
+            if (!frames[b].empty()) {
+                results[b] = parseOutput(output, output_shape, frames[b], geometries[b], b);
             }
-            
-            std::vector<float> output_vec(output_data, output_data + output_size);
-            detections = parseOutput(output_vec, frame, output_shape);
         }
         
     } catch (const Ort::Exception& e) {
         std::cerr << "Error during detection: " << e.what() << std::endl;
+        return false;
     } catch (const std::exception& e) {
         std::cerr << "Error during detection: " << e.what() << std::endl;
+        return false;
     }
     
-    return detections;
+    return true;
 }
 
-std::vector<Detection> YOLODetector::parseOutput(const std::vector<float>& output, 
+std::vector<Detection> YOLODetector::parseOutput(const float* output,
+                                                 const std::vector<int64_t>& output_shape,
                                                  const cv::Mat& frame,
-                                                 const std::vector<int64_t>& output_shape) {
+                                                 const LetterboxInfo& geometry,
+                                                 int batch_index) {
     std::vector<Detection> detections;
-    std::vector<cv::Rect> boxes;
-    std::vector<float> confidences;
-    std::vector<int> class_ids;
     
-    float x_factor = frame.cols / (float)input_width;
-    float y_factor = frame.rows / (float)input_height;
-    
-    // YOLOv8 output format: (1, 84, 8400) or (1, 8400, 84)
-    // 84 = 4 (bbox) + 1 (objectness) + 79 (classes) for COCO
-    
-    int num_detections = output.size() / 84; // or output_shape[2] if (1, 84, 8400)
-    
-    for (int i = 0; i < num_detections; ++i) {
-        float objectness = output[i * 84 + 4];
-        
-        if (objectness >= confidence_threshold) {
-            float* class_scores = (float*)&output[i * 84 + 5];
-            
-            // Find max class score
-            float max_score = 0.0f;
-            int max_class = 0;
-            
-            for (int j = 0; j < 80; j++) { // COCO has 80 classes
-                if (class_scores[j] > max_score) {
-                    max_score = class_scores[j];
-                    max_class = j;
-                }
-            }
-            
-            float confidence = objectness * max_score;
-            
-            if (confidence >= confidence_threshold) {
-                // Only keep person detections (class 0)
-                if (max_class == 0) {
-                    float x = output[i * 84 + 0] * x_factor;
-                    float y = output[i * 84 + 1] * y_factor;
-                    float w = output[i * 84 + 2] * x_factor;
-                    float h = output[i * 84 + 3] * y_factor;
-                    
-                    cv::Rect box(x - w/2, y - h/2, w, h);
-                    
-                    // Clamp to frame boundaries
-                    box.x = std::max(0, box.x);
-                    box.y = std::max(0, box.y);
-                    box.width = std::min(box.width, frame.cols - box.x);
-                    box.height = std::min(box.height, frame.rows - box.y);
-                    
-                    boxes.push_back(box);
-                    confidences.push_back(confidence);
-                    class_ids.push_back(max_class);
-                }
-            }
-        }
+    // YOLOv8 emits (B, 84, 8400) without objectness, YOLOv5 (B, N, 85) with it
+    YoloOutputLayout layout;
+    if (!inferYoloLayout(output_shape, (int)class_names.size(), layout)) {
+        std::cerr << "Unsupported YOLO output shape" << std::endl;
+        return detections;
     }
     
-    // Apply NMS
-    std::vector<int> nms_result;
-    cv::dnn::NMSBoxes(boxes, confidences, confidence_threshold, nms_threshold, nms_result);
+    YoloDecodeParams params;
+    params.confidence_threshold = confidence_threshold;
+    params.person_only = person_only;  // Only keep person detections (class 0)
+    params.scale_x = geometry.scale_x;
+    params.scale_y = geometry.scale_y;
+    params.pad_x = geometry.pad_x;
+    params.pad_y = geometry.pad_y;
+    params.frame_width = frame.cols;
+    params.frame_height = frame.rows;
     
-    for (int i : nms_result) {
-        Detection det;
-        det.x = boxes[i].x;
-        det.y = boxes[i].y;
-        det.w = boxes[i].width;
-        det.h = boxes[i].height;
-        det.confidence = confidences[i];
-        det.class_id = class_ids[i];
-        detections.push_back(det);
-    }
+    StageTimer timer;
+    candidates.clear();
+    decodeYoloOutput(output, layout, params, candidates, batch_index);
+    timings.decode_us += timer.lap();
+    
+    // Float boxes straight into the SIMD NMS, no cv::Rect rounding
+    suppressor.suppress(candidates, detections);
+    timings.nms_us += timer.lap();
     
     return detections;
 }
@@ -204,7 +495,7 @@ cv::Mat YOLODetector::drawDetections(const cv::Mat& frame, const std::vector<Det
     for (const auto& det : detections) {
         // Draw bounding box
         cv::rectangle(result, 
-                     cv::Rect(det.x, det.y, det.w, det.h), 
+                     cv::Rect(det.x, det.y, det.width, det.height), 
                      cv::Scalar(0, 255, 0), 2);
         
         // Draw label with confidence
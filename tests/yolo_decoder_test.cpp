@@ -0,0 +1,321 @@
+// Golden-output tests of the YOLO output decoder on synthetic tensors: the
+// SIMD kernels are compared candidate by candidate against a plain scalar
+// reference, over both head layouts, candidate counts that leave a SIMD
+// tail, scores exactly at the threshold, and letterbox unmapping/clamping.
+#include "yolo_decoder.h"
+#include "simd.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+int g_failures = 0;
+
+#define CHECK(condition)                                                             \
+    do {                                                                             \
+        if (!(condition)) {                                                          \
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+            g_failures++;                                                            \
+        }                                                                            \
+    } while (0)
+
+// One synthetic candidate, independent of the tensor layout
+struct Synthetic {
+    float cx, cy, w, h;
+    float objectness;
+    std::vector<float> classes;
+};
+
+// Straightforward per-candidate decode, the behaviour the kernels must match
+std::vector<YoloCandidate> referenceDecode(const std::vector<Synthetic>& candidates, bool has_objectness,
+                                           const YoloDecodeParams& params) {
+    std::vector<YoloCandidate> out;
+    for (const auto& c : candidates) {
+        float objectness = has_objectness ? c.objectness : 1.0f;
+        if (objectness <= params.confidence_threshold) {
+            continue;
+        }
+        int count = params.person_only ? 1 : (int)c.classes.size();
+        int best_class = 0;
+        for (int k = 1; k < count; ++k) {
+            if (c.classes[k] > c.classes[best_class]) {
+                best_class = k;
+            }
+        }
+        float score = c.classes[best_class] * objectness;
+        if (!(score > params.confidence_threshold)) {
+            continue;
+        }
+
+        float x = (c.cx - c.w * 0.5f - params.pad_x) / params.scale_x;
+        float y = (c.cy - c.h * 0.5f - params.pad_y) / params.scale_y;
+        float x2 = x + c.w / params.scale_x;
+        float y2 = y + c.h / params.scale_y;
+        if (params.frame_width > 0) {
+            x = std::min(std::max(x, 0.0f), (float)params.frame_width);
+            x2 = std::min(std::max(x2, 0.0f), (float)params.frame_width);
+        }
+        if (params.frame_height > 0) {
+            y = std::min(std::max(y, 0.0f), (float)params.frame_height);
+            y2 = std::min(std::max(y2, 0.0f), (float)params.frame_height);
+        }
+        out.push_back({x, y, x2 - x, y2 - y, score, best_class});
+    }
+    return out;
+}
+
+// Random candidates with a few planted at and around the threshold, ties
+// between classes and boxes reaching outside the frame
+std::vector<Synthetic> makeCandidates(int n, int num_classes, float threshold, std::mt19937& rng) {
+    std::uniform_real_distribution<float> low(0.0f, threshold * 0.9f);
+    std::uniform_real_distribution<float> any(0.0f, 1.0f);
+    std::uniform_real_distribution<float> position(-60.0f, 700.0f);
+    std::uniform_real_distribution<float> size(4.0f, 300.0f);
+    const float above = std::nextafter(threshold, 1.0f);
+
+    std::vector<Synthetic> candidates(n);
+    for (int i = 0; i < n; ++i) {
+        Synthetic& c = candidates[i];
+        c.cx = position(rng);
+        c.cy = position(rng);
+        c.w = size(rng);
+        c.h = size(rng);
+        c.objectness = 1.0f;
+        c.classes.assign(num_classes, 0.0f);
+        for (float& score : c.classes) {
+            score = low(rng);
+        }
+        int hot = (int)(rng() % num_classes);
+        switch (i % 7) {
+            case 0:  // exactly at the threshold: rejected
+                c.classes[hot] = threshold;
+                break;
+            case 1:  // the next float up: kept
+                c.classes[hot] = above;
+                break;
+            case 2:  // objectness exactly at the threshold: rejected
+                c.objectness = threshold;
+                c.classes[hot] = 1.0f;
+                break;
+            case 3:  // tie between two classes: the lower index wins
+                c.classes[hot] = 0.9f;
+                c.classes[(hot + 1) % num_classes] = 0.9f;
+                break;
+            case 4:  // objectness scales a high class score down
+                c.objectness = any(rng);
+                c.classes[hot] = 0.95f;
+                break;
+            case 5:  // the person class only
+                c.classes[0] = 0.8f;
+                break;
+            default:  // background
+                break;
+        }
+    }
+    return candidates;
+}
+
+// v8 head: [C, N], one row per channel
+std::vector<float> packChannelMajor(const std::vector<Synthetic>& candidates, bool has_objectness) {
+    const size_t n = candidates.size();
+    const size_t classes = candidates.empty() ? 0 : candidates[0].classes.size();
+    const size_t offset = has_objectness ? 5 : 4;
+    std::vector<float> tensor((offset + classes) * n);
+    for (size_t i = 0; i < n; ++i) {
+        const Synthetic& c = candidates[i];
+        tensor[0 * n + i] = c.cx;
+        tensor[1 * n + i] = c.cy;
+        tensor[2 * n + i] = c.w;
+        tensor[3 * n + i] = c.h;
+        if (has_objectness) {
+            tensor[4 * n + i] = c.objectness;
+        }
+        for (size_t k = 0; k < classes; ++k) {
+            tensor[(offset + k) * n + i] = c.classes[k];
+        }
+    }
+    return tensor;
+}
+
+// v5 head: [N, C], one row per candidate
+std::vector<float> packRowMajor(const std::vector<Synthetic>& candidates, bool has_objectness) {
+    std::vector<float> tensor;
+    for (const auto& c : candidates) {
+        tensor.insert(tensor.end(), {c.cx, c.cy, c.w, c.h});
+        if (has_objectness) {
+            tensor.push_back(c.objectness);
+        }
+        tensor.insert(tensor.end(), c.classes.begin(), c.classes.end());
+    }
+    return tensor;
+}
+
+bool sameCandidates(const std::vector<YoloCandidate>& actual, const std::vector<YoloCandidate>& expected) {
+    if (actual.size() != expected.size()) {
+        std::fprintf(stderr, "  %zu candidates, expected %zu\n", actual.size(), expected.size());
+        return false;
+    }
+    auto near = [](float a, float b) { return std::fabs(a - b) <= 1e-4f * std::max(1.0f, std::fabs(b)); };
+    for (size_t i = 0; i < actual.size(); ++i) {
+        const YoloCandidate& a = actual[i];
+        const YoloCandidate& e = expected[i];
+        if (a.class_id != e.class_id || a.confidence != e.confidence || !near(a.x, e.x) ||
+            !near(a.y, e.y) || !near(a.width, e.width) || !near(a.height, e.height)) {
+            std::fprintf(stderr, "  candidate %zu: class %d conf %.9g box %g,%g %gx%g; expected class %d conf %.9g box %g,%g %gx%g\n",
+                         i, a.class_id, a.confidence, a.x, a.y, a.width, a.height, e.class_id, e.confidence,
+                         e.x, e.y, e.width, e.height);
+            return false;
+        }
+    }
+    return true;
+}
+
+void testLayoutInference() {
+    YoloOutputLayout layout;
+
+    CHECK(inferYoloLayout({1, 84, 8400}, 80, layout));
+    CHECK(layout.channel_major && !layout.has_objectness);
+    CHECK(layout.num_candidates == 8400 && layout.num_channels == 84 && layout.num_classes == 80);
+
+    layout = YoloOutputLayout();
+    CHECK(inferYoloLayout({1, 84, 8400}, -1, layout));
+    CHECK(layout.channel_major && !layout.has_objectness && layout.num_classes == 80);
+
+    layout = YoloOutputLayout();
+    CHECK(inferYoloLayout({1, 25200, 85}, 80, layout));
+    CHECK(!layout.channel_major && layout.has_objectness);
+    CHECK(layout.num_candidates == 25200 && layout.num_channels == 85 && layout.num_classes == 80);
+
+    layout = YoloOutputLayout();
+    CHECK(inferYoloLayout({1, 25200, 85}, 0, layout));
+    CHECK(!layout.channel_major && layout.has_objectness && layout.num_classes == 80);
+
+    // Fewer candidates than channels still resolve with a known class count
+    layout = YoloOutputLayout();
+    CHECK(inferYoloLayout({1, 84, 7}, 80, layout));
+    CHECK(layout.channel_major && layout.num_candidates == 7);
+    layout = YoloOutputLayout();
+    CHECK(inferYoloLayout({1, 9, 85}, 80, layout));
+    CHECK(!layout.channel_major && layout.has_objectness && layout.num_candidates == 9);
+
+    // Squeezed and padded shapes, batches
+    layout = YoloOutputLayout();
+    CHECK(inferYoloLayout({84, 8400}, 80, layout));
+    CHECK(layout.batch == 1 && layout.channel_major);
+    layout = YoloOutputLayout();
+    CHECK(inferYoloLayout({1, 1, 84, 8400}, 80, layout));
+    CHECK(layout.batch == 1 && layout.num_candidates == 8400);
+    layout = YoloOutputLayout();
+    CHECK(inferYoloLayout({4, 84, 8400}, 80, layout));
+    CHECK(layout.batch == 4);
+
+    // Not a detection head
+    CHECK(!inferYoloLayout({1, 90, 8400}, 80, layout));
+    CHECK(!inferYoloLayout({1, 0, 85}, 80, layout));
+    CHECK(!inferYoloLayout({8400}, 80, layout));
+    CHECK(!inferYoloLayout({1, 2, 3, 4}, 80, layout));
+}
+
+void testDecode(bool channel_major, bool has_objectness, int num_classes, int n, bool person_only,
+                const YoloDecodeParams& base, std::mt19937& rng) {
+    YoloDecodeParams params = base;
+    params.person_only = person_only;
+    std::vector<Synthetic> candidates = makeCandidates(n, num_classes, params.confidence_threshold, rng);
+    std::vector<float> tensor = channel_major ? packChannelMajor(candidates, has_objectness)
+                                              : packRowMajor(candidates, has_objectness);
+
+    int channels = num_classes + (has_objectness ? 5 : 4);
+    std::vector<int64_t> shape = channel_major ? std::vector<int64_t>{1, channels, n}
+                                               : std::vector<int64_t>{1, n, channels};
+    YoloOutputLayout layout;
+    CHECK(inferYoloLayout(shape, num_classes, layout));
+    if (n != num_classes + 4 && n != num_classes + 5) {
+        CHECK(layout.channel_major == channel_major && layout.has_objectness == has_objectness);
+    }
+    // A candidate count that is itself a head width makes the shape
+    // ambiguous; decode with the layout under test either way
+    layout.channel_major = channel_major;
+    layout.has_objectness = has_objectness;
+    layout.num_channels = channels;
+    layout.num_candidates = n;
+    layout.num_classes = num_classes;
+
+    std::vector<YoloCandidate> actual;
+    decodeYoloOutput(tensor.data(), layout, params, actual);
+    bool ok = sameCandidates(actual, referenceDecode(candidates, has_objectness, params));
+    if (!ok) {
+        std::fprintf(stderr, "  %s%s, %d classes, N=%d%s\n", channel_major ? "[1,C,N]" : "[1,N,C]",
+                     has_objectness ? " with objectness" : "", num_classes, n,
+                     person_only ? ", person only" : "");
+    }
+    CHECK(ok);
+}
+
+void testBatchIndex(std::mt19937& rng) {
+    // Two items back to back; item 1 must decode from its own slice
+    const int n = 13;
+    YoloDecodeParams params;
+    std::vector<Synthetic> first = makeCandidates(n, 80, params.confidence_threshold, rng);
+    std::vector<Synthetic> second = makeCandidates(n, 80, params.confidence_threshold, rng);
+    std::vector<float> tensor = packChannelMajor(first, false);
+    std::vector<float> tail = packChannelMajor(second, false);
+    tensor.insert(tensor.end(), tail.begin(), tail.end());
+
+    YoloOutputLayout layout;
+    CHECK(inferYoloLayout({2, 84, n}, 80, layout));
+    std::vector<YoloCandidate> actual;
+    decodeYoloOutput(tensor.data(), layout, params, actual, 1);
+    CHECK(sameCandidates(actual, referenceDecode(second, false, params)));
+
+    actual.clear();
+    decodeYoloOutput(tensor.data(), layout, params, actual, 2);  // out of range
+    CHECK(actual.empty());
+}
+
+} // namespace
+
+int main() {
+    testLayoutInference();
+
+    std::mt19937 rng(12345);
+
+    YoloDecodeParams identity;
+    // A 1280x720 frame letterboxed into 640x640: scale 0.5, 140 px bars top
+    // and bottom. Candidates reach outside the frame, so clamping matters.
+    YoloDecodeParams letterbox;
+    letterbox.scale_x = 0.5f;
+    letterbox.scale_y = 0.5f;
+    letterbox.pad_y = 140.0f;
+    letterbox.frame_width = 1280;
+    letterbox.frame_height = 720;
+    letterbox.confidence_threshold = 0.25f;
+
+    // Around every SIMD width in use (4 for SSE2/NEON, 8 for AVX)
+    const int counts[] = {1, 3, 4, 5, 7, 8, 9, 13, 16, 17, 31, 100, 257};
+    for (const YoloDecodeParams& params : {identity, letterbox}) {
+        for (int n : counts) {
+            for (bool person_only : {false, true}) {
+                testDecode(true, false, 80, n, person_only, params, rng);   // v8 [1,84,N]
+                testDecode(false, true, 80, n, person_only, params, rng);   // v5 [1,N,85]
+                testDecode(false, false, 80, n, person_only, params, rng);  // row-major without objectness
+                testDecode(true, true, 80, n, person_only, params, rng);    // channel-major with objectness
+                // Class counts below and off the SIMD width for the row argmax
+                testDecode(false, true, 3, n, person_only, params, rng);
+                testDecode(false, true, 13, n, person_only, params, rng);
+                testDecode(true, false, 13, n, person_only, params, rng);
+            }
+        }
+    }
+    testBatchIndex(rng);
+
+    if (g_failures) {
+        std::fprintf(stderr, "%d check(s) failed\n", g_failures);
+        return 1;
+    }
+    std::printf("yolo_decoder_test: all checks passed (SIMD width %d)\n", simd::kWidth);
+    return 0;
+}